@@ -0,0 +1,113 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/arena.h"
+#include "../src/parse.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+#include "../src/tree.h"
+
+#define BENCH_PASSES 5
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Parse a source, either into a syntax tree or only checking it, and record
+ * the number of blocks the arena took.
+ */
+static double bench_parse(struct ink_source *source, int check,
+                          size_t *blocks)
+{
+    struct timespec start, end;
+    struct ink_arena arena;
+    struct ink_syntax_tree tree;
+
+    ink_arena_initialize(&arena, 8192, 8);
+    ink_syntax_tree_initialize(source, &tree);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (check) {
+        ink_parse_events(&arena, source, 0, NULL);
+    } else {
+        ink_parse(&arena, source, &tree, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *blocks = arena.total_blocks;
+    ink_syntax_tree_cleanup(&tree);
+    ink_arena_release(&arena);
+    return bench_elapsed(&start, &end);
+}
+
+/**
+ * Report the time taken and the peak resident memory of a full parse, or of
+ * a check that reports the tree to nothing, along with the number of blocks
+ * taken by the arena. Each is run in a process of its own, so that the peak
+ * of one does not hide that of the other.
+ *
+ * Diagnostics are sent to /dev/null while parsing.
+ */
+int main(int argc, char *argv[])
+{
+    int null_fd, stdout_fd;
+    struct ink_source source;
+    struct rusage usage;
+    size_t blocks = 0;
+    double best = 0.0;
+    int check;
+
+    if (argc != 3 ||
+        (strcmp(argv[1], "tree") != 0 && strcmp(argv[1], "check") != 0)) {
+        fprintf(stderr, "Usage: %s tree|check FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    check = strcmp(argv[1], "check") == 0;
+    ink_simd_initialize();
+
+    if (ink_source_load(argv[2], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    null_fd = open("/dev/null", O_WRONLY);
+    stdout_fd = dup(STDOUT_FILENO);
+    if (null_fd < 0 || stdout_fd < 0) {
+        fprintf(stderr, "Could not redirect STDOUT.\n");
+        return EXIT_FAILURE;
+    }
+
+    dup2(null_fd, STDOUT_FILENO);
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        const double elapsed = bench_parse(&source, check, &blocks);
+
+        if (best == 0.0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    fflush(stdout);
+    dup2(stdout_fd, STDOUT_FILENO);
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("%-6s %10.6f s %8.1f MB/s, %6zu arena blocks, peak RSS %8ld KB\n",
+           argv[1], best, (double)source.length / 1e6 / best, blocks,
+           usage.ru_maxrss);
+
+    ink_source_free(&source);
+    close(null_fd);
+    close(stdout_fd);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/arena.h"
+#include "../src/parse.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+#include "../src/tree.h"
+
+#define BENCH_PASSES 10
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static double bench_parse(struct ink_source *source, int flags)
+{
+    struct timespec start, end;
+    struct ink_arena arena;
+    struct ink_syntax_tree tree;
+
+    ink_arena_initialize(&arena, 8192, 8);
+    ink_syntax_tree_initialize(source, &tree);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ink_parse(&arena, source, &tree, flags);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    ink_syntax_tree_cleanup(&tree);
+    ink_arena_release(&arena);
+    return bench_elapsed(&start, &end);
+}
+
+/**
+ * Report parsing throughput on a story made up of expressions, with and
+ * without caching.
+ */
+int main(int argc, char *argv[])
+{
+    struct ink_source source;
+    double best[2] = {0.0, 0.0};
+    static const int flags[] = {0, INK_PARSER_F_CACHING};
+    static const char *labels[] = {"parse", "caching"};
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ink_simd_initialize();
+
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (int i = 0; i < 2; i++) {
+            const double elapsed = bench_parse(&source, flags[i]);
+
+            if (best[i] == 0.0 || elapsed < best[i]) {
+                best[i] = elapsed;
+            }
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        printf("%-8s %10.6f s %10.1f MB/s\n", labels[i], best[i],
+               (double)source.length / 1e6 / best[i]);
+    }
+
+    ink_source_free(&source);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,44 @@
+#!/bin/sh
+# Report parsing throughput on generated expressions: 5,000-term sums,
+# arithmetic across every level of precedence, and deeply nested
+# parentheses.
+set -e
+
+BENCH=${BENCH:-dist/bench/expr}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+chain() {
+    awk 'BEGIN {
+        for (line = 0; line < 100; line++) {
+            printf "~ lit = ";
+            for (i = 0; i < 4999; i++) printf "visited_%d + ", i;
+            print "visited_4999";
+        }
+    }'
+}
+
+arith() {
+    awk 'BEGIN {
+        for (i = 0; i < 100000; i++) {
+            printf "~ lamps = (lamps + (heavy + %d) * 3) - tired / 2 %% 7", i;
+            printf " == -x * !y >= %d\n", i;
+        }
+    }'
+}
+
+nested() {
+    printf '~ depth = '
+    awk 'BEGIN {
+        for (i = 0; i < 100000; i++) printf "(";
+        printf "x";
+        for (i = 0; i < 100000; i++) printf " + 1)";
+        print "";
+    }'
+}
+
+for input in chain arith nested; do
+    "$input" >"$TMP/$input.ink"
+    echo "$input:"
+    "$BENCH" "$TMP/$input.ink"
+done
@@ -0,0 +1,167 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/arena.h"
+#include "../src/parse.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+#include "../src/tree.h"
+
+#define BENCH_PASSES 10
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static bool bench_node_equal(const struct ink_syntax_node *a,
+                             const struct ink_syntax_node *b)
+{
+    if (a == NULL || b == NULL) {
+        return a == b;
+    }
+    if (a->type != b->type || a->start_offset != b->start_offset ||
+        a->end_offset != b->end_offset || !bench_node_equal(a->lhs, b->lhs) ||
+        !bench_node_equal(a->rhs, b->rhs)) {
+        return false;
+    }
+    if (a->seq == NULL || b->seq == NULL) {
+        return a->seq == b->seq;
+    }
+    if (a->seq->count != b->seq->count) {
+        return false;
+    }
+    for (size_t i = 0; i < a->seq->count; i++) {
+        if (!bench_node_equal(a->seq->nodes[i], b->seq->nodes[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Save a copy of a source with a single character added to the end of the
+ * line halfway through it.
+ */
+static int bench_edit(const struct ink_source *source, const char *filename,
+                      struct ink_parse_edit *edit)
+{
+    FILE *file;
+    size_t offset = source->length / 2;
+
+    while (offset < source->length && source->bytes[offset] != '\n') {
+        offset++;
+    }
+
+    file = fopen(filename, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+
+    fwrite(source->bytes, 1, offset, file);
+    fputc('s', file);
+    fwrite(source->bytes + offset, 1, source->length - offset, file);
+    fclose(file);
+
+    edit->start_offset = offset;
+    edit->old_length = 0;
+    edit->new_length = 1;
+    return 0;
+}
+
+/**
+ * Report the time taken to parse a story again after a single character
+ * is added to it, incrementally and in full, after checking that both
+ * produce the same syntax tree.
+ *
+ * Usage: incremental FILE SCRATCH_FILE, where the edited story is saved to
+ * SCRATCH_FILE.
+ */
+int main(int argc, char *argv[])
+{
+    struct ink_source source, edited;
+    struct ink_parse_edit edit;
+    struct ink_arena expected_arena;
+    struct ink_syntax_tree expected;
+    double best_full = 0.0, best_incremental = 0.0;
+    bool ok = true;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s FILE SCRATCH_FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ink_simd_initialize();
+
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    if (bench_edit(&source, argv[2], &edit) < 0 ||
+        ink_source_load(argv[2], &edited) < 0) {
+        fprintf(stderr, "Could not save %s.\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    ink_arena_initialize(&expected_arena, 8192, 8);
+    ink_syntax_tree_initialize(&edited, &expected);
+    ink_parse(&expected_arena, &edited, &expected, 0);
+
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        struct timespec start, end;
+        struct ink_arena arena;
+        struct ink_syntax_tree tree;
+        double elapsed;
+
+        ink_arena_initialize(&arena, 8192, 8);
+        ink_syntax_tree_initialize(&edited, &tree);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ink_parse(&arena, &edited, &tree, 0);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        elapsed = bench_elapsed(&start, &end);
+        if (best_full == 0.0 || elapsed < best_full) {
+            best_full = elapsed;
+        }
+
+        ink_arena_release(&arena);
+        ink_arena_initialize(&arena, 8192, 8);
+        ink_syntax_tree_initialize(&source, &tree);
+        ink_parse(&arena, &source, &tree, 0);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ink_parse_incremental(&arena, &edited, &tree, 0, &edit, 1);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        elapsed = bench_elapsed(&start, &end);
+        if (best_incremental == 0.0 || elapsed < best_incremental) {
+            best_incremental = elapsed;
+        }
+        if (!bench_node_equal(expected.root, tree.root)) {
+            ok = false;
+        }
+
+        ink_syntax_tree_cleanup(&tree);
+        ink_arena_release(&arena);
+    }
+    if (!ok) {
+        fprintf(stderr, "Syntax tree differs from a full parse\n");
+    }
+
+    printf("full        %10.6f s\n", best_full);
+    printf("incremental %10.6f s %8.1fx\n", best_incremental,
+           best_full / best_incremental);
+
+    ink_syntax_tree_cleanup(&expected);
+    ink_arena_release(&expected_arena);
+    ink_source_free(&edited);
+    ink_source_free(&source);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
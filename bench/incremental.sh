@@ -0,0 +1,38 @@
+#!/bin/sh
+# Report the time taken to parse a 10 MB story again after a single
+# character is added to it, incrementally and in full.
+set -e
+
+BENCH=${BENCH:-dist/bench/incremental}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/stitch.passage" <<'INK'
+The lamplighter had lit {lamps} lamps by the time {name} reached the corner.
+{visited_corner: She nodded to the watchman.|She did not know the watchman yet.}
+*   {visited_corner} "It is getting late," she said.
+    -> corner_conversation
+*   [Walk on]
+    She walked the length of Fairweather Street with her ladder.
+    * *   [Count the houses] There were more of them than she remembered.
+    * *   [Keep walking]
+    - -   The rain had not stopped for three days.
+-   Her ladder felt heavier than usual tonight.
+~ lamps = (lamps + (heavy + 1) * 3) - tired
+INK
+
+i=0
+while [ $i -lt 8 ]; do
+    echo "= stretch_$i"
+    cat "$TMP/stitch.passage"
+    i=$((i + 1))
+done >"$TMP/knot.passage"
+
+k=0
+while [ $k -lt 2200 ]; do
+    echo "=== street_$k ==="
+    cat "$TMP/knot.passage"
+    k=$((k + 1))
+done >"$TMP/story.ink"
+
+"$BENCH" "$TMP/story.ink" "$TMP/edited.ink"
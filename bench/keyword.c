@@ -0,0 +1,230 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/scanner.h"
+#include "../src/source.h"
+#include "../src/token.h"
+
+#define BENCH_PASSES 20
+
+/*
+ * The keywords that `ink_parse_stmt` tries against the first word of every
+ * statement.
+ */
+static const enum ink_token_type bench_keywords[] = {
+    INK_TT_KEYWORD_CONST,
+    INK_TT_KEYWORD_VAR,
+    INK_TT_KEYWORD_LIST,
+};
+
+#define BENCH_KEYWORD_COUNT (sizeof(bench_keywords) / sizeof(bench_keywords[0]))
+
+/**
+ * Classify a word by switching on its length and comparing it against
+ * every keyword of that length, as the scanner used to.
+ */
+static enum ink_token_type bench_keyword_memcmp(const unsigned char *lexeme,
+                                                size_t length,
+                                                enum ink_token_type type)
+{
+    switch (length) {
+    case 2:
+        if (memcmp(lexeme, "or", length) == 0) {
+            type = INK_TT_KEYWORD_OR;
+        }
+        break;
+    case 3:
+        if (memcmp(lexeme, "and", length) == 0) {
+            type = INK_TT_KEYWORD_AND;
+        } else if (memcmp(lexeme, "mod", length) == 0) {
+            type = INK_TT_KEYWORD_MOD;
+        } else if (memcmp(lexeme, "not", length) == 0) {
+            type = INK_TT_KEYWORD_NOT;
+        } else if (memcmp(lexeme, "ref", length) == 0) {
+            type = INK_TT_KEYWORD_REF;
+        } else if (memcmp(lexeme, "VAR", length) == 0) {
+            type = INK_TT_KEYWORD_VAR;
+        }
+        break;
+    case 4:
+        if (memcmp(lexeme, "temp", length) == 0) {
+            type = INK_TT_KEYWORD_TEMP;
+        } else if (memcmp(lexeme, "true", length) == 0) {
+            type = INK_TT_KEYWORD_TRUE;
+        } else if (memcmp(lexeme, "LIST", length) == 0) {
+            type = INK_TT_KEYWORD_LIST;
+        }
+        break;
+    case 5:
+        if (memcmp(lexeme, "false", length) == 0) {
+            type = INK_TT_KEYWORD_FALSE;
+        } else if (memcmp(lexeme, "CONST", length) == 0) {
+            type = INK_TT_KEYWORD_CONST;
+        }
+        break;
+    case 6:
+        if (memcmp(lexeme, "return", length) == 0) {
+            type = INK_TT_KEYWORD_RETURN;
+        }
+        break;
+    case 8:
+        if (memcmp(lexeme, "function", length) == 0) {
+            type = INK_TT_KEYWORD_FUNCTION;
+        }
+        break;
+    default:
+        break;
+    }
+    return type;
+}
+
+/*
+ * Called through a pointer so that, as with the scanner, every attempt pays
+ * for a call and the classification cannot be hoisted out of the loop.
+ */
+static enum ink_token_type (*volatile bench_classify)(
+    const unsigned char *, size_t, enum ink_token_type) = bench_keyword_memcmp;
+
+/**
+ * Try every statement keyword against every word, re-classifying the word
+ * for each attempt.
+ */
+static size_t bench_memcmp(struct ink_source *source, struct ink_token *tokens,
+                           size_t count)
+{
+    size_t matches = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const unsigned char *lexeme = source->bytes + tokens[i].start_offset;
+        const size_t length = tokens[i].end_offset - tokens[i].start_offset;
+
+        for (size_t j = 0; j < BENCH_KEYWORD_COUNT; j++) {
+            if (bench_classify(lexeme, length, tokens[i].type) ==
+                bench_keywords[j]) {
+                matches++;
+                break;
+            }
+        }
+    }
+    return matches;
+}
+
+/**
+ * Try every statement keyword against every word through
+ * `ink_scanner_try_keyword`.
+ *
+ * If `cached` is false, the token's cached keyword class is discarded
+ * before every attempt, so each one hashes the word again.
+ */
+static size_t bench_hash(struct ink_scanner *scanner, struct ink_token *tokens,
+                         size_t count, bool cached)
+{
+    size_t matches = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        struct ink_token token = tokens[i];
+
+        for (size_t j = 0; j < BENCH_KEYWORD_COUNT; j++) {
+            if (!cached) {
+                token.keyword = INK_TT_EOF;
+            }
+            if (ink_scanner_try_keyword(scanner, &token, bench_keywords[j])) {
+                matches++;
+                break;
+            }
+        }
+    }
+    return matches;
+}
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Report the time taken per word to recognize statement keywords, using the
+ * old length switch, the perfect hash and the perfect hash with the keyword
+ * class cached on the token.
+ */
+int main(int argc, char *argv[])
+{
+    struct ink_source source;
+    struct ink_scanner scanner;
+    struct ink_token token;
+    struct ink_token *tokens = NULL;
+    size_t count = 0, capacity = 0;
+    size_t expected = 0;
+    double best[3] = {0.0, 0.0, 0.0};
+    static const char *labels[] = {"memcmp", "hash", "cached"};
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    ink_scanner_initialize(&scanner, &source, 0, true);
+
+    do {
+        ink_scanner_next(&scanner, &token);
+        if (token.type != INK_TT_STRING) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            tokens = realloc(tokens, capacity * sizeof(*tokens));
+            if (!tokens) {
+                fprintf(stderr, "Out of memory.\n");
+                return EXIT_FAILURE;
+            }
+        }
+        tokens[count++] = token;
+    } while (token.type != INK_TT_EOF);
+
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (int i = 0; i < 3; i++) {
+            struct timespec start, end;
+            size_t matches;
+            double elapsed;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            matches = i == 0 ? bench_memcmp(&source, tokens, count)
+                             : bench_hash(&scanner, tokens, count, i == 2);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            if (pass == 0 && i == 0) {
+                expected = matches;
+            } else if (matches != expected) {
+                fprintf(stderr, "%s found %zu keywords, expected %zu.\n",
+                        labels[i], matches, expected);
+                return EXIT_FAILURE;
+            }
+
+            elapsed = bench_elapsed(&start, &end);
+            if (best[i] == 0.0 || elapsed < best[i]) {
+                best[i] = elapsed;
+            }
+        }
+    }
+
+    printf("%zu words, %zu keywords\n", count, expected);
+    for (int i = 0; i < 3; i++) {
+        printf("%-8s %8.2f ns/word\n", labels[i],
+               best[i] * 1e9 / (double)count);
+    }
+
+    free(tokens);
+    ink_source_free(&source);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Report the cost of recognizing statement keywords on a declaration-heavy
+# story, where most lines begin with a keyword, and on a prose-heavy one,
+# where almost none do.
+set -e
+
+BENCH=${BENCH:-dist/bench/keyword}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/keywords.passage" <<'INK'
+VAR gold = 10
+CONST max_gold = 100
+LIST moods = happy, sad, angry
+VAR visited_market = false
+CONST market_name = "Fairweather"
+LIST items = lamp, ladder, oil
+INK
+
+cat >"$TMP/prose.passage" <<'INK'
+The rain had not stopped for three days, and the lamplighter was tired.
+She walked the length of Fairweather Street with her ladder on her shoulder
+and counted the houses whose windows were still dark at this hour.
+INK
+
+for input in keywords prose; do
+    i=0
+    while [ $i -lt 20000 ]; do
+        cat "$TMP/$input.passage"
+        i=$((i + 1))
+    done >"$TMP/$input.ink"
+
+    echo "$input:"
+    "$BENCH" "$TMP/$input.ink"
+done
@@ -0,0 +1,147 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/arena.h"
+#include "../src/parse.h"
+#include "../src/platform.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+#include "../src/tree.h"
+
+#define BENCH_PASSES 10
+#define BENCH_JOBS_MAX 16
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static bool bench_node_equal(const struct ink_syntax_node *a,
+                             const struct ink_syntax_node *b)
+{
+    if (a == NULL || b == NULL) {
+        return a == b;
+    }
+    if (a->type != b->type || a->start_offset != b->start_offset ||
+        a->end_offset != b->end_offset || !bench_node_equal(a->lhs, b->lhs) ||
+        !bench_node_equal(a->rhs, b->rhs)) {
+        return false;
+    }
+    if (a->seq == NULL || b->seq == NULL) {
+        return a->seq == b->seq;
+    }
+    if (a->seq->count != b->seq->count) {
+        return false;
+    }
+    for (size_t i = 0; i < a->seq->count; i++) {
+        if (!bench_node_equal(a->seq->nodes[i], b->seq->nodes[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Parse a story with up to `jobs` workers, or serially if `jobs` is zero,
+ * checking the syntax tree against `expected` unless it is NULL.
+ */
+static double bench_parse(struct ink_source *source, size_t jobs,
+                          const struct ink_syntax_tree *expected, bool *ok)
+{
+    struct timespec start, end;
+    struct ink_arena arena;
+    struct ink_syntax_tree tree;
+
+    ink_arena_initialize(&arena, 8192, 8);
+    ink_syntax_tree_initialize(source, &tree);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (jobs == 0) {
+        ink_parse(&arena, source, &tree, 0);
+    } else {
+        ink_parse_parallel(&arena, source, &tree, 0, jobs);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (expected && !bench_node_equal(expected->root, tree.root)) {
+        *ok = false;
+    }
+
+    ink_syntax_tree_cleanup(&tree);
+    ink_arena_release(&arena);
+    return bench_elapsed(&start, &end);
+}
+
+/**
+ * Report parsing throughput when the knots of a story are split between 1,
+ * 2, 4, 8 and 16 workers, against a serial parse, after checking that each
+ * produces the same syntax tree.
+ *
+ * Speedups beyond the number of processors available are not expected.
+ */
+int main(int argc, char *argv[])
+{
+    struct ink_source source;
+    struct ink_arena arena;
+    struct ink_syntax_tree expected;
+    double serial = 0.0;
+    int status = EXIT_SUCCESS;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ink_simd_initialize();
+
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    ink_arena_initialize(&arena, 8192, 8);
+    ink_syntax_tree_initialize(&source, &expected);
+    ink_parse(&arena, &source, &expected, 0);
+
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        const double elapsed = bench_parse(&source, 0, NULL, NULL);
+
+        if (serial == 0.0 || elapsed < serial) {
+            serial = elapsed;
+        }
+    }
+
+    printf("serial %10.6f s %10.1f MB/s (%zu processors)\n", serial,
+           (double)source.length / 1e6 / serial, platform_cpu_count());
+
+    for (size_t jobs = 1; jobs <= BENCH_JOBS_MAX; jobs *= 2) {
+        double best = 0.0;
+        bool ok = true;
+
+        for (int pass = 0; pass < BENCH_PASSES; pass++) {
+            const double elapsed = bench_parse(&source, jobs, &expected, &ok);
+
+            if (best == 0.0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        if (!ok) {
+            fprintf(stderr, "Syntax tree differs with %zu jobs\n", jobs);
+            status = EXIT_FAILURE;
+        }
+
+        printf("jobs %2zu %10.6f s %10.1f MB/s %6.2fx\n", jobs, best,
+               (double)source.length / 1e6 / best, serial / best);
+    }
+
+    ink_syntax_tree_cleanup(&expected);
+    ink_arena_release(&arena);
+    ink_source_free(&source);
+    return status;
+}
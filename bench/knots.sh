@@ -0,0 +1,36 @@
+#!/bin/sh
+# Report parsing throughput with the knots of a 500-knot story split between
+# workers, against a serial parse.
+set -e
+
+BENCH=${BENCH:-dist/bench/knots}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/knot.passage" <<'INK'
+The lamplighter had lit {lamps} lamps by the time {name} reached the corner.
+{visited_corner: She nodded to the watchman.|She did not know the watchman yet.}
+*   {visited_corner} "It is getting late," she said.
+    -> corner_conversation
+*   [Walk on]
+    She walked the length of Fairweather Street with her ladder.
+    * *   [Count the houses] There were more of them than she remembered.
+    * *   [Keep walking]
+    - -   The rain had not stopped for three days.
+-   Her ladder felt heavier than usual tonight.
+~ lamps = (lamps + (heavy + 1) * 3) - tired
+INK
+
+k=0
+while [ $k -lt 500 ]; do
+    echo "=== street_$k ==="
+    i=0
+    while [ $i -lt 8 ]; do
+        echo "= stretch_$i"
+        cat "$TMP/knot.passage"
+        i=$((i + 1))
+    done
+    k=$((k + 1))
+done >"$TMP/story.ink"
+
+"$BENCH" "$TMP/story.ink"
@@ -0,0 +1,200 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/arena.h"
+#include "../src/parse.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+#include "../src/tree.h"
+#include "../src/vec.h"
+
+#define BENCH_PASSES 3
+
+INK_VEC_DECLARE(bench_nodes, struct ink_syntax_node *)
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static bool bench_node_equal(const struct ink_syntax_node *a,
+                             const struct ink_syntax_node *b)
+{
+    if (a == NULL || b == NULL) {
+        return a == b;
+    }
+    if (a->type != b->type || a->start_offset != b->start_offset ||
+        a->end_offset != b->end_offset || !bench_node_equal(a->lhs, b->lhs) ||
+        !bench_node_equal(a->rhs, b->rhs)) {
+        return false;
+    }
+    if (a->seq == NULL || b->seq == NULL) {
+        return a->seq == b->seq;
+    }
+    if (a->seq->count != b->seq->count) {
+        return false;
+    }
+    for (size_t i = 0; i < a->seq->count; i++) {
+        if (!bench_node_equal(a->seq->nodes[i], b->seq->nodes[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool bench_is_decl(const struct ink_syntax_node *node)
+{
+    switch (node->type) {
+    case INK_NODE_KNOT_DECL:
+    case INK_NODE_FUNCTION_DECL:
+    case INK_NODE_VAR_DECL:
+    case INK_NODE_CONST_DECL:
+    case INK_NODE_LIST_DECL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+ * Collect the declarations at the top level of a file, including those
+ * indexed by its lazy blocks.
+ */
+static void bench_index(const struct ink_syntax_tree *tree,
+                        struct bench_nodes *index)
+{
+    const struct ink_syntax_seq *stmts = tree->root->seq->nodes[0]->seq;
+
+    for (size_t i = 0; stmts && i < stmts->count; i++) {
+        struct ink_syntax_node *node = stmts->nodes[i];
+
+        if (node->type == INK_NODE_LAZY_BLOCK_STMT) {
+            for (size_t j = 0; node->seq && j < node->seq->count; j++) {
+                bench_nodes_append(index, node->seq->nodes[j]);
+            }
+        } else if (bench_is_decl(node)) {
+            bench_nodes_append(index, node);
+        }
+    }
+}
+
+static double bench_parse(struct ink_source *source, int flags,
+                          struct ink_arena *arena,
+                          struct ink_syntax_tree *tree)
+{
+    struct timespec start, end;
+
+    ink_arena_initialize(arena, 8192, 8);
+    ink_syntax_tree_initialize(source, tree);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ink_parse(arena, source, tree, flags);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return bench_elapsed(&start, &end);
+}
+
+/**
+ * Report the time taken to index the knots, stitches, functions and global
+ * declarations of a story with a lazy parse, against a full parse, and the
+ * time taken to parse one of the lazy blocks on first access.
+ *
+ * The index is checked against the declarations found by the full parse.
+ */
+int main(int argc, char *argv[])
+{
+    struct ink_source source;
+    struct bench_nodes expected, actual;
+    double best_full = 0.0, best_lazy = 0.0, best_body = 0.0;
+    bool ok = true;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ink_simd_initialize();
+
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    bench_nodes_create(&expected);
+    bench_nodes_create(&actual);
+
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        struct timespec start, end;
+        struct ink_arena full_arena, lazy_arena;
+        struct ink_syntax_tree full, lazy;
+        const struct ink_syntax_seq *stmts;
+        double elapsed;
+
+        elapsed = bench_parse(&source, 0, &full_arena, &full);
+        if (best_full == 0.0 || elapsed < best_full) {
+            best_full = elapsed;
+        }
+
+        elapsed =
+            bench_parse(&source, INK_PARSER_F_LAZY, &lazy_arena, &lazy);
+        if (best_lazy == 0.0 || elapsed < best_lazy) {
+            best_lazy = elapsed;
+        }
+
+        bench_nodes_shrink(&expected, 0);
+        bench_nodes_shrink(&actual, 0);
+        bench_index(&full, &expected);
+        bench_index(&lazy, &actual);
+
+        if (expected.count != actual.count) {
+            ok = false;
+        }
+        for (size_t i = 0; ok && i < expected.count; i++) {
+            if (!bench_node_equal(expected.entries[i], actual.entries[i])) {
+                ok = false;
+            }
+        }
+
+        stmts = lazy.root->seq->nodes[0]->seq;
+        for (size_t i = stmts->count / 2; i < stmts->count; i++) {
+            if (stmts->nodes[i]->type == INK_NODE_LAZY_BLOCK_STMT) {
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                if (ink_syntax_tree_body(&lazy, stmts->nodes[i]) < 0) {
+                    ok = false;
+                }
+                clock_gettime(CLOCK_MONOTONIC, &end);
+
+                elapsed = bench_elapsed(&start, &end);
+                if (best_body == 0.0 || elapsed < best_body) {
+                    best_body = elapsed;
+                }
+                break;
+            }
+        }
+
+        ink_syntax_tree_cleanup(&lazy);
+        ink_arena_release(&lazy_arena);
+        ink_syntax_tree_cleanup(&full);
+        ink_arena_release(&full_arena);
+    }
+    if (!ok) {
+        fprintf(stderr, "Index differs from a full parse\n");
+    }
+
+    printf("declarations %zu\n", expected.count);
+    printf("full  %10.6f s %10.1f MB/s\n", best_full,
+           (double)source.length / 1e6 / best_full);
+    printf("lazy  %10.6f s %10.1f MB/s %8.1fx\n", best_lazy,
+           (double)source.length / 1e6 / best_lazy, best_full / best_lazy);
+    printf("block %10.6f s\n", best_body);
+
+    bench_nodes_destroy(&actual);
+    bench_nodes_destroy(&expected);
+    ink_source_free(&source);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,46 @@
+#!/bin/sh
+# Report the time taken to index the knots and global declarations of a
+# 100 MB story with a lazy parse, against a full parse.
+set -e
+
+BENCH=${BENCH:-dist/bench/lazy}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/stitch.passage" <<'INK'
+The lamplighter had lit {lamps} lamps by the time {name} reached the corner.
+{visited_corner: She nodded to the watchman.|She did not know the watchman yet.}
+*   {visited_corner} "It is getting late," she said.
+    -> corner_conversation
+*   [Walk on]
+    She walked the length of Fairweather Street with her ladder.
+    * *   [Count the houses] There were more of them than she remembered.
+    * *   [Keep walking]
+    - -   The rain had not stopped for three days.
+-   Her ladder felt heavier than usual tonight.
+~ lamps = (lamps + (heavy + 1) * 3) - tired
+INK
+
+i=0
+while [ $i -lt 8 ]; do
+    echo "= stretch_$i"
+    cat "$TMP/stitch.passage"
+    i=$((i + 1))
+done >"$TMP/knot.passage"
+
+k=0
+while [ $k -lt 24 ]; do
+    echo "=== street_$k ==="
+    echo "VAR lit_$k = 0"
+    cat "$TMP/knot.passage"
+    k=$((k + 1))
+done >"$TMP/story.ink"
+
+# Double the story until it reaches 100 MB. The parser does not mind that
+# the names of its knots repeat.
+while [ "$(wc -c <"$TMP/story.ink")" -lt 100000000 ]; do
+    cat "$TMP/story.ink" "$TMP/story.ink" >"$TMP/copy.ink"
+    mv "$TMP/copy.ink" "$TMP/story.ink"
+done
+
+"$BENCH" "$TMP/story.ink"
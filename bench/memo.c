@@ -0,0 +1,118 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/arena.h"
+#include "../src/parse.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+#include "../src/tree.h"
+
+#define BENCH_PASSES 10
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static double bench_parse(struct ink_source *source, int flags,
+                          struct ink_parse_stats *stats)
+{
+    struct timespec start, end;
+    struct ink_arena arena;
+    struct ink_syntax_tree tree;
+
+    ink_arena_initialize(&arena, 8192, 8);
+    ink_syntax_tree_initialize(source, &tree);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ink_parse_with_stats(&arena, source, &tree, flags, stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    ink_syntax_tree_cleanup(&tree);
+    ink_arena_release(&arena);
+    return bench_elapsed(&start, &end);
+}
+
+/**
+ * Report the hit rate and memory of the parser's memoization table, along
+ * with parsing throughput with and without memoization.
+ *
+ * The table is limited to LIMIT bytes if given, and to the default limit
+ * otherwise.
+ *
+ * Diagnostics and traces are sent to /dev/null while parsing. Build with
+ * INK_PARSER_HASHED_CACHE defined to measure the original byte-wise hashed
+ * table instead of the packed one.
+ */
+int main(int argc, char *argv[])
+{
+    int null_fd, stdout_fd;
+    struct ink_source source;
+    struct ink_parse_stats stats;
+    double best[2] = {0.0, 0.0};
+    double megabytes;
+    static const int flags[] = {0, INK_PARSER_F_CACHING};
+    static const char *labels[] = {"plain", "caching"};
+
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "Usage: %s FILE [LIMIT]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc == 3) {
+        ink_parse_set_cache_limit((size_t)strtoull(argv[2], NULL, 10));
+    }
+
+    ink_simd_initialize();
+
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    null_fd = open("/dev/null", O_WRONLY);
+    stdout_fd = dup(STDOUT_FILENO);
+    if (null_fd < 0 || stdout_fd < 0) {
+        fprintf(stderr, "Could not redirect STDOUT.\n");
+        return EXIT_FAILURE;
+    }
+
+    dup2(null_fd, STDOUT_FILENO);
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (int i = 0; i < 2; i++) {
+            const double elapsed = bench_parse(&source, flags[i], &stats);
+
+            if (best[i] == 0.0 || elapsed < best[i]) {
+                best[i] = elapsed;
+            }
+        }
+    }
+
+    fflush(stdout);
+    dup2(stdout_fd, STDOUT_FILENO);
+
+    megabytes = (double)source.length / 1e6;
+    printf("memo %zu lookups, %.1f%% hits, %zu entries, %zu evicted, "
+           "%.0f bytes/MB\n",
+           stats.memo_lookups,
+           stats.memo_lookups
+               ? 100.0 * (double)stats.memo_hits / (double)stats.memo_lookups
+               : 0.0,
+           stats.memo_entries, stats.memo_evicted,
+           (double)stats.memo_bytes / megabytes);
+    for (int i = 0; i < 2; i++) {
+        printf("%-8s %10.6f s %10.1f MB/s\n", labels[i], best[i],
+               megabytes / best[i]);
+    }
+
+    close(null_fd);
+    close(stdout_fd);
+    ink_source_free(&source);
+    return EXIT_SUCCESS;
+}
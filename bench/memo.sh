@@ -0,0 +1,37 @@
+#!/bin/sh
+# Report the parser's memoization hit rate and memory, along with parsing
+# throughput with and without it, on a story that relies heavily on inline
+# logic and on a prose-heavy one. Build the benchmarks with
+# `make bench CPPFLAGS=-DINK_PARSER_HASHED_CACHE` to compare against the
+# byte-wise hashed table. Set LIMIT to bound the table to that many bytes.
+set -e
+
+BENCH=${BENCH:-dist/bench/memo}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/logic.passage" <<'INK'
+The lamplighter had lit {lamps} lamps by the time {name} reached the corner.
+{visited_corner: She nodded to the watchman.|She did not know the watchman yet.}
+*   {visited_corner} "It is getting late," she said.
+    -> corner_conversation
+Her ladder felt {heavy && tired: heavier than usual|light enough} tonight.
+~ lamps = (lamps + (heavy + 1) * 3) - tired
+INK
+
+cat >"$TMP/prose.passage" <<'INK'
+The rain had not stopped for three days, and the lamplighter was tired.
+She walked the length of Fairweather Street with her ladder on her shoulder
+and counted the houses whose windows were still dark at this hour.
+INK
+
+for input in logic prose; do
+    i=0
+    while [ $i -lt 20000 ]; do
+        cat "$TMP/$input.passage"
+        i=$((i + 1))
+    done >"$TMP/$input.ink"
+
+    echo "$input:"
+    "$BENCH" "$TMP/$input.ink" ${LIMIT:+"$LIMIT"}
+done
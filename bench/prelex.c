@@ -0,0 +1,169 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/arena.h"
+#include "../src/parse.h"
+#include "../src/platform.h"
+#include "../src/scanner.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+#include "../src/token.h"
+#include "../src/tree.h"
+
+#define BENCH_PASSES 10
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Check pre-lexed tokens against lexing the source from the start.
+ *
+ * Every pre-lexed token must be the token lexed from its offset, and every
+ * token lexed from the start of the source but the first must have been
+ * pre-lexed.
+ */
+static bool bench_compare(struct ink_source *source,
+                          struct ink_token_buffer *buffer)
+{
+    struct ink_scanner scanner;
+    struct ink_token token;
+    struct ink_token_lane *lane = &buffer->lanes[INK_GRAMMAR_CONTENT];
+    size_t missing = 0;
+
+    for (size_t i = 0; i < lane->count; i++) {
+        ink_scanner_initialize(&scanner, source, lane->offsets[i], false);
+        ink_scanner_next(&scanner, &token);
+
+        if (token.type != lane->types[i] ||
+            token.start_offset != lane->starts[i] ||
+            token.end_offset != lane->starts[i] + lane->lengths[i]) {
+            fprintf(stderr, "Wrong token pre-lexed from %zu\n",
+                    (size_t)lane->offsets[i]);
+            return false;
+        }
+    }
+
+    lane->position = 0;
+    ink_scanner_initialize(&scanner, source, 0, true);
+    ink_scanner_next(&scanner, &token);
+
+    while (token.type != INK_TT_EOF) {
+        const size_t offset = scanner.cursor_offset;
+        struct ink_token replayed;
+
+        if (!ink_token_buffer_replay(buffer, &scanner, &replayed)) {
+            ink_scanner_next(&scanner, &token);
+            if (token.type != INK_TT_EOF) {
+                missing++;
+            }
+        } else {
+            token = replayed;
+        }
+        if (scanner.cursor_offset == offset) {
+            break;
+        }
+    }
+    if (missing > 0) {
+        fprintf(stderr, "%zu tokens were not pre-lexed\n", missing);
+        return false;
+    }
+    return true;
+}
+
+static double bench_parse(struct ink_source *source, int flags)
+{
+    struct timespec start, end;
+    struct ink_arena arena;
+    struct ink_syntax_tree tree;
+
+    ink_arena_initialize(&arena, 8192, 8);
+    ink_syntax_tree_initialize(source, &tree);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ink_parse(&arena, source, &tree, flags);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    ink_syntax_tree_cleanup(&tree);
+    ink_arena_release(&arena);
+    return bench_elapsed(&start, &end);
+}
+
+/**
+ * Report pre-lexing throughput when split across 1, 2, 4 and 8 chunks,
+ * after checking the tokens pre-lexed for each, followed by parsing
+ * throughput with and without pre-lexing on every available processor.
+ */
+int main(int argc, char *argv[])
+{
+    struct ink_source source;
+    struct ink_token_buffer buffer;
+    double best[2] = {0.0, 0.0};
+    static const int flags[] = {0, INK_PARSER_F_PRELEXING};
+    static const char *labels[] = {"lex", "prelex"};
+    int status = EXIT_SUCCESS;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ink_simd_initialize();
+
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    ink_token_buffer_initialize(&buffer);
+
+    for (size_t jobs = 1; jobs <= 8; jobs *= 2) {
+        struct timespec start, end;
+        double best_prelex = 0.0;
+
+        for (int pass = 0; pass < BENCH_PASSES; pass++) {
+            double elapsed;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            ink_token_buffer_prelex(&buffer, &source, jobs);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            elapsed = bench_elapsed(&start, &end);
+            if (best_prelex == 0.0 || elapsed < best_prelex) {
+                best_prelex = elapsed;
+            }
+        }
+        if (!bench_compare(&source, &buffer)) {
+            status = EXIT_FAILURE;
+        }
+
+        printf("prelex %zu %10.6f s %10.1f MB/s %zu tokens\n", jobs,
+               best_prelex, (double)source.length / 1e6 / best_prelex,
+               buffer.lanes[INK_GRAMMAR_CONTENT].count);
+    }
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (int i = 0; i < 2; i++) {
+            const double elapsed = bench_parse(&source, flags[i]);
+
+            if (best[i] == 0.0 || elapsed < best[i]) {
+                best[i] = elapsed;
+            }
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        printf("%-8s %10.6f s %10.1f MB/s (%zu threads)\n", labels[i],
+               best[i], (double)source.length / 1e6 / best[i],
+               i == 0 ? (size_t)1 : platform_cpu_count());
+    }
+
+    ink_token_buffer_cleanup(&buffer);
+    ink_source_free(&source);
+    return status;
+}
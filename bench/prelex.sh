@@ -0,0 +1,38 @@
+#!/bin/sh
+# Report pre-lexing and parsing throughput on a prose-heavy story and on
+# one whose block comments span many lines, so that chunks often start
+# inside a comment and have to be repaired.
+set -e
+
+BENCH=${BENCH:-dist/bench/prelex}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/prose.passage" <<'INK'
+The rain had not stopped for three days, and the lamplighter was tired.
+    She walked the length of Fairweather Street with her ladder on her shoulder
+and counted the houses whose windows were still dark at this hour.
+*   "Good evening," she said to the watchman at the corner.
+    -> corner_conversation
+INK
+
+cat >"$TMP/comments.passage" <<'INK'
+/* The lamplighter's route was rewritten for the second draft, and the
+   houses on the north side of the street are now visited first.
+
+   The watchman's lines below are placeholders. */
+The lamplighter had lit {lamps} lamps by the time she reached the corner. // TODO
+    // She does not know the watchman yet.
+		  *   {lamps > 3} "It is getting late," she said.
+INK
+
+for input in prose comments; do
+    i=0
+    while [ $i -lt 40000 ]; do
+        cat "$TMP/$input.passage"
+        i=$((i + 1))
+    done >"$TMP/$input.ink"
+
+    echo "$input:"
+    "$BENCH" "$TMP/$input.ink"
+done
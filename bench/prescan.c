@@ -0,0 +1,125 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/prescan.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+
+#define BENCH_PASSES 10
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/*
+ * Check that two boundary tables are the same.
+ */
+static bool bench_equal(const struct ink_boundary_table *a,
+                        const struct ink_boundary_table *b)
+{
+    if (a->count != b->count) {
+        return false;
+    }
+    for (size_t i = 0; i < a->count; i++) {
+        const struct ink_boundary *x = &a->entries[i];
+        const struct ink_boundary *y = &b->entries[i];
+
+        if (x->offset != y->offset || x->name_offset != y->name_offset ||
+            x->name_length != y->name_length || x->type != y->type) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Report the throughput of the pre-scanner at every supported instruction
+ * set level, after checking each against the scalar implementation.
+ *
+ * Searching the whole source for a byte it does not contain with `memchr`
+ * is reported first, as the speed at which the source can be read at all.
+ */
+int main(int argc, char *argv[])
+{
+    struct ink_source source;
+    struct ink_boundary_table expected;
+    struct timespec start, end;
+    const enum ink_simd_level supported = ink_simd_detect();
+    double best = 0.0;
+    int status = EXIT_SUCCESS;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        const void *volatile found;
+        double elapsed;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        found = memchr(source.bytes, 0xff, source.length);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        (void)found;
+        elapsed = bench_elapsed(&start, &end);
+        if (best == 0.0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    printf("%-6s %10.6f s %10.1f MB/s\n", "memchr", best,
+           (double)source.length / 1e6 / best);
+
+    ink_boundary_table_create(&expected);
+    ink_simd_select(INK_SIMD_SCALAR);
+    ink_prescan(&source, &expected);
+
+    for (int level = INK_SIMD_SCALAR; level <= (int)supported; level++) {
+        best = 0.0;
+        ink_simd_select((enum ink_simd_level)level);
+
+        for (int pass = 0; pass < BENCH_PASSES; pass++) {
+            struct ink_boundary_table table;
+            double elapsed;
+
+            ink_boundary_table_create(&table);
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            ink_prescan(&source, &table);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            if (!bench_equal(&expected, &table)) {
+                fprintf(stderr, "Mismatch at %s level\n",
+                        ink_simd_level_strz((enum ink_simd_level)level));
+                status = EXIT_FAILURE;
+            }
+
+            elapsed = bench_elapsed(&start, &end);
+            if (best == 0.0 || elapsed < best) {
+                best = elapsed;
+            }
+
+            ink_boundary_table_destroy(&table);
+        }
+
+        printf("%-6s %10.6f s %10.1f MB/s (%zu boundaries)\n",
+               ink_simd_level_strz((enum ink_simd_level)level), best,
+               (double)source.length / 1e6 / best, expected.count);
+    }
+
+    ink_boundary_table_destroy(&expected);
+    ink_source_free(&source);
+    return status;
+}
@@ -0,0 +1,128 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/arena.h"
+#include "../src/parse.h"
+#include "../src/scanner.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+#include "../src/token.h"
+#include "../src/tree.h"
+
+#define BENCH_PASSES 10
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Scan an entire source in content mode, counting its tokens.
+ */
+static double bench_lex(struct ink_source *source, size_t *count)
+{
+    struct timespec start, end;
+    struct ink_scanner scanner;
+    struct ink_token token;
+    size_t tokens = 0;
+
+    ink_scanner_initialize(&scanner, source, 0, true);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        ink_scanner_next(&scanner, &token);
+        tokens++;
+    } while (token.type != INK_TT_EOF);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *count = tokens;
+    return bench_elapsed(&start, &end);
+}
+
+static double bench_parse(struct ink_source *source)
+{
+    struct timespec start, end;
+    struct ink_arena arena;
+    struct ink_syntax_tree tree;
+
+    ink_arena_initialize(&arena, 8192, 8);
+    ink_syntax_tree_initialize(source, &tree);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ink_parse(&arena, source, &tree, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    ink_syntax_tree_cleanup(&tree);
+    ink_arena_release(&arena);
+    return bench_elapsed(&start, &end);
+}
+
+/**
+ * Report the time spent per token by the parser over that of the scanner
+ * alone, on a source where most tokens are plain words of content.
+ *
+ * Diagnostics are sent to /dev/null while parsing.
+ */
+int main(int argc, char *argv[])
+{
+    int null_fd, stdout_fd;
+    struct ink_source source;
+    size_t tokens = 0;
+    double lex_best = 0.0, parse_best = 0.0;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ink_simd_initialize();
+
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    null_fd = open("/dev/null", O_WRONLY);
+    stdout_fd = dup(STDOUT_FILENO);
+    if (null_fd < 0 || stdout_fd < 0) {
+        fprintf(stderr, "Could not redirect STDOUT.\n");
+        return EXIT_FAILURE;
+    }
+
+    dup2(null_fd, STDOUT_FILENO);
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        const double lex = bench_lex(&source, &tokens);
+        const double parse = bench_parse(&source);
+
+        if (lex_best == 0.0 || lex < lex_best) {
+            lex_best = lex;
+        }
+        if (parse_best == 0.0 || parse < parse_best) {
+            parse_best = parse;
+        }
+    }
+
+    fflush(stdout);
+    dup2(stdout_fd, STDOUT_FILENO);
+
+    printf("%zu bytes, %zu tokens\n", source.length, tokens);
+    printf("lex:      %10.6f s %8.2f ns/token\n", lex_best,
+           lex_best * 1e9 / (double)tokens);
+    printf("parse:    %10.6f s %8.2f ns/token\n", parse_best,
+           parse_best * 1e9 / (double)tokens);
+    printf("overhead: %10.6f s %8.2f ns/token\n", parse_best - lex_best,
+           (parse_best - lex_best) * 1e9 / (double)tokens);
+
+    ink_source_free(&source);
+    close(null_fd);
+    close(stdout_fd);
+    return EXIT_SUCCESS;
+}
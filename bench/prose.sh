@@ -0,0 +1,33 @@
+#!/bin/sh
+# Report the parser's overhead per token over the scanner on a prose-heavy
+# story, where nearly every token is a word of content, and on one with a
+# choice on every other line.
+set -e
+
+BENCH=${BENCH:-dist/bench/prose}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/prose.passage" <<'INK'
+The rain had not stopped for three days, and the lamplighter was tired.
+She walked the length of Fairweather Street with her ladder on her shoulder
+and counted the houses whose windows were still dark at this hour.
+INK
+
+cat >"$TMP/choices.passage" <<'INK'
+*   [Light the lamp] She lit the lamp at the corner of the street.
+    The watchman nodded to her from across the road.
++   "Good evening,"[] she said, and walked on in the rain.
+    - She counted the houses that were still dark.
+INK
+
+for input in prose choices; do
+    i=0
+    while [ $i -lt 40000 ]; do
+        cat "$TMP/$input.passage"
+        i=$((i + 1))
+    done >"$TMP/$input.ink"
+
+    echo "$input:"
+    "$BENCH" "$TMP/$input.ink"
+done
@@ -0,0 +1,111 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/arena.h"
+#include "../src/parse.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+#include "../src/tree.h"
+
+#define BENCH_PASSES 5
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static double bench_parse(struct ink_source *source)
+{
+    struct timespec start, end;
+    struct ink_arena arena;
+    struct ink_syntax_tree tree;
+
+    ink_arena_initialize(&arena, 8192, 8);
+    ink_syntax_tree_initialize(source, &tree);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ink_parse(&arena, source, &tree, 0);
+    fflush(stdout);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    ink_syntax_tree_cleanup(&tree);
+    ink_arena_release(&arena);
+    return bench_elapsed(&start, &end);
+}
+
+/**
+ * Report how long the parser takes to get through a badly broken source,
+ * including writing out its diagnostics, and how much it writes.
+ *
+ * Diagnostics are sent to a temporary file, which is counted afterwards.
+ */
+int main(int argc, char *argv[])
+{
+    int stdout_fd;
+    FILE *output;
+    struct ink_source source;
+    size_t lines = 0, bytes = 0;
+    double best = 0.0;
+    int c;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ink_simd_initialize();
+
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    stdout_fd = dup(STDOUT_FILENO);
+    if (stdout_fd < 0) {
+        fprintf(stderr, "Could not redirect STDOUT.\n");
+        return EXIT_FAILURE;
+    }
+
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        double elapsed;
+
+        output = tmpfile();
+        if (output == NULL) {
+            fprintf(stderr, "Could not create a temporary file.\n");
+            return EXIT_FAILURE;
+        }
+
+        dup2(fileno(output), STDOUT_FILENO);
+        elapsed = bench_parse(&source);
+        dup2(stdout_fd, STDOUT_FILENO);
+
+        if (best == 0.0 || elapsed < best) {
+            best = elapsed;
+        }
+        if (pass == 0) {
+            rewind(output);
+            while ((c = fgetc(output)) != EOF) {
+                bytes++;
+                if (c == '\n') {
+                    lines++;
+                }
+            }
+        }
+
+        fclose(output);
+    }
+
+    printf("%zu bytes, wrote %zu lines of diagnostics in %zu bytes\n",
+           source.length, lines, bytes);
+    printf("%10.6f s %10.1f MB/s\n", best, (double)source.length / 1e6 / best);
+
+    ink_source_free(&source);
+    close(stdout_fd);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,25 @@
+#!/bin/sh
+# Report how long the parser takes to recover from every error in a story
+# that is broken on nearly every line, and how much it writes while doing so.
+set -e
+
+BENCH=${BENCH:-dist/bench/recover}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/broken.passage" <<'INK'
+~ temp lamps = count(streets houses windows doors and all of the lamps on them)
+The lamplighter had lit {lamps} lamps by the time she reached the corner.
+VAR weather = (rain and wind and fog rolling in from the river all night long)
+*   [Light the lamp] She lit the lamp at the corner of Fairweather Street.
+~ ladder(heavy tired and wet from three days of rain that had not stopped)
+INK
+
+i=0
+while [ $i -lt 40000 ]; do
+    cat "$TMP/broken.passage"
+    i=$((i + 1))
+done >"$TMP/broken.ink"
+
+echo "broken:"
+"$BENCH" "$TMP/broken.ink"
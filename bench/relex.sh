@@ -0,0 +1,34 @@
+#!/bin/sh
+# Report parsing throughput with and without the token buffer on a story
+# that relies heavily on inline logic, which the parser backtracks over,
+# and on a prose-heavy one, where it never does.
+set -e
+
+BENCH=${BENCH:-dist/bench/relex}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/logic.passage" <<'INK'
+The lamplighter had lit {lamps} lamps by the time {name} reached the corner.
+{visited_corner: She nodded to the watchman.|She did not know the watchman yet.}
+*   {lamps > 3} "It is getting late," she said.
+    -> corner_conversation
+Her ladder felt {heavy && tired: heavier than usual|light enough} tonight.
+INK
+
+cat >"$TMP/prose.passage" <<'INK'
+The rain had not stopped for three days, and the lamplighter was tired.
+She walked the length of Fairweather Street with her ladder on her shoulder
+and counted the houses whose windows were still dark at this hour.
+INK
+
+for input in logic prose; do
+    i=0
+    while [ $i -lt 20000 ]; do
+        cat "$TMP/$input.passage"
+        i=$((i + 1))
+    done >"$TMP/$input.ink"
+
+    echo "$input:"
+    "$BENCH" "$TMP/$input.ink"
+done
@@ -0,0 +1,114 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/arena.h"
+#include "../src/parse.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+#include "../src/tree.h"
+
+#define BENCH_PASSES 10
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static double bench_parse(struct ink_source *source,
+                          struct ink_parse_stats *stats)
+{
+    struct timespec start, end;
+    struct ink_arena arena;
+    struct ink_syntax_tree tree;
+
+    ink_arena_initialize(&arena, 8192, 8);
+    ink_syntax_tree_initialize(source, &tree);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ink_parse_with_stats(&arena, source, &tree, 0, stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    ink_syntax_tree_cleanup(&tree);
+    ink_arena_release(&arena);
+    return bench_elapsed(&start, &end);
+}
+
+/**
+ * Report how often the parser backtracked over a set of files, along with
+ * the bytes it lexed again, the bytes it looked ahead at and its
+ * throughput over all of them.
+ *
+ * Diagnostics are sent to /dev/null while parsing.
+ */
+int main(int argc, char *argv[])
+{
+    int null_fd, stdout_fd;
+    struct ink_parse_stats stats;
+    struct ink_parse_stats total = {0};
+    size_t length = 0;
+    double best = 0.0;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s FILE...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ink_simd_initialize();
+
+    null_fd = open("/dev/null", O_WRONLY);
+    stdout_fd = dup(STDOUT_FILENO);
+    if (null_fd < 0 || stdout_fd < 0) {
+        fprintf(stderr, "Could not redirect STDOUT.\n");
+        return EXIT_FAILURE;
+    }
+
+    dup2(null_fd, STDOUT_FILENO);
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        double elapsed = 0.0;
+
+        for (int i = 1; i < argc; i++) {
+            struct ink_source source;
+
+            if (ink_source_load(argv[i], &source) < 0) {
+                dup2(stdout_fd, STDOUT_FILENO);
+                fprintf(stderr, "Could not load %s.\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+
+            elapsed += bench_parse(&source, &stats);
+
+            if (pass == 0) {
+                length += source.length;
+                total.lexed_bytes += stats.lexed_bytes;
+                total.relexed_bytes += stats.relexed_bytes;
+                total.peeked_bytes += stats.peeked_bytes;
+                total.rewinds += stats.rewinds;
+            }
+
+            ink_source_free(&source);
+        }
+        if (best == 0.0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    fflush(stdout);
+    dup2(stdout_fd, STDOUT_FILENO);
+
+    printf("%d files, %zu bytes, %zu rewinds, relexed %zu bytes, "
+           "peeked at %zu\n",
+           argc - 1, length, total.rewinds, total.relexed_bytes,
+           total.peeked_bytes);
+    printf("%10.6f s %10.1f MB/s\n", best, (double)length / 1e6 / best);
+
+    close(null_fd);
+    close(stdout_fd);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Report how often the parser backtracks on the test corpus, and on a large
+# story that relies heavily on inline logic.
+set -e
+
+BENCH=${BENCH:-dist/bench/rewind}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/logic.passage" <<'INK'
+The lamplighter had lit {lamps} lamps by the time {name} reached the corner.
+{visited_corner: She nodded to the watchman.|She did not know the watchman yet.}
+*   {lamps > 3} "It is getting late," she said.
+    -> corner_conversation
+Her ladder felt {heavy && tired: heavier than usual|light enough} tonight.
+{&The bell rang.|The bell rang again.|{bells(3)} bells had rung.}
+INK
+
+i=0
+while [ $i -lt 20000 ]; do
+    cat "$TMP/logic.passage"
+    i=$((i + 1))
+done >"$TMP/logic.ink"
+
+# Stories in the corpus that the parser cannot handle yet are left out.
+for story in tests/*/*.ink tests/*/*/*.ink; do
+    if "$BENCH" "$story" >/dev/null 2>&1; then
+        set -- "$@" "$story"
+    fi
+done
+
+echo "corpus:"
+"$BENCH" "$@"
+echo "logic:"
+"$BENCH" "$TMP/logic.ink"
@@ -0,0 +1,85 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/scanner.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+#include "../src/token.h"
+
+#define BENCH_PASSES 10
+
+/**
+ * Scan an entire source in content mode.
+ *
+ * Returns a checksum over the token stream so that implementations can be
+ * checked against each other.
+ */
+static size_t bench_scan(struct ink_source *source)
+{
+    struct ink_scanner scanner;
+    struct ink_token token;
+    size_t checksum = 0;
+
+    ink_scanner_initialize(&scanner, source, 0, true);
+
+    do {
+        ink_scanner_next(&scanner, &token);
+        checksum = checksum * 31 + (size_t)token.type + token.end_offset;
+    } while (token.type != INK_TT_EOF);
+
+    return checksum;
+}
+
+/**
+ * Report content-mode scanner throughput for every instruction set level
+ * supported by the host.
+ */
+int main(int argc, char *argv[])
+{
+    struct ink_source source;
+    size_t reference = 0;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    for (int level = INK_SIMD_SCALAR; level <= INK_SIMD_AVX2; level++) {
+        double best = 0.0;
+        size_t checksum = 0;
+
+        if (ink_simd_select(level) != (enum ink_simd_level)level) {
+            continue;
+        }
+        for (int pass = 0; pass < BENCH_PASSES; pass++) {
+            struct timespec start, end;
+            double elapsed;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            checksum = bench_scan(&source);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            elapsed = (double)(end.tv_sec - start.tv_sec) +
+                      (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+            if (best == 0.0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        if (level == INK_SIMD_SCALAR) {
+            reference = checksum;
+        }
+
+        printf("%-8s %10.1f MB/s%s\n", ink_simd_level_strz(level),
+               (double)source.length / 1e6 / best,
+               checksum == reference ? "" : "  (token stream mismatch!)");
+    }
+
+    ink_source_free(&source);
+    return EXIT_SUCCESS;
+}
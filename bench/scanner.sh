@@ -0,0 +1,35 @@
+#!/bin/sh
+# Report content-mode scanner throughput on a prose-heavy story and on a
+# heavily annotated one, where long comments and indentation dominate.
+set -e
+
+BENCH=${BENCH:-dist/bench/scanner}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/prose.passage" <<'INK'
+The rain had not stopped for three days, and the lamplighter was tired.
+    She walked the length of Fairweather Street with her ladder on her shoulder
+and counted the houses whose windows were still dark at this hour.
+*   "Good evening," she said to the watchman at the corner.
+    -> corner_conversation
+INK
+
+cat >"$TMP/annotated.passage" <<'INK'
+        // TODO: Revisit the lamplighter's backstory once the second act has been rewritten.
+/* The following passage is read aloud by the narrator during the transition
+   between the first and second acts, and must not be shortened without first
+   checking the recorded audio for the scene. */
+		    The_lamplighter_climbed_the_ladder_and_lit_the_final_lamp.
+INK
+
+for input in prose annotated; do
+    i=0
+    while [ $i -lt 40000 ]; do
+        cat "$TMP/$input.passage"
+        i=$((i + 1))
+    done >"$TMP/$input.ink"
+
+    echo "$input:"
+    "$BENCH" "$TMP/$input.ink"
+done
@@ -0,0 +1,140 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/inkc.h"
+
+#define BENCH_PASSES 10
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Parse every source with an arena and a parser of its own.
+ */
+static double bench_parse(struct ink_source *sources, size_t count)
+{
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < count; i++) {
+        struct ink_arena arena;
+        struct ink_syntax_tree tree;
+
+        ink_arena_initialize(&arena, 8192, 8);
+        ink_syntax_tree_initialize(&sources[i], &tree);
+        ink_parse(&arena, &sources[i], &tree, 0);
+        ink_syntax_tree_cleanup(&tree);
+        ink_arena_release(&arena);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return bench_elapsed(&start, &end);
+}
+
+/**
+ * Parse every source with the same session.
+ */
+static double bench_session(struct ink_parse_session *session,
+                            struct ink_source *sources, size_t count)
+{
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < count; i++) {
+        struct ink_syntax_tree tree;
+
+        ink_syntax_tree_initialize(&sources[i], &tree);
+        ink_parse_session_parse(session, &sources[i], &tree, 0);
+        ink_syntax_tree_cleanup(&tree);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return bench_elapsed(&start, &end);
+}
+
+/**
+ * Report the time per file taken to parse a set of files, each with a
+ * parser and an arena set up for it, against that taken with one parse
+ * session kept warm between them.
+ *
+ * Diagnostics are sent to /dev/null while parsing.
+ */
+int main(int argc, char *argv[])
+{
+    int null_fd, stdout_fd;
+    struct ink_source *sources;
+    struct ink_parse_session *session;
+    const size_t count = (size_t)argc - 1;
+    size_t length = 0;
+    double parse_best = 0.0, session_best = 0.0;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s FILE...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ink_simd_initialize();
+
+    sources = malloc(count * sizeof(*sources));
+    session = ink_parse_session_new();
+    if (sources == NULL || session == NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (ink_source_load(argv[i + 1], &sources[i]) < 0) {
+            fprintf(stderr, "Could not load %s.\n", argv[i + 1]);
+            return EXIT_FAILURE;
+        }
+
+        length += sources[i].length;
+    }
+
+    null_fd = open("/dev/null", O_WRONLY);
+    stdout_fd = dup(STDOUT_FILENO);
+    if (null_fd < 0 || stdout_fd < 0) {
+        fprintf(stderr, "Could not redirect STDOUT.\n");
+        return EXIT_FAILURE;
+    }
+
+    dup2(null_fd, STDOUT_FILENO);
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        const double parse = bench_parse(sources, count);
+        const double warm = bench_session(session, sources, count);
+
+        if (parse_best == 0.0 || parse < parse_best) {
+            parse_best = parse;
+        }
+        if (session_best == 0.0 || warm < session_best) {
+            session_best = warm;
+        }
+    }
+
+    fflush(stdout);
+    dup2(stdout_fd, STDOUT_FILENO);
+
+    printf("%zu files, %zu bytes\n", count, length);
+    printf("parse:   %10.6f s %8.2f us/file\n", parse_best,
+           parse_best * 1e6 / (double)count);
+    printf("session: %10.6f s %8.2f us/file\n", session_best,
+           session_best * 1e6 / (double)count);
+
+    ink_parse_session_free(session);
+    for (size_t i = 0; i < count; i++) {
+        ink_source_free(&sources[i]);
+    }
+
+    free(sources);
+    close(null_fd);
+    close(stdout_fd);
+    return EXIT_SUCCESS;
+}
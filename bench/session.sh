@@ -0,0 +1,31 @@
+#!/bin/sh
+# Report the time per file taken to parse a thousand small stories, each
+# with a parser and an arena of its own, against that with one parse
+# session kept warm between them.
+set -e
+
+BENCH=${BENCH:-dist/bench/session}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/scene.passage" <<'INK'
+The lamplighter had lit {lamps} lamps by the time {name} reached the corner.
+*   "It is getting late," she said.
+    -> corner_conversation
+*   [Walk on]
+    She walked the length of Fairweather Street with her ladder.
+-   Her ladder felt heavier than usual tonight.
+~ lamps = lamps + 1
+INK
+
+i=0
+while [ $i -lt 1000 ]; do
+    {
+        echo "=== scene_$i ==="
+        cat "$TMP/scene.passage"
+    } >"$TMP/scene_$i.ink"
+    i=$((i + 1))
+done
+
+echo "scenes:"
+"$BENCH" "$TMP"/scene_*.ink
@@ -0,0 +1,39 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/source.h"
+
+/**
+ * Time how long it takes to load an Ink source file from STDIN.
+ *
+ * Prints the number of bytes loaded, the elapsed time in seconds and the
+ * resulting throughput in MB/s.
+ */
+int main(void)
+{
+    int rc;
+    double elapsed;
+    struct timespec start, end;
+    struct ink_source source;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    rc = ink_source_load_stdin(&source);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (rc < 0) {
+        fprintf(stderr, "Could not load STDIN.\n");
+        return EXIT_FAILURE;
+    }
+
+    elapsed = (double)(end.tv_sec - start.tv_sec) +
+              (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("%12zu bytes %10.6f s %10.1f MB/s\n", source.length, elapsed,
+           (double)source.length / 1e6 / elapsed);
+
+    ink_source_free(&source);
+    return EXIT_SUCCESS;
+}
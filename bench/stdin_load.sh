@@ -0,0 +1,15 @@
+#!/bin/sh
+# Load 1 MB to 100 MB of Ink through a pipe and report the loader's
+# throughput. Linear scaling shows up as a roughly constant MB/s column.
+set -e
+
+BENCH=${BENCH:-dist/bench/stdin_load}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+yes 'Once upon a time, {x > 1: there was} a knot. -> END' |
+    head -c 100000000 >"$TMP/story.ink"
+
+for size in 1000000 10000000 50000000 100000000; do
+    head -c "$size" "$TMP/story.ink" | "$BENCH"
+done
@@ -0,0 +1,107 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/arena.h"
+#include "../src/parse.h"
+#include "../src/simd.h"
+#include "../src/source.h"
+#include "../src/token.h"
+#include "../src/tree.h"
+
+#define BENCH_PASSES 10
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Report the memory used by a syntax tree, along with the time taken to
+ * parse a story and to print its syntax tree.
+ *
+ * The tree is printed to /dev/null. Build with INK_LARGE_FILES defined to
+ * measure the wide representation of tokens and nodes.
+ */
+int main(int argc, char *argv[])
+{
+    int null_fd, stdout_fd;
+    struct ink_source source;
+    struct timespec start, end;
+    double best_parse = 0.0, best_print = 0.0;
+    size_t tree_bytes = 0;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ink_simd_initialize();
+
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    null_fd = open("/dev/null", O_WRONLY);
+    stdout_fd = dup(STDOUT_FILENO);
+    if (null_fd < 0 || stdout_fd < 0) {
+        fprintf(stderr, "Could not redirect STDOUT.\n");
+        return EXIT_FAILURE;
+    }
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        struct ink_arena arena;
+        struct ink_syntax_tree tree;
+        double elapsed;
+
+        ink_arena_initialize(&arena, 8192, 8);
+        ink_syntax_tree_initialize(&source, &tree);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ink_parse(&arena, &source, &tree, 0);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        elapsed = bench_elapsed(&start, &end);
+        if (best_parse == 0.0 || elapsed < best_parse) {
+            best_parse = elapsed;
+        }
+
+        fflush(stdout);
+        dup2(null_fd, STDOUT_FILENO);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ink_syntax_tree_print(&tree, false);
+        fflush(stdout);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        dup2(stdout_fd, STDOUT_FILENO);
+
+        elapsed = bench_elapsed(&start, &end);
+        if (best_print == 0.0 || elapsed < best_print) {
+            best_print = elapsed;
+        }
+
+        tree_bytes = arena.total_bytes;
+        ink_syntax_tree_cleanup(&tree);
+        ink_arena_release(&arena);
+    }
+
+    printf("token %zu bytes, node %zu bytes, tree %zu bytes\n",
+           sizeof(struct ink_token), sizeof(struct ink_syntax_node),
+           tree_bytes);
+    printf("parse %10.6f s %10.1f MB/s\n", best_parse,
+           (double)source.length / 1e6 / best_parse);
+    printf("print %10.6f s %10.1f MB/s\n", best_print,
+           (double)source.length / 1e6 / best_print);
+
+    close(null_fd);
+    close(stdout_fd);
+    ink_source_free(&source);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Report syntax tree memory along with parsing and tree printing times on a
+# prose-heavy story and on one that relies heavily on inline logic. Build
+# the benchmarks with `make bench CPPFLAGS=-DINK_LARGE_FILES` to compare
+# against the wide representation of tokens and nodes.
+set -e
+
+BENCH=${BENCH:-dist/bench/tree}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/prose.passage" <<'INK'
+The rain had not stopped for three days, and the lamplighter was tired.
+    She walked the length of Fairweather Street with her ladder on her shoulder
+and counted the houses whose windows were still dark at this hour.
+*   "Good evening," she said to the watchman at the corner.
+    -> corner_conversation
+INK
+
+cat >"$TMP/logic.passage" <<'INK'
+The lamplighter had lit {lamps} lamps by the time {name} reached the corner.
+{visited_corner: She nodded to the watchman.|She did not know the watchman yet.}
+*   {lamps > 3} "It is getting late," she said.
+    -> corner_conversation
+Her ladder felt {heavy && tired: heavier than usual|light enough} tonight.
+INK
+
+for input in prose logic; do
+    i=0
+    while [ $i -lt 20000 ]; do
+        cat "$TMP/$input.passage"
+        i=$((i + 1))
+    done >"$TMP/$input.ink"
+
+    echo "$input:"
+    "$BENCH" "$TMP/$input.ink"
+done
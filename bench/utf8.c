@@ -0,0 +1,134 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/simd.h"
+#include "../src/source.h"
+
+#define BENCH_PASSES 10
+#define BENCH_MUTATIONS 1000000
+#define BENCH_WINDOW 512
+
+static double bench_elapsed(const struct timespec *start,
+                            const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Validate windows of a source with a few bytes replaced at random, and
+ * report the first window on which an instruction set level disagrees with
+ * the scalar implementation.
+ */
+static bool bench_compare(const struct ink_source *source,
+                          enum ink_simd_level level)
+{
+    static const unsigned char interesting[] = {
+        0x00, 0x7f, 0x80, 0x8f, 0x90, 0x9f, 0xa0, 0xbf, 0xc0, 0xc1, 0xc2,
+        0xdf, 0xe0, 0xe1, 0xed, 0xee, 0xef, 0xf0, 0xf1, 0xf4, 0xf5, 0xff,
+    };
+    unsigned char bytes[BENCH_WINDOW];
+
+    srand(1);
+
+    for (int i = 0; i < BENCH_MUTATIONS; i++) {
+        size_t expected, actual, offset, length;
+
+        length = (size_t)rand() % BENCH_WINDOW + 1;
+        if (length > source->length) {
+            length = source->length;
+        }
+
+        offset = (size_t)rand() % (source->length - length + 1);
+        memcpy(bytes, source->bytes + offset, length);
+
+        for (int j = rand() % 4; j >= 0; j--) {
+            bytes[(size_t)rand() % length] =
+                interesting[(size_t)rand() % sizeof(interesting)];
+        }
+
+        /* Start within the first block, so that alignment varies. */
+        offset = (size_t)rand() % 64;
+        if (offset > length) {
+            offset = 0;
+        }
+
+        ink_simd_select(INK_SIMD_SCALAR);
+        expected = ink_simd_validate_utf8(bytes, offset, length);
+        ink_simd_select(level);
+        actual = ink_simd_validate_utf8(bytes, offset, length);
+
+        if (expected != actual) {
+            fprintf(stderr,
+                    "Mismatch at %s level on mutation %d: expected %zu, "
+                    "got %zu\n",
+                    ink_simd_level_strz(level), i, expected, actual);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Report UTF-8 validation throughput at every supported instruction set
+ * level, after checking each against the scalar implementation.
+ */
+int main(int argc, char *argv[])
+{
+    struct ink_source source;
+    const enum ink_simd_level supported = ink_simd_detect();
+    int status = EXIT_SUCCESS;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ink_simd_initialize();
+
+    if (ink_source_load(argv[1], &source) < 0) {
+        fprintf(stderr, "Could not load %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    if (source.length == 0) {
+        ink_source_free(&source);
+        return EXIT_SUCCESS;
+    }
+    for (int level = INK_SIMD_SCALAR; level <= (int)supported; level++) {
+        struct timespec start, end;
+        double best = 0.0;
+        size_t offset = 0;
+
+        if (level != INK_SIMD_SCALAR &&
+            !bench_compare(&source, (enum ink_simd_level)level)) {
+            status = EXIT_FAILURE;
+        }
+
+        ink_simd_select((enum ink_simd_level)level);
+
+        for (int pass = 0; pass < BENCH_PASSES; pass++) {
+            double elapsed;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            offset = ink_simd_validate_utf8(source.bytes, 0, source.length);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            elapsed = bench_elapsed(&start, &end);
+            if (best == 0.0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+
+        printf("%-6s %10.6f s %10.1f MB/s (valid to %zu)\n",
+               ink_simd_level_strz((enum ink_simd_level)level), best,
+               (double)source.length / 1e6 / best, offset);
+    }
+
+    ink_source_free(&source);
+    return status;
+}
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Report UTF-8 validation throughput on a story that is almost entirely
+# ASCII and on one in which every line carries multi-byte characters.
+set -e
+
+BENCH=${BENCH:-dist/bench/utf8}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat >"$TMP/ascii.passage" <<'INK'
+The rain had not stopped for three days, and the lamplighter was tired.
+    She walked the length of Fairweather Street with her ladder on her shoulder
+and counted the houses whose windows were still dark at this hour.
+*   "Good evening," she said to the watchman at the corner.
+    -> corner_conversation
+INK
+
+cat >"$TMP/mixed.passage" <<'INK'
+Le réverbère de la rue Beauséjour brûlait encore à l’aube — déjà éteint?
+    Она шла по улице с лестницей на плече и считала тёмные окна.
+街灯の灯りはまだ消えていなかった。彼女は梯子を肩に担いで歩いた。
+*   “Good evening,” she said to the watchman at the corner. 🏮
+    -> corner_conversation
+INK
+
+for input in ascii mixed; do
+    i=0
+    while [ $i -lt 20000 ]; do
+        cat "$TMP/$input.passage"
+        i=$((i + 1))
+    done >"$TMP/$input.ink"
+
+    echo "$input:"
+    "$BENCH" "$TMP/$input.ink"
+done
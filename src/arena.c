@@ -63,44 +63,54 @@ static struct ink_arena_block *ink_arena_block_new(size_t size)
  * Provision memory within a block.
  *
  * If the specified block does not contain an adequate capacity for an
- * allocation of the requested size, a new block will be created and chained to
- * the supplied block.
+ * allocation of the requested size, the allocation moves on to the block
+ * after it, which is only there if the arena was restored to an earlier
+ * point. If there is no such block, or it is too small, a new block will be
+ * created and chained to the supplied block. `*block` is set to the block
+ * the allocation was provisioned from.
  *
- * The supplied block MUST not be NULL and MUST be the most recently allocated
- * allocated block; that is, a block with no `next` link.
+ * The supplied block MUST not be NULL and MUST be the arena's current block.
  */
-static void *ink_arena_block_alloc(struct ink_arena_block *block, size_t size,
-                                   size_t alignment, size_t fallback_size)
+static void *ink_arena_block_alloc(struct ink_arena_block **block,
+                                   size_t size, size_t alignment,
+                                   size_t fallback_size)
 {
     struct ink_arena_block *new_block;
+    struct ink_arena_block *current = *block;
     void *address;
 
-    assert(block != NULL);
+    assert(current != NULL);
 
     size = ink_align_size(size, alignment);
 
-    if (block->offset + size > block->size) {
-        /*
-         * TODO(Brett): We may want to over-allocate here.
-         * Ask someone who knows a lot about allocators.
-         */
-        new_block =
-            ink_arena_block_new(size < fallback_size ? fallback_size : size);
-        if (new_block == NULL)
-            return NULL;
-
-        assert(block->next == NULL);
-
-        block->next = new_block;
-        block = new_block;
+    if (current->offset + size > current->size) {
+        new_block = current->next;
+
+        if (new_block == NULL || size > new_block->size) {
+            /*
+             * TODO(Brett): We may want to over-allocate here.
+             * Ask someone who knows a lot about allocators.
+             */
+            new_block = ink_arena_block_new(size < fallback_size ? fallback_size
+                                                                 : size);
+            if (new_block == NULL)
+                return NULL;
+
+            new_block->next = current->next;
+            current->next = new_block;
+        }
+
+        new_block->offset = 0;
+        current = new_block;
+        *block = current;
     }
 
     /* SANITY: Detect heap-overflow. */
     /* TODO(Brett): This may cause an integer overflow. Do we care? */
-    assert(block->offset + size <= block->size);
+    assert(current->offset + size <= current->size);
 
-    address = (unsigned char *)block->bytes + block->offset;
-    block->offset += size;
+    address = (unsigned char *)current->bytes + current->offset;
+    current->offset += size;
 
     return address;
 }
@@ -154,6 +164,7 @@ void *ink_arena_allocate(struct ink_arena *arena, size_t size)
 {
     void *address;
     struct ink_arena_block *block;
+    struct ink_arena_block *next;
 
     if (arena->block_first == NULL) {
         // SANITY: First block initialization should only happen once.
@@ -170,7 +181,8 @@ void *ink_arena_allocate(struct ink_arena *arena, size_t size)
         block = arena->block_current;
     }
 
-    address = ink_arena_block_alloc(block, size, arena->alignment,
+    next = block->next;
+    address = ink_arena_block_alloc(&block, size, arena->alignment,
                                     arena->default_block_size);
     if (address == NULL)
         return NULL;
@@ -178,17 +190,90 @@ void *ink_arena_allocate(struct ink_arena *arena, size_t size)
     arena->total_allocations++;
     arena->total_bytes += size;
 
-    if (arena->block_current->next) {
-        arena->block_current = arena->block_current->next;
-        arena->total_blocks++;
-        arena->total_block_size += arena->block_current->size;
+    if (block != arena->block_current) {
+        arena->block_current = block;
 
-        if (arena->block_current->size > arena->default_block_size)
-            arena->total_oversized_blocks++;
+        if (block != next) {
+            arena->total_blocks++;
+            arena->total_block_size += block->size;
+
+            if (block->size > arena->default_block_size)
+                arena->total_oversized_blocks++;
+        }
     }
     return address;
 }
 
+/**
+ * Take ownership of the memory tracked by another arena, along with its
+ * allocation statistics, leaving it empty.
+ *
+ * The other arena's blocks are placed ahead of this arena's, so that later
+ * allocations continue from this arena's current block.
+ */
+void ink_arena_adopt(struct ink_arena *arena, struct ink_arena *other)
+{
+    if (other->block_first != NULL) {
+        struct ink_arena_block *last = other->block_current;
+
+        while (last->next != NULL) {
+            last = last->next;
+        }
+        if (arena->block_first == NULL) {
+            arena->block_current = other->block_current;
+        } else {
+            last->next = arena->block_first;
+        }
+
+        arena->block_first = other->block_first;
+    }
+
+    arena->total_bytes += other->total_bytes;
+    arena->total_blocks += other->total_blocks;
+    arena->total_block_size += other->total_block_size;
+    arena->total_oversized_blocks += other->total_oversized_blocks;
+    arena->total_allocations += other->total_allocations;
+
+    other->block_first = NULL;
+    other->block_current = NULL;
+}
+
+/**
+ * Save the point an arena has allocated up to, to be restored later.
+ */
+void ink_arena_save(const struct ink_arena *arena, struct ink_arena_mark *mark)
+{
+    mark->block = arena->block_current;
+    mark->offset = arena->block_current ? arena->block_current->offset : 0;
+}
+
+/**
+ * Restore an arena to a point saved earlier, giving back everything
+ * allocated since then.
+ *
+ * The arena's blocks are kept, and allocated from again in turn, so an
+ * arena that is restored after each use stops growing once it is large
+ * enough for any one use. Allocation statistics will remain intact.
+ */
+void ink_arena_restore(struct ink_arena *arena,
+                       const struct ink_arena_mark *mark)
+{
+    struct ink_arena_block *block = mark->block;
+
+    if (block == NULL) {
+        block = arena->block_first;
+        if (block == NULL) {
+            return;
+        }
+
+        block->offset = 0;
+    } else {
+        block->offset = mark->offset;
+    }
+
+    arena->block_current = block;
+}
+
 /**
  * Release any memory tracked by the arena.
  *
@@ -7,6 +7,8 @@ extern "C" {
 
 #include <stddef.h>
 
+#include "common.h"
+
 struct ink_arena_block;
 
 /**
@@ -33,10 +35,23 @@ struct ink_arena {
     size_t total_allocations;
 };
 
-extern void ink_arena_initialize(struct ink_arena *arena, size_t block_size,
-                                 size_t alignment);
+/**
+ * Point an arena has allocated up to, saved by `ink_arena_save`.
+ */
+struct ink_arena_mark {
+    struct ink_arena_block *block;
+    size_t offset;
+};
+
+extern INK_API void ink_arena_initialize(struct ink_arena *arena,
+                                         size_t block_size, size_t alignment);
 extern void *ink_arena_allocate(struct ink_arena *arena, size_t size);
-extern void ink_arena_release(struct ink_arena *arena);
+extern void ink_arena_adopt(struct ink_arena *arena, struct ink_arena *other);
+extern void ink_arena_save(const struct ink_arena *arena,
+                           struct ink_arena_mark *mark);
+extern void ink_arena_restore(struct ink_arena *arena,
+                              const struct ink_arena_mark *mark);
+extern INK_API void ink_arena_release(struct ink_arena *arena);
 
 #ifdef __cplusplus
 }
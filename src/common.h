@@ -5,11 +5,42 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Offset into a source, as stored by tokens and syntax nodes.
+ *
+ * Offsets are 32 bits wide, which keeps tokens and nodes compact but limits
+ * sources to 4 GiB. Defining INK_LARGE_FILES widens them to `size_t`.
+ */
+#ifdef INK_LARGE_FILES
+typedef size_t ink_offset_t;
+#define INK_OFFSET_MAX SIZE_MAX
+#else
+typedef uint32_t ink_offset_t;
+#define INK_OFFSET_MAX UINT32_MAX
+#endif
+
+/**
+ * Marks the functions exported by libinkc.so.
+ *
+ * The library is built with hidden visibility, so that its internals are not
+ * exported, and only the functions marked here can be linked against.
+ */
+#if defined(__GNUC__)
+#define INK_API __attribute__((visibility("default")))
+#else
+#define INK_API
+#endif
+
 enum ink_status {
     INK_E_OK,
     INK_E_OOM,
     INK_E_OS,
     INK_E_FILE,
+    INK_E_FILE_SIZE,
+    INK_E_FILE_ENCODING,
     INK_E_PARSE_FAIL,
     INK_E_PARSE_PANIC,
 };
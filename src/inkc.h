@@ -0,0 +1,42 @@
+#ifndef __INKC_H__
+#define __INKC_H__
+
+/**
+ * Public interface of libinkc, the front end of the compiler as a library.
+ *
+ * Link against dist/libinkc.a or dist/libinkc.so, which `make lib` builds,
+ * with src/ on the include path. Only the functions marked with `INK_API`
+ * are exported from the shared library; the rest of what the headers
+ * declare is internal.
+ *
+ * There is no stable ABI. The structures that callers allocate, such as
+ * sources, arenas and syntax trees, are declared in full and change between
+ * versions, so a program must be built against the headers of the library
+ * it links with.
+ *
+ * Call `ink_simd_initialize` once before parsing to use the fastest scanning
+ * routines for the processor; without it, portable ones are used.
+ *
+ * To parse many sources in turn, create one parse session for each thread
+ * and reuse it:
+ *
+ *     struct ink_parse_session *session = ink_parse_session_new();
+ *
+ *     ink_source_load(filename, &source);
+ *     ink_syntax_tree_initialize(&source, &tree);
+ *     rc = ink_parse_session_parse(session, &source, &tree, 0);
+ *     ...
+ *     ink_syntax_tree_cleanup(&tree);
+ *     ink_source_free(&source);
+ *
+ *     ink_parse_session_free(session);
+ */
+
+#include "arena.h"
+#include "common.h"
+#include "parse.h"
+#include "simd.h"
+#include "source.h"
+#include "tree.h"
+
+#endif
@@ -6,6 +6,8 @@
 #include "common.h"
 #include "logging.h"
 #include "parse.h"
+#include "prescan.h"
+#include "simd.h"
 #include "source.h"
 #include "tree.h"
 #include "option.h"
@@ -14,7 +16,19 @@ enum {
     OPT_COLORS = 1000,
     OPT_TRACING,
     OPT_CACHING,
+    OPT_CACHE_LIMIT,
+    OPT_BUFFERING,
+    OPT_PRELEXING,
+    OPT_PARALLEL,
+    OPT_LAZY,
+    OPT_LIST_KNOTS,
     OPT_DUMP_AST,
+    OPT_CHECK,
+    OPT_PROFILE_PARSER,
+    OPT_TRACE_FILE,
+    OPT_DECODE_TRACE,
+    OPT_REPARSE,
+    OPT_SESSION,
     OPT_HELP,
 
     OPT_ARG_EXAMPLE
@@ -24,13 +38,25 @@ static const struct option opts[] = {
     {"--colors", OPT_COLORS, false},
     {"--tracing", OPT_TRACING, false},
     {"--caching", OPT_CACHING, false},
+    {"--cache-limit", OPT_CACHE_LIMIT, true},
+    {"--buffering", OPT_BUFFERING, false},
+    {"--prelex", OPT_PRELEXING, false},
+    {"--parallel", OPT_PARALLEL, false},
+    {"--lazy", OPT_LAZY, false},
+    {"--list-knots", OPT_LIST_KNOTS, false},
     {"--dump-ast", OPT_DUMP_AST, false},
+    {"--check", OPT_CHECK, false},
+    {"--profile-parser", OPT_PROFILE_PARSER, true},
+    {"--trace-file", OPT_TRACE_FILE, true},
+    {"--decode-trace", OPT_DECODE_TRACE, true},
+    {"--reparse", OPT_REPARSE, true},
+    {"--session", OPT_SESSION, true},
     {"--help", OPT_HELP, false},
     {"-h", OPT_HELP, false},
 
     {"--arg-example", OPT_ARG_EXAMPLE, true},
 
-    (struct option){0},
+    {0},
 };
 
 static const char *USAGE_MSG = "Usage: %s [OPTION]... [FILE]\n"
@@ -38,28 +64,133 @@ static const char *USAGE_MSG = "Usage: %s [OPTION]... [FILE]\n"
                                "  -h, --help       Print this message\n"
                                "  --colors         Enable color output\n"
                                "  --tracing        Enable tracing\n"
+                               "  --trace-file FILE\n"
+                               "                   Save the trace to FILE\n"
+                               "  --decode-trace FILE\n"
+                               "                   Print a saved trace\n"
                                "  --caching        Enable caching\n"
-                               "  --dump-ast       Dump a source file's AST\n";
+                               "  --cache-limit BYTES\n"
+                               "                   Limit the cache to BYTES\n"
+                               "  --buffering      Enable token buffering\n"
+                               "  --prelex         Lex in parallel before "
+                               "parsing\n"
+                               "  --parallel       Parse knots in parallel\n"
+                               "  --lazy           Leave the bodies of knots "
+                               "unparsed\n"
+                               "  --list-knots     List the knots, stitches, "
+                               "functions and\n"
+                               "                   globals of a source file\n"
+                               "  --dump-ast       Dump a source file's AST\n"
+                               "  --check          Only check a source file "
+                               "for syntax errors\n"
+                               "  --profile-parser FILE\n"
+                               "                   Print time spent in each "
+                               "grammar rule, and\n"
+                               "                   write collapsed stacks to "
+                               "FILE\n"
+                               "  --reparse FILE   Parse FILE, then parse the "
+                               "source file\n"
+                               "                   incrementally as an edit "
+                               "of it\n"
+                               "  --session FILE   Parse FILE, then parse the "
+                               "source file with\n"
+                               "                   the same parse session\n";
 
 static void print_usage(const char *name)
 {
     fprintf(stderr, USAGE_MSG, name);
 }
 
+/**
+ * Parse an earlier version of a source, then parse the source incrementally
+ * from its syntax tree. Everything between the longest common prefix and
+ * suffix of the two is taken as a single edit.
+ */
+static int parse_edited(struct ink_arena *arena, struct ink_source *previous,
+                        struct ink_source *source,
+                        struct ink_syntax_tree *syntax_tree, int flags)
+{
+    struct ink_parse_edit edit;
+    size_t prefix = 0;
+    size_t suffix = 0;
+
+    while (prefix < previous->length && prefix < source->length &&
+           previous->bytes[prefix] == source->bytes[prefix]) {
+        prefix++;
+    }
+    while (suffix < previous->length - prefix &&
+           suffix < source->length - prefix &&
+           previous->bytes[previous->length - suffix - 1] ==
+               source->bytes[source->length - suffix - 1]) {
+        suffix++;
+    }
+
+    edit.start_offset = prefix;
+    edit.old_length = previous->length - prefix - suffix;
+    edit.new_length = source->length - prefix - suffix;
+
+    ink_syntax_tree_initialize(previous, syntax_tree);
+    if (ink_parse(arena, previous, syntax_tree, flags) ==
+        -INK_E_FILE_ENCODING) {
+        ink_syntax_tree_initialize(source, syntax_tree);
+        return ink_parse(arena, source, syntax_tree, flags);
+    }
+    return ink_parse_incremental(arena, source, syntax_tree, flags, &edit, 1);
+}
+
+/**
+ * Print the offset, line, type and name of every declaration in a source,
+ * as found by the pre-scanner, one per line.
+ */
+static void print_boundaries(const struct ink_source *source)
+{
+    struct ink_boundary_table table;
+    struct ink_source_lines lines;
+
+    ink_boundary_table_create(&table);
+    ink_source_lines_initialize(&lines);
+    ink_prescan(source, &table);
+
+    for (size_t i = 0; i < table.count; i++) {
+        const struct ink_boundary *boundary = &table.entries[i];
+
+        printf("%zu\t%zu\t%s\t%.*s\n", (size_t)boundary->offset,
+               ink_source_line(source, &lines, boundary->offset) + 1,
+               ink_boundary_type_strz(boundary->type),
+               (int)boundary->name_length,
+               source->bytes + boundary->name_offset);
+    }
+
+    ink_source_lines_cleanup(&lines);
+    ink_boundary_table_destroy(&table);
+}
+
 int main(int argc, char *argv[])
 {
     static const size_t arena_alignment = 8;
     static const size_t arena_block_size = 8192;
-    const char *filename;
+    const char *filename = NULL;
+    const char *profile_filename = NULL;
+    const char *trace_filename = NULL;
+    const char *previous_filename = NULL;
+    const char *session_filename = NULL;
+    FILE *profile_stacks = NULL;
+    FILE *trace = NULL;
+    struct ink_parse_session *session = NULL;
     struct ink_arena arena;
     struct ink_source source;
+    struct ink_source previous;
     struct ink_syntax_tree syntax_tree;
+    size_t offset;
     int rc;
     int flags = 0;
     int opt = 0;
     bool colors = false;
     bool dump_ast = false;
+    bool check = false;
+    bool list_knots = false;
 
+    ink_simd_initialize();
     option_setopts(opts, argv);
 
     while ((opt = option_nextopt())) {
@@ -76,10 +207,76 @@ int main(int argc, char *argv[])
             flags |= INK_PARSER_F_CACHING;
             break;
         }
+        case OPT_CACHE_LIMIT: {
+            const char *arg = option_nextarg();
+            char *end;
+            const unsigned long long bytes = strtoull(arg, &end, 10);
+
+            if (*arg < '0' || *arg > '9' || *end != '\0') {
+                fprintf(stderr, "Invalid cache limit %s.\n\n", arg);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            ink_parse_set_cache_limit((size_t)bytes);
+            break;
+        }
+        case OPT_BUFFERING: {
+            flags |= INK_PARSER_F_BUFFERING;
+            break;
+        }
+        case OPT_PRELEXING: {
+            flags |= INK_PARSER_F_PRELEXING;
+            break;
+        }
+        case OPT_PARALLEL: {
+            flags |= INK_PARSER_F_PARALLEL;
+            break;
+        }
+        case OPT_LAZY: {
+            flags |= INK_PARSER_F_LAZY;
+            break;
+        }
+        case OPT_LIST_KNOTS: {
+            list_knots = true;
+            break;
+        }
         case OPT_DUMP_AST: {
             dump_ast = true;
             break;
         }
+        case OPT_CHECK: {
+            check = true;
+            break;
+        }
+        case OPT_PROFILE_PARSER: {
+            profile_filename = option_nextarg();
+            flags |= INK_PARSER_F_PROFILING;
+            break;
+        }
+        case OPT_TRACE_FILE: {
+            trace_filename = option_nextarg();
+            flags |= INK_PARSER_F_TRACING;
+            break;
+        }
+        case OPT_DECODE_TRACE: {
+            const char *path = option_nextarg();
+
+            trace = fopen(path, "rb");
+            if (trace == NULL) {
+                ink_error("Could not open file `%s`.", path);
+                return EXIT_FAILURE;
+            }
+
+            rc = ink_parse_trace_decode(trace, stdout);
+            fclose(trace);
+
+            if (rc < 0) {
+                ink_error("Could not read `%s`. Not a trace.", path);
+                return EXIT_FAILURE;
+            }
+            return EXIT_SUCCESS;
+        }
         case OPTION_UNKNOWN: {
             fprintf(stderr, "Unrecognised option %s.\n\n", option_unknown_opt);
             print_usage(argv[0]);
@@ -92,6 +289,14 @@ int main(int argc, char *argv[])
             }
             break;
         }
+        case OPT_REPARSE: {
+            previous_filename = option_nextarg();
+            break;
+        }
+        case OPT_SESSION: {
+            session_filename = option_nextarg();
+            break;
+        }
         case OPT_HELP: {
             print_usage(argv[0]);
             return EXIT_SUCCESS;
@@ -106,26 +311,53 @@ int main(int argc, char *argv[])
         }
     }
 
-    if (filename == NULL || *filename == '\0') {
+    if (check && dump_ast) {
+        fprintf(stderr, "Options --check and --dump-ast cannot be used "
+                        "together.\n\n");
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if ((filename == NULL || *filename == '\0') &&
+        (list_knots || previous_filename)) {
         rc = ink_source_load_stdin(&source);
+    } else if (filename == NULL || *filename == '\0') {
+        rc = ink_source_stream_stdin(&source);
     } else {
         rc = ink_source_load(filename, &source);
     }
     if (rc < 0) {
         switch (-rc) {
         case INK_E_OS: {
-            ink_error("[ERROR] Could not open file `%s`. OS Error.", filename);
+            ink_error("Could not open file `%s`. OS Error.", filename);
             break;
         }
         case INK_E_FILE: {
-            ink_error("[ERROR] Could not open file `%s`. Not an ink script.",
+            ink_error("Could not open file `%s`. Not an ink script.",
+                      filename);
+            break;
+        }
+        case INK_E_FILE_SIZE: {
+            ink_error("Could not open file `%s`. File too large.",
                       filename);
             break;
         }
         default:
-            ink_error("[ERROR] Unknown error.");
+            ink_error("Unknown error.");
             break;
         }
+        return EXIT_FAILURE;
+    }
+    if (list_knots) {
+        if (ink_source_validate(&source, &offset) < 0) {
+            ink_error("Could not read `%s`. Not valid UTF-8 at offset %zu.",
+                      source.filename, offset);
+            ink_source_free(&source);
+            return EXIT_FAILURE;
+        }
+
+        print_boundaries(&source);
+        ink_source_free(&source);
+        return EXIT_SUCCESS;
     }
 
     ink_arena_initialize(&arena, arena_block_size, arena_alignment);
@@ -135,15 +367,89 @@ int main(int argc, char *argv[])
         goto cleanup;
     }
 
-    ink_parse(&arena, &source, &syntax_tree, flags);
+    if (trace_filename) {
+        trace = fopen(trace_filename, "wb");
+        if (trace == NULL) {
+            ink_error("Could not open file `%s`.", trace_filename);
+            rc = -INK_E_OS;
+            goto cleanup;
+        }
+
+        rc = ink_parse_trace(&arena, &source, &syntax_tree, flags, trace);
+        fclose(trace);
+    } else if (flags & INK_PARSER_F_PROFILING) {
+        profile_stacks = fopen(profile_filename, "w");
+        if (profile_stacks == NULL) {
+            ink_error("Could not open file `%s`.", profile_filename);
+            rc = -INK_E_OS;
+            goto cleanup;
+        }
+
+        rc = ink_parse_profile(&arena, &source, &syntax_tree, flags, stdout,
+                               profile_stacks);
+        fclose(profile_stacks);
+    } else if (previous_filename) {
+        rc = ink_source_load(previous_filename, &previous);
+        if (rc < 0) {
+            ink_error("Could not open file `%s`.", previous_filename);
+            goto cleanup;
+        }
+
+        rc = parse_edited(&arena, &previous, &source, &syntax_tree, flags);
+        ink_source_free(&previous);
+    } else if (session_filename) {
+        rc = ink_source_load(session_filename, &previous);
+        if (rc < 0) {
+            ink_error("Could not open file `%s`.", session_filename);
+            goto cleanup;
+        }
+
+        session = ink_parse_session_new();
+        if (session == NULL) {
+            ink_source_free(&previous);
+            rc = -INK_E_OOM;
+            goto cleanup;
+        }
+
+        ink_syntax_tree_initialize(&previous, &syntax_tree);
+        ink_parse_session_parse(session, &previous, &syntax_tree, flags);
+        ink_syntax_tree_initialize(&source, &syntax_tree);
+        rc = ink_parse_session_parse(session, &source, &syntax_tree, flags);
+        ink_source_free(&previous);
+    } else if (check) {
+        rc = ink_parse_events(&arena, &source, flags, NULL);
+    } else {
+        rc = ink_parse(&arena, &source, &syntax_tree, flags);
+    }
+    if (rc == -INK_E_FILE_ENCODING) {
+        ink_source_validate(&source, &offset);
+        ink_error("Could not read `%s`. Not valid UTF-8 at offset %zu.",
+                  source.filename, offset);
+        goto cleanup;
+    }
+    /* Syntax errors have been reported, and only fail a check. */
+    if (!check) {
+        rc = INK_E_OK;
+    }
 
     if (dump_ast) {
+        /* Lazy blocks are dumped as they parse, or the file in full. */
+        if (ink_syntax_tree_bodies(&syntax_tree) < 0) {
+            ink_syntax_tree_initialize(&source, &syntax_tree);
+            ink_parse(&arena, &source, &syntax_tree,
+                      flags & ~INK_PARSER_F_LAZY);
+        }
+
         ink_syntax_tree_print(&syntax_tree, colors);
     }
 cleanup:
     ink_syntax_tree_cleanup(&syntax_tree);
+    if (session) {
+        ink_parse_session_free(session);
+    }
+
     ink_arena_release(&arena);
     ink_source_free(&source);
 
-    return EXIT_SUCCESS;
+    return rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -63,6 +63,11 @@ char *option_nextarg(void) {
         char *arg = _g_arg_ptr;
         char *arg_p = arg;
 
+        // the option was the last on the command line
+        if (arg == NULL) {
+                return "";
+        }
+
         while (*arg_p != '\0' && *arg_p != ',') {
                 ++arg_p;
         }
@@ -1,6 +1,9 @@
 #include <assert.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -9,7 +12,9 @@
 #include "logging.h"
 #include "parse.h"
 #include "platform.h"
+#include "prescan.h"
 #include "scanner.h"
+#include "simd.h"
 #include "token.h"
 #include "tree.h"
 #include "vec.h"
@@ -21,6 +26,57 @@
 #define INK_PARSER_CACHE_SCALE_FACTOR INK_HASHTABLE_SCALE_FACTOR
 #define INK_PARSER_CACHE_LOAD_MAX INK_HASHTABLE_LOAD_MAX
 #define INK_PARSER_CACHE_MIN_CAPACITY INK_HASHTABLE_MIN_CAPACITY
+#define INK_PARSER_TRACE_MAGIC "INKTRACE"
+#define INK_PARSER_TRACE_VERSION 2u
+#define INK_PARSER_MEMO_SAMPLE_SIZE 256
+#define INK_PARSER_MEMO_HIT_RATIO 16
+
+/*
+ * Number of events kept by the tracer, which must be a power of two.
+ */
+#ifndef INK_PARSER_TRACE_EVENTS
+#define INK_PARSER_TRACE_EVENTS 65536u
+#endif
+
+/*
+ * Number of tokens looked ahead at to decide between productions, first
+ * and at most. Most decisions are made within the first few tokens.
+ */
+#define INK_PARSER_LOOKAHEAD_MIN 8
+#define INK_PARSER_LOOKAHEAD_MAX 32
+
+/*
+ * Smallest share of the source given to each worker when parsing in
+ * parallel, in bytes.
+ */
+#ifndef INK_PARSER_REGION_MIN
+#define INK_PARSER_REGION_MIN (64u * 1024u)
+#endif
+
+/*
+ * Number of errors kept by each parser to be reported. Any more are only
+ * counted.
+ */
+#ifndef INK_PARSER_ERROR_LIMIT
+#define INK_PARSER_ERROR_LIMIT 100u
+#endif
+
+/*
+ * Upper bound on the size of the parser's memoization table, in bytes,
+ * unless set otherwise with `ink_parse_set_cache_limit`.
+ */
+#ifndef INK_PARSER_CACHE_LIMIT
+#define INK_PARSER_CACHE_LIMIT (64u * 1024u * 1024u)
+#endif
+
+/*
+ * Size of the blocks of a parse session's arena, and the alignment of its
+ * allocations.
+ */
+#ifndef INK_PARSE_SESSION_BLOCK_SIZE
+#define INK_PARSE_SESSION_BLOCK_SIZE 8192u
+#endif
+#define INK_PARSE_SESSION_ALIGNMENT 8u
 
 #define INK_VA_ARGS_NTH(_1, _2, _3, _4, _5, N, ...) N
 #define INK_VA_ARGS_COUNT(...) INK_VA_ARGS_NTH(__VA_ARGS__, 5, 4, 3, 2, 1, 0)
@@ -41,27 +97,64 @@
 #define INK_DISPATCH(func, ...)                                                \
     INK_DISPATCHER(func, INK_VA_ARGS_COUNT(__VA_ARGS__), __VA_ARGS__)
 
-#define INK_PARSER_TRACE(node, rule, ...)                                      \
+/*
+ * Tracing is compiled out entirely when INK_PARSER_NO_TRACING is defined,
+ * and INK_PARSER_F_TRACING is then ignored.
+ */
+#ifdef INK_PARSER_NO_TRACING
+#define INK_PARSER_TRACE_EVENT(kind, rule)                                     \
+    do {                                                                       \
+    } while (0)
+#else
+#define INK_PARSER_TRACE_EVENT(kind, rule)                                     \
     do {                                                                       \
         if (parser->flags & INK_PARSER_F_TRACING) {                            \
-            ink_parser_trace(parser, #rule);                                   \
+            ink_parser_trace(parser, kind, rule);                              \
+        }                                                                      \
+    } while (0)
+#endif
+
+#define INK_PARSER_TRACE(node, rule, ...)                                      \
+    INK_PARSER_TRACE_EVENT(INK_PARSER_TRACE_ENTER, INK_PARSER_RULE_ID(rule))
+
+/*
+ * Failed assertions flush the trace before aborting, as it leads up to the
+ * failure.
+ */
+#if defined(NDEBUG) || defined(INK_PARSER_NO_TRACING)
+#define INK_PARSER_ASSERT(expr) assert(expr)
+#else
+#define INK_PARSER_ASSERT(expr)                                                \
+    do {                                                                       \
+        if (!(expr) && (parser->flags & INK_PARSER_F_TRACING)) {               \
+            ink_parser_trace_flush(parser);                                    \
         }                                                                      \
+        assert(expr);                                                          \
     } while (0)
+#endif
 
 #define INK_PARSER_MEMOIZE(node, rule, ...)                                    \
     do {                                                                       \
         int rc;                                                                \
         const size_t source_offset = parser->current_offset;                   \
                                                                                \
-        if (parser->flags & INK_PARSER_F_CACHING) {                            \
+        if ((parser->flags & INK_PARSER_F_CACHING) &&                          \
+            ink_parser_cache_is_enabled(&parser->cache,                        \
+                                        INK_PARSER_RULE_ID(rule))) {           \
             rc = ink_parser_cache_lookup(&parser->cache, source_offset,        \
-                                         (void *)rule, &node);                 \
+                                         INK_PARSER_RULE_ID(rule), &node);     \
+            ink_parser_cache_sample(&parser->cache, INK_PARSER_RULE_ID(rule),  \
+                                    rc >= 0);                                  \
             if (rc < 0) {                                                      \
                 node = INK_DISPATCH(rule, __VA_ARGS__);                        \
                 ink_parser_cache_insert(&parser->cache, source_offset,         \
-                                        (void *)rule, node);                   \
+                                        INK_PARSER_RULE_ID(rule), node);       \
             } else {                                                           \
-                ink_trace("Parser cache hit!");                                \
+                if (parser->flags & INK_PARSER_F_PROFILING) {                  \
+                    ink_parser_profile_hit(&parser->profile);                  \
+                }                                                              \
+                INK_PARSER_TRACE_EVENT(INK_PARSER_TRACE_CACHE_HIT,             \
+                                       INK_PARSER_RULE_ID(rule));              \
                 parser->current_offset = node->end_offset;                     \
                 ink_parser_advance(parser);                                    \
             }                                                                  \
@@ -70,41 +163,391 @@
         }                                                                      \
     } while (0)
 
+#define INK_PARSER_PROFILE(node, rule, ...)                                    \
+    do {                                                                       \
+        if (parser->flags & INK_PARSER_F_PROFILING) {                          \
+            ink_parser_profile_enter(&parser->profile,                         \
+                                     INK_PARSER_RULE_ID(rule));                \
+            INK_PARSER_MEMOIZE(node, rule, __VA_ARGS__);                       \
+            ink_parser_profile_exit(&parser->profile);                         \
+        } else {                                                               \
+            INK_PARSER_MEMOIZE(node, rule, __VA_ARGS__);                       \
+        }                                                                      \
+    } while (0)
+
 #define INK_PARSER_RULE(node, rule, ...)                                       \
     do {                                                                       \
         INK_PARSER_TRACE(node, rule, __VA_ARGS__);                             \
-        INK_PARSER_MEMOIZE(node, rule, __VA_ARGS__);                           \
+        INK_PARSER_PROFILE(node, rule, __VA_ARGS__);                           \
     } while (0)
 
+/*
+ * Rules invoked through INK_PARSER_RULE, along with their memoization
+ * policy. Each is numbered, starting from one, so that memoized results can
+ * be keyed by a small integer.
+ *
+ * Rules that are ALWAYS memoized are those that can be reached again from
+ * the same offset after a rewind. NEVER is for rules that are cheaper to
+ * run again than to look up, or that are only reached once per offset.
+ * ADAPTIVE rules are sampled, and memoized only if they are hit often
+ * enough to pay for their entries.
+ */
+#define INK_PARSER_RULES(T)                                                    \
+    T(ink_parse_argument_list, ADAPTIVE)                                       \
+    T(ink_parse_choice, NEVER)                                                 \
+    T(ink_parse_choice_content, ADAPTIVE)                                      \
+    T(ink_parse_conditional, ADAPTIVE)                                         \
+    T(ink_parse_conditional_branch, ADAPTIVE)                                  \
+    T(ink_parse_const_decl, NEVER)                                             \
+    T(ink_parse_content_expr, ALWAYS)                                          \
+    T(ink_parse_content_stmt, NEVER)                                           \
+    T(ink_parse_divert, ADAPTIVE)                                              \
+    T(ink_parse_divert_or_tunnel, ADAPTIVE)                                    \
+    T(ink_parse_divert_stmt, NEVER)                                            \
+    T(ink_parse_expr, ALWAYS)                                                  \
+    T(ink_parse_false, NEVER)                                                  \
+    T(ink_parse_gather, NEVER)                                                 \
+    T(ink_parse_identifier, NEVER)                                             \
+    T(ink_parse_infix_expr, ADAPTIVE)                                          \
+    T(ink_parse_knot_decl, NEVER)                                              \
+    T(ink_parse_list, ADAPTIVE)                                                \
+    T(ink_parse_list_decl, NEVER)                                              \
+    T(ink_parse_list_element_def, ADAPTIVE)                                    \
+    T(ink_parse_logic_expr, ALWAYS)                                            \
+    T(ink_parse_logic_stmt, NEVER)                                             \
+    T(ink_parse_name_expr, NEVER)                                              \
+    T(ink_parse_number, NEVER)                                                 \
+    T(ink_parse_parameter_list, ADAPTIVE)                                      \
+    T(ink_parse_primary_expr, ADAPTIVE)                                        \
+    T(ink_parse_sequence, ADAPTIVE)                                            \
+    T(ink_parse_stmt, NEVER)                                                   \
+    T(ink_parse_stmt_level, NEVER)                                             \
+    T(ink_parse_string, ALWAYS)                                                \
+    T(ink_parse_string_expr, ADAPTIVE)                                         \
+    T(ink_parse_thread_expr, ADAPTIVE)                                         \
+    T(ink_parse_thread_stmt, NEVER)                                            \
+    T(ink_parse_true, NEVER)                                                   \
+    T(ink_parse_var_decl, NEVER)
+
+#define INK_PARSER_RULE_ID(rule) INK_PARSER_RULE_ID_##rule
+
+#define T(rule, policy) INK_PARSER_RULE_ID(rule),
+enum ink_parser_rule_id {
+    INK_PARSER_RULE_ID_NONE,
+    INK_PARSER_RULES(T) INK_PARSER_RULE_ID_COUNT
+};
+#undef T
+
+#define INK_PARSER_ERRORS(T)                                                   \
+    T(INVALID_PARSE, "Invalid parse!")                                         \
+    T(UNEXPECTED_TOKEN, "Unexpected token!")                                   \
+    T(EXPECTED_NEW_LINE, "Expected new line!")                                 \
+    T(TOO_MANY_ARGUMENTS, "Too many arguments")                                \
+    T(TOO_MANY_PARAMETERS, "Too many parameters")
+
+#define T(name, description) INK_PARSER_E_##name,
+enum ink_parser_error_type {
+    INK_PARSER_ERRORS(T)
+};
+#undef T
+
+#define T(name, description) description,
+static const char *INK_PARSER_ERROR_STR[] = {INK_PARSER_ERRORS(T)};
+#undef T
+
+enum ink_parser_memo_policy {
+    INK_PARSER_MEMO_NEVER,
+    INK_PARSER_MEMO_ALWAYS,
+    INK_PARSER_MEMO_ADAPTIVE,
+};
+
+#define T(rule, policy) [INK_PARSER_RULE_ID(rule)] = INK_PARSER_MEMO_##policy,
+static const unsigned char INK_PARSER_MEMO_POLICY[INK_PARSER_RULE_ID_COUNT] = {
+    INK_PARSER_RULES(T)
+};
+#undef T
+
+#define T(rule, policy) [INK_PARSER_RULE_ID(rule)] = #rule,
+static const char *INK_PARSER_RULE_NAME[INK_PARSER_RULE_ID_COUNT] = {
+    [INK_PARSER_RULE_ID_NONE] = "ink_parse_file",
+    INK_PARSER_RULES(T)
+};
+#undef T
+
 struct ink_parser_context {
     int level;
     size_t scratch_offset;
     size_t source_offset;
 };
 
+enum ink_precedence {
+    INK_PREC_NONE = 0,
+    INK_PREC_ASSIGN,
+    INK_PREC_LOGICAL_OR,
+    INK_PREC_LOGICAL_AND,
+    INK_PREC_COMPARISON,
+    INK_PREC_TERM,
+    INK_PREC_FACTOR,
+};
+
+enum ink_parser_operator_kind {
+    INK_PARSER_OPERATOR_PREFIX,
+    INK_PARSER_OPERATOR_INFIX,
+    INK_PARSER_OPERATOR_GROUP,
+};
+
+/*
+ * An operator whose operand is still being parsed by the expression parser.
+ *
+ * Prefix and infix operators hold the type and start of the node they will
+ * create, and infix operators their left operand. `prec` is the binding
+ * power that the expression around the operator stops at, which is
+ * restored once the operator has been applied. Groups stand for an open
+ * parenthesis.
+ */
+struct ink_parser_operator {
+    enum ink_parser_operator_kind kind;
+    enum ink_syntax_node_type type;
+    enum ink_precedence prec;
+    size_t source_start;
+    struct ink_syntax_node *lhs;
+};
+
+#ifdef INK_PARSER_HASHED_CACHE
 struct ink_parser_cache_key {
     size_t source_offset;
-    void *rule_address;
+    size_t rule;
+};
+#else
+/*
+ * Keys pack the source offset above the rule ID, which fits in the low
+ * byte. Rule IDs start from one, so a key of zero marks an empty slot.
+ */
+#define INK_PARSER_CACHE_RULE_BITS 8
+
+struct ink_parser_cache_key {
+    uint64_t bits;
 };
+#endif
 
 struct ink_parser_cache_entry {
     struct ink_parser_cache_key key;
     struct ink_syntax_node *value;
 };
 
+struct ink_parser_cache_rule {
+    size_t lookups;
+    size_t hits;
+};
+
 /**
  * Parser memoization cache.
  *
- * Cache keys are ordered pairs of (source_offset, rule_address).
+ * Cache keys are ordered pairs of (source_offset, rule), where rules are
+ * identified by their `enum ink_parser_rule_id`. Results are stored in an
+ * open-addressing table keyed by a packed 64-bit integer, or, when
+ * INK_PARSER_HASHED_CACHE is defined, by the pair itself hashed a byte at
+ * a time, as they were originally.
+ *
+ * Each rule starts with the policy given in INK_PARSER_RULES. Adaptive
+ * rules settle on always or never once they have been sampled.
+ *
+ * Once a statement at the top level of the file has been parsed, the parser
+ * never looks behind it again. Its offset is recorded as the floor of the
+ * cache, and entries below it are dropped whenever the table is rebuilt.
+ * The table is never grown past `limit` bytes; rather, it is rebuilt at its
+ * current size, and if that leaves no room, insertions are refused until
+ * the floor moves.
  */
 struct ink_parser_cache {
+    size_t limit;
     size_t count;
     size_t capacity;
+    size_t lookups;
+    size_t hits;
+    size_t evicted;
+    size_t floor_offset;
+    size_t full_offset;
+    bool is_full;
+    unsigned char policy[INK_PARSER_RULE_ID_COUNT];
+    struct ink_parser_cache_rule rules[INK_PARSER_RULE_ID_COUNT];
     struct ink_parser_cache_entry *entries;
 };
 
+/**
+ * Lexing statistics, reported when tracing.
+ *
+ * Bytes are counted as relexed when the scanner lexes them again after
+ * having already moved past them, whether in the same grammar mode or in
+ * another. Bytes replayed from the token buffer would otherwise have been
+ * relexed, and bytes taken from the pre-lexed tokens would otherwise have
+ * been lexed. Bytes looked ahead at are counted apart from all of these, as
+ * they are lexed again once the parser reaches them.
+ */
+struct ink_parser_lex_stats {
+    size_t lexed;
+    size_t relexed;
+    size_t replayed;
+    size_t prelexed;
+    size_t peeked;
+    size_t rewinds;
+    size_t high_water;
+};
+
+struct ink_parser_profile_rule {
+    size_t calls;
+    size_t hits;
+    size_t rewinds;
+    size_t tokens;
+    size_t depth;
+    uint64_t inclusive_ns;
+    uint64_t exclusive_ns;
+};
+
+/*
+ * A distinct path of rule invocations from the start of the file, stored as
+ * a tree of paths with the root at index zero.
+ */
+struct ink_parser_profile_path {
+    enum ink_parser_rule_id rule;
+    size_t parent;
+    size_t first_child;
+    size_t next_sibling;
+    uint64_t exclusive_ns;
+};
+
+struct ink_parser_profile_frame {
+    size_t path;
+    size_t token_count;
+    uint64_t start_ns;
+    uint64_t child_ns;
+    uint64_t overhead_ns;
+};
+
+/*
+ * An error raised by the parser, along with the token it was raised at.
+ * Errors are only described once they are reported, as most are never
+ * looked at again if there are many of them.
+ */
+struct ink_parser_error {
+    enum ink_parser_error_type type;
+    struct ink_token token;
+};
+
 INK_VEC_DECLARE(ink_parser_scratch, struct ink_syntax_node *)
 INK_VEC_DECLARE(ink_parser_context_stack, struct ink_parser_context)
+INK_VEC_DECLARE(ink_parser_operator_stack, struct ink_parser_operator)
+INK_VEC_DECLARE(ink_parser_profile_paths, struct ink_parser_profile_path)
+INK_VEC_DECLARE(ink_parser_profile_frames, struct ink_parser_profile_frame)
+INK_VEC_DECLARE(ink_parser_errors, struct ink_parser_error)
+
+/**
+ * Parser profile, gathered when profiling.
+ *
+ * Each rule invocation pushes a frame, which is timed on the way out.
+ * Exclusive time excludes nested rule invocations. Inclusive time and
+ * tokens are only counted for the outermost invocation of a recursive
+ * rule, so that they are never counted twice. Cache hits and rewinds are
+ * charged to the innermost rule.
+ *
+ * Exclusive time is also accumulated for each path of rules, for output as
+ * collapsed stacks.
+ *
+ * Reading the clock is slow enough, compared to the cheaper rules, to skew
+ * the profile towards them. Its cost is measured when profiling starts, and
+ * subtracted once for each invocation.
+ */
+struct ink_parser_profile {
+    size_t token_count;
+    uint64_t clock_ns;
+    struct ink_parser_profile_rule rules[INK_PARSER_RULE_ID_COUNT];
+    struct ink_parser_profile_paths paths;
+    struct ink_parser_profile_frames frames;
+};
+
+enum ink_parser_trace_kind {
+    INK_PARSER_TRACE_ENTER,
+    INK_PARSER_TRACE_REWIND,
+    INK_PARSER_TRACE_CACHE_HIT,
+};
+
+/*
+ * Pending choice and block counts saturate at the largest value of their
+ * fields. They can only exceed it on pathologically nested input.
+ */
+struct ink_parser_trace_event {
+    ink_offset_t source_offset;
+    unsigned char kind;
+    unsigned char rule;
+    unsigned char token_type;
+    signed char level;
+    unsigned short choices;
+    unsigned short blocks;
+};
+
+/**
+ * Parser tracer.
+ *
+ * Events are written into a ring buffer of fixed size, overwriting the
+ * oldest once it is full, and are only formatted once parsing is finished,
+ * or when a saved trace is decoded. Each parser has its own tracer, so there
+ * is never more than one writer, and never a need for locking.
+ *
+ * The head counts every event recorded, including those overwritten.
+ * Events are saved to the output file if there is one, or else printed to
+ * STDOUT.
+ */
+struct ink_parser_trace {
+    size_t head;
+    struct ink_parser_trace_event *events;
+    FILE *output;
+};
+
+/*
+ * Totals reported after the events of a trace.
+ */
+struct ink_parser_trace_summary {
+    uint64_t lexed;
+    uint64_t relexed;
+    uint64_t replayed;
+    uint64_t prelexed;
+    uint64_t rewinds;
+    uint64_t peeked;
+    uint64_t memo_entries;
+    uint64_t memo_bytes;
+    uint64_t memo_evicted;
+    uint64_t memo_hits;
+    uint64_t memo_lookups;
+};
+
+/*
+ * Header of a saved trace. The event size differs between builds with and
+ * without INK_LARGE_FILES, so traces can only be decoded by a build with the
+ * same layout.
+ */
+struct ink_parser_trace_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t event_size;
+    uint64_t recorded;
+    uint64_t count;
+    struct ink_parser_trace_summary summary;
+};
+
+/*
+ * Where the results of a parse are written, besides the syntax tree. Any of
+ * these may be NULL. When parsing in parallel, up to `jobs` workers are
+ * used, or one for each processor if it is zero. With a `sink`, the syntax
+ * tree is reported to it instead, a statement at a time.
+ */
+struct ink_parser_output {
+    struct ink_parse_stats *stats;
+    FILE *summary;
+    FILE *stacks;
+    FILE *trace;
+    size_t jobs;
+    const struct ink_parse_sink *sink;
+};
 
 /**
  * Ink parsing state.
@@ -122,48 +565,117 @@ INK_VEC_DECLARE(ink_parser_context_stack, struct ink_parser_context)
  * TODO(Brett): Describe expression parsing.
  *
  * TODO(Brett): Add a logger v-table to the parser.
+ *
+ * When reporting events to a sink, the arena is restored to `mark` after
+ * each top-level statement is reported.
  */
 struct ink_parser {
     struct ink_arena *arena;
+    struct ink_arena_mark mark;
+    const struct ink_parse_sink *sink;
     struct ink_scanner scanner;
     struct ink_parser_scratch scratch;
     struct ink_parser_cache cache;
+    struct ink_token_buffer tokens;
+    struct ink_token_buffer prelexed;
+    struct ink_parser_lex_stats stats;
+    struct ink_parser_profile profile;
+    struct ink_parser_trace trace;
+    struct ink_parser_errors errors;
     struct ink_token token;
-    bool panic_mode;
+    size_t errors_dropped;
+    size_t panic_offset;
     int flags;
     int current_level;
     size_t current_offset;
     struct ink_parser_context_stack blocks;
     struct ink_parser_context_stack choices;
+    struct ink_parser_operator_stack operators;
 };
 
-enum ink_precedence {
-    INK_PREC_NONE = 0,
-    INK_PREC_ASSIGN,
-    INK_PREC_LOGICAL_OR,
-    INK_PREC_LOGICAL_AND,
-    INK_PREC_COMPARISON,
-    INK_PREC_TERM,
-    INK_PREC_FACTOR,
+/*
+ * Where a parser stands once it has parsed the declaration of a knot at the
+ * top level, and the declaration itself.
+ */
+struct ink_parser_resume {
+    enum ink_syntax_node_type type;
+    size_t start_offset;
+    size_t end_offset;
+    size_t cursor_offset;
+    size_t current_offset;
+    int current_level;
+    bool is_line_start;
+    size_t mode_depth;
+    struct ink_token token;
+};
+
+/**
+ * A region of the source parsed by a worker when parsing in parallel.
+ *
+ * Every region but the first starts at the declaration of a knot at the
+ * top level of the file, where no choices or blocks other than the file's
+ * own can be left open. Each worker has its own parser and arena, and
+ * parses from the start of its region up to and including the knot
+ * declaration that starts the next, so that choices and blocks are closed
+ * there exactly as in a serial parse. That declaration is then dropped, as
+ * it belongs to the next region.
+ *
+ * The regions are only stitched together if each worker ended exactly
+ * where the next one started, in the same state. Errors are deferred until
+ * then, so that they can be reported in source order.
+ */
+struct ink_parser_region {
+    size_t start_offset;
+    size_t end_offset;
+    bool is_valid;
+    struct ink_parser_resume start;
+    struct ink_parser_resume end;
+    struct ink_arena arena;
+    struct ink_parser parser;
 };
 
 static struct ink_syntax_node *
-ink_parse_content_expr(struct ink_parser *, const enum ink_token_type *);
+ink_parse_content_expr(struct ink_parser *, ink_token_set);
 static struct ink_syntax_node *ink_parse_content_stmt(struct ink_parser *);
 static struct ink_syntax_node *ink_parse_primary_expr(struct ink_parser *);
-static struct ink_syntax_node *ink_parse_infix_expr(struct ink_parser *,
-                                                    struct ink_syntax_node *,
-                                                    enum ink_precedence);
+static struct ink_syntax_node *ink_parse_infix_expr(struct ink_parser *);
 static struct ink_syntax_node *ink_parse_divert_stmt(struct ink_parser *);
 static struct ink_syntax_node *ink_parse_stmt(struct ink_parser *parser);
 static struct ink_syntax_node *ink_parse_logic_expr(struct ink_parser *);
 static struct ink_syntax_node *ink_parse_argument_list(struct ink_parser *);
 
-static void ink_parser_cache_initialize(struct ink_parser_cache *cache)
+/*
+ * Limit on the size of the memoization table of parsers started from now on.
+ */
+static size_t ink_parser_cache_limit = INK_PARSER_CACHE_LIMIT;
+
+/*
+ * Empty the cache for another parse, keeping its table.
+ */
+static void ink_parser_cache_reset(struct ink_parser_cache *cache)
 {
+    if (cache->entries) {
+        memset(cache->entries, 0, sizeof(*cache->entries) * cache->capacity);
+    }
+
+    cache->limit = ink_parser_cache_limit;
     cache->count = 0;
+    cache->lookups = 0;
+    cache->hits = 0;
+    cache->evicted = 0;
+    cache->floor_offset = 0;
+    cache->full_offset = 0;
+    cache->is_full = false;
+
+    memcpy(cache->policy, INK_PARSER_MEMO_POLICY, sizeof(cache->policy));
+    memset(cache->rules, 0, sizeof(cache->rules));
+}
+
+static void ink_parser_cache_initialize(struct ink_parser_cache *cache)
+{
     cache->capacity = 0;
     cache->entries = NULL;
+    ink_parser_cache_reset(cache);
 }
 
 static void ink_parser_cache_cleanup(struct ink_parser_cache *cache)
@@ -175,6 +687,32 @@ static void ink_parser_cache_cleanup(struct ink_parser_cache *cache)
     }
 }
 
+static inline size_t ink_parser_cache_next_size(struct ink_parser_cache *cache)
+{
+    if (cache->capacity < INK_PARSER_CACHE_MIN_CAPACITY) {
+        return INK_PARSER_CACHE_MIN_CAPACITY;
+    } else {
+        return cache->capacity * INK_PARSER_CACHE_SCALE_FACTOR;
+    }
+}
+
+static inline bool ink_parser_cache_needs_resize(struct ink_parser_cache *cache)
+{
+    return (float)(cache->count + 1) >
+           ((float)cache->capacity * INK_PARSER_CACHE_LOAD_MAX);
+}
+
+#ifdef INK_PARSER_HASHED_CACHE
+static inline struct ink_parser_cache_key
+ink_parser_cache_key(size_t source_offset, enum ink_parser_rule_id rule)
+{
+    const struct ink_parser_cache_key key = {
+        .source_offset = source_offset,
+        .rule = rule,
+    };
+    return key;
+}
+
 /**
  * TODO(Brett): Inline?
  */
@@ -192,43 +730,64 @@ static unsigned int ink_parser_cache_key_hash(struct ink_parser_cache_key key)
     return hash;
 }
 
-static inline size_t ink_parser_cache_next_size(struct ink_parser_cache *cache)
+static inline size_t
+ink_parser_cache_key_offset(const struct ink_parser_cache_key *key)
 {
-    if (cache->capacity < INK_PARSER_CACHE_MIN_CAPACITY) {
-        return INK_PARSER_CACHE_MIN_CAPACITY;
-    } else {
-        return cache->capacity * INK_PARSER_CACHE_SCALE_FACTOR;
-    }
+    return key->source_offset;
 }
 
-static inline bool ink_parser_cache_needs_resize(struct ink_parser_cache *cache)
+static inline bool
+ink_parser_cache_entry_is_set(const struct ink_parser_cache_entry *entry)
 {
-    return (float)(cache->count + 1) >
-           ((float)cache->capacity * INK_PARSER_CACHE_LOAD_MAX);
+    return entry->key.rule != INK_PARSER_RULE_ID_NONE;
 }
 
 static inline bool
-ink_parser_cache_entry_is_set(const struct ink_parser_cache_entry *entry)
+ink_parser_cache_key_compare(const struct ink_parser_cache_key *a,
+                             const struct ink_parser_cache_key *b)
+{
+    return (a->source_offset == b->source_offset) &&
+           (a->rule == b->rule);
+}
+#else
+static inline struct ink_parser_cache_key
+ink_parser_cache_key(size_t source_offset, enum ink_parser_rule_id rule)
 {
-    return entry->key.rule_address != NULL;
+    const struct ink_parser_cache_key key = {
+        .bits = ((uint64_t)source_offset << INK_PARSER_CACHE_RULE_BITS) | rule,
+    };
+    return key;
 }
 
-static inline void
-ink_parser_cache_entry_set(struct ink_parser_cache_entry *entry,
-                           const struct ink_parser_cache_key *key,
-                           struct ink_syntax_node *value)
+/**
+ * Fibonacci hashing. Multiplying by 2^64 divided by the golden ratio
+ * mixes every bit of the key into the upper half of the product, so that
+ * neighbouring offsets scatter across the table.
+ */
+static inline size_t ink_parser_cache_key_hash(struct ink_parser_cache_key key)
+{
+    return (size_t)((key.bits * 0x9e3779b97f4a7c15u) >> 32);
+}
+
+static inline size_t
+ink_parser_cache_key_offset(const struct ink_parser_cache_key *key)
+{
+    return (size_t)(key->bits >> INK_PARSER_CACHE_RULE_BITS);
+}
+
+static inline bool
+ink_parser_cache_entry_is_set(const struct ink_parser_cache_entry *entry)
 {
-    memcpy(&entry->key, key, sizeof(*key));
-    entry->value = value;
+    return entry->key.bits != 0;
 }
 
 static inline bool
 ink_parser_cache_key_compare(const struct ink_parser_cache_key *a,
                              const struct ink_parser_cache_key *b)
 {
-    return (a->source_offset == b->source_offset) &&
-           (a->rule_address == b->rule_address);
+    return a->bits == b->bits;
 }
+#endif
 
 static struct ink_parser_cache_entry *
 ink_parser_cache_find_slot(struct ink_parser_cache_entry *entries,
@@ -248,15 +807,19 @@ ink_parser_cache_find_slot(struct ink_parser_cache_entry *entries,
     }
 }
 
-static int ink_parser_cache_resize(struct ink_parser_cache *cache)
+/**
+ * Rebuild the cache with a given capacity, dropping entries below its floor.
+ */
+static int ink_parser_cache_rebuild(struct ink_parser_cache *cache,
+                                    size_t new_capacity)
 {
     size_t new_count = 0;
     const size_t old_capacity = cache->capacity;
-    const size_t new_capacity = ink_parser_cache_next_size(cache);
+    const size_t old_size = sizeof(*cache->entries) * old_capacity;
     const size_t new_size = sizeof(*cache->entries) * new_capacity;
     struct ink_parser_cache_entry *new_entries = NULL;
 
-    new_entries = malloc(new_size);
+    new_entries = platform_mem_alloc(new_size);
     if (new_entries == NULL) {
         return -INK_E_PARSE_PANIC;
     }
@@ -267,17 +830,20 @@ static int ink_parser_cache_resize(struct ink_parser_cache *cache)
         struct ink_parser_cache_entry *dst_entry = NULL;
         const struct ink_parser_cache_entry *src_entry = &cache->entries[index];
 
-        if (ink_parser_cache_entry_is_set(src_entry)) {
+        if (ink_parser_cache_entry_is_set(src_entry) &&
+            ink_parser_cache_key_offset(&src_entry->key) >=
+                cache->floor_offset) {
             dst_entry = ink_parser_cache_find_slot(new_entries, new_capacity,
                                                    src_entry->key);
-            dst_entry->key = src_entry->key;
-            dst_entry->value = src_entry->value;
+            *dst_entry = *src_entry;
             new_count++;
         }
     }
+    if (cache->entries) {
+        platform_mem_dealloc(cache->entries, old_size);
+    }
 
-    free(cache->entries);
-
+    cache->evicted += cache->count - new_count;
     cache->count = new_count;
     cache->capacity = new_capacity;
     cache->entries = new_entries;
@@ -285,60 +851,548 @@ static int ink_parser_cache_resize(struct ink_parser_cache *cache)
 }
 
 /**
- * Lookup a cached entry by (source_offset, parse_rule) key pair.
+ * Make room for another entry, growing the cache up to its limit, or else
+ * evicting entries below its floor.
  */
-static int ink_parser_cache_lookup(const struct ink_parser_cache *cache,
-                                   size_t source_offset, void *parse_rule,
-                                   struct ink_syntax_node **value)
+static int ink_parser_cache_reserve(struct ink_parser_cache *cache)
 {
-    const struct ink_parser_cache_key key = {
-        .source_offset = source_offset,
-        .rule_address = parse_rule,
-    };
-    struct ink_parser_cache_entry *entry;
+    int rc;
+    const size_t new_capacity = ink_parser_cache_next_size(cache);
 
-    if (cache->count == 0) {
+    if (!ink_parser_cache_needs_resize(cache)) {
+        return INK_E_OK;
+    }
+    if (new_capacity * sizeof(*cache->entries) <= cache->limit) {
+        return ink_parser_cache_rebuild(cache, new_capacity);
+    }
+    if (cache->capacity == 0) {
         return -INK_E_PARSE_PANIC;
     }
-
-    entry = ink_parser_cache_find_slot(cache->entries, cache->capacity, key);
-    if (!ink_parser_cache_entry_is_set(entry)) {
+    if (cache->is_full && cache->full_offset == cache->floor_offset) {
         return -INK_E_PARSE_PANIC;
     }
 
-    *value = entry->value;
-    return INK_E_OK;
+    rc = ink_parser_cache_rebuild(cache, cache->capacity);
+    if (rc < 0) {
+        return rc;
+    }
+
+    cache->is_full = ink_parser_cache_needs_resize(cache);
+    cache->full_offset = cache->floor_offset;
+    return cache->is_full ? -INK_E_PARSE_PANIC : INK_E_OK;
 }
 
 /**
- * Insert an entry into the parser's cache by (source_offset, parse_rule)
- * key pair.
+ * Record that the parser will not look behind a given source offset again.
  */
-int ink_parser_cache_insert(struct ink_parser_cache *cache,
-                            size_t source_offset, void *parse_rule,
-                            struct ink_syntax_node *value)
+static inline void ink_parser_cache_commit(struct ink_parser_cache *cache,
+                                           size_t source_offset)
 {
-    const struct ink_parser_cache_key key = {
-        .source_offset = source_offset,
-        .rule_address = parse_rule,
-    };
-    struct ink_parser_cache_entry *entry;
-
-    if (ink_parser_cache_needs_resize(cache)) {
-        ink_parser_cache_resize(cache);
-    }
+    cache->floor_offset = source_offset;
+}
 
-    entry = ink_parser_cache_find_slot(cache->entries, cache->capacity, key);
-    if (!ink_parser_cache_entry_is_set(entry)) {
-        ink_parser_cache_entry_set(entry, &key, value);
-        cache->count++;
-        return INK_E_OK;
-    }
-    return -INK_E_PARSE_PANIC;
+static inline bool
+ink_parser_cache_is_enabled(const struct ink_parser_cache *cache,
+                            enum ink_parser_rule_id rule)
+{
+    return cache->policy[rule] != INK_PARSER_MEMO_NEVER;
 }
 
-static struct ink_syntax_seq *
-ink_seq_from_scratch(struct ink_arena *arena,
+/**
+ * Count a lookup for a rule, settling the policy of an adaptive rule once
+ * enough lookups have been sampled.
+ */
+static void ink_parser_cache_sample(struct ink_parser_cache *cache,
+                                    enum ink_parser_rule_id rule, bool is_hit)
+{
+    struct ink_parser_cache_rule *stats = &cache->rules[rule];
+
+    stats->lookups++;
+    stats->hits += is_hit;
+
+    if (cache->policy[rule] == INK_PARSER_MEMO_ADAPTIVE &&
+        stats->lookups >= INK_PARSER_MEMO_SAMPLE_SIZE) {
+        if (stats->hits * INK_PARSER_MEMO_HIT_RATIO >= stats->lookups) {
+            cache->policy[rule] = INK_PARSER_MEMO_ALWAYS;
+        } else {
+            cache->policy[rule] = INK_PARSER_MEMO_NEVER;
+        }
+    }
+}
+
+/**
+ * Lookup a cached entry by (source_offset, parse_rule) key pair.
+ */
+static int ink_parser_cache_lookup(struct ink_parser_cache *cache,
+                                   size_t source_offset,
+                                   enum ink_parser_rule_id parse_rule,
+                                   struct ink_syntax_node **value)
+{
+    const struct ink_parser_cache_key key =
+        ink_parser_cache_key(source_offset, parse_rule);
+    struct ink_parser_cache_entry *entry;
+
+    cache->lookups++;
+
+    if (cache->count == 0) {
+        return -INK_E_PARSE_PANIC;
+    }
+
+    entry = ink_parser_cache_find_slot(cache->entries, cache->capacity, key);
+    if (!ink_parser_cache_entry_is_set(entry)) {
+        return -INK_E_PARSE_PANIC;
+    }
+
+    cache->hits++;
+    *value = entry->value;
+    return INK_E_OK;
+}
+
+/**
+ * Insert an entry into the parser's cache by (source_offset, parse_rule)
+ * key pair.
+ */
+static int ink_parser_cache_insert(struct ink_parser_cache *cache,
+                                   size_t source_offset,
+                                   enum ink_parser_rule_id parse_rule,
+                                   struct ink_syntax_node *value)
+{
+    int rc;
+    const struct ink_parser_cache_key key =
+        ink_parser_cache_key(source_offset, parse_rule);
+    struct ink_parser_cache_entry *entry;
+
+    rc = ink_parser_cache_reserve(cache);
+    if (rc < 0) {
+        return rc;
+    }
+
+    entry = ink_parser_cache_find_slot(cache->entries, cache->capacity, key);
+    if (!ink_parser_cache_entry_is_set(entry)) {
+        entry->key = key;
+        entry->value = value;
+        cache->count++;
+        return INK_E_OK;
+    }
+    return -INK_E_PARSE_PANIC;
+}
+
+#define INK_PARSER_PROFILE_CLOCK_SAMPLES 1024
+
+static uint64_t ink_parser_profile_clock_cost(void)
+{
+    const uint64_t start_ns = platform_clock_ns();
+
+    for (size_t i = 1; i < INK_PARSER_PROFILE_CLOCK_SAMPLES; i++) {
+        platform_clock_ns();
+    }
+    return (platform_clock_ns() - start_ns) / INK_PARSER_PROFILE_CLOCK_SAMPLES;
+}
+
+static void ink_parser_profile_initialize(struct ink_parser_profile *profile)
+{
+    const struct ink_parser_profile_path root = {
+        .rule = INK_PARSER_RULE_ID_NONE,
+        .parent = 0,
+        .first_child = 0,
+        .next_sibling = 0,
+        .exclusive_ns = 0,
+    };
+
+    profile->token_count = 0;
+    profile->clock_ns = ink_parser_profile_clock_cost();
+    memset(profile->rules, 0, sizeof(profile->rules));
+    ink_parser_profile_paths_create(&profile->paths);
+    ink_parser_profile_frames_create(&profile->frames);
+    ink_parser_profile_paths_append(&profile->paths, root);
+}
+
+static void ink_parser_profile_cleanup(struct ink_parser_profile *profile)
+{
+    ink_parser_profile_paths_destroy(&profile->paths);
+    ink_parser_profile_frames_destroy(&profile->frames);
+}
+
+static void ink_parser_profile_push(struct ink_parser_profile *profile,
+                                    size_t path)
+{
+    struct ink_parser_profile_rule *stats =
+        &profile->rules[profile->paths.entries[path].rule];
+    const struct ink_parser_profile_frame frame = {
+        .path = path,
+        .token_count = profile->token_count,
+        .start_ns = platform_clock_ns(),
+        .child_ns = 0,
+        .overhead_ns = 0,
+    };
+
+    stats->calls++;
+    stats->depth++;
+    ink_parser_profile_frames_append(&profile->frames, frame);
+}
+
+/**
+ * Start timing the root of the profile, which stands for the time spent
+ * parsing outside of any rule.
+ */
+static void ink_parser_profile_start(struct ink_parser_profile *profile)
+{
+    ink_parser_profile_push(profile, 0);
+}
+
+/**
+ * Start timing an invocation of a rule, following the path to it from the
+ * rule that invoked it.
+ */
+static void ink_parser_profile_enter(struct ink_parser_profile *profile,
+                                     enum ink_parser_rule_id rule)
+{
+    struct ink_parser_profile_paths *paths = &profile->paths;
+    const struct ink_parser_profile_frames *frames = &profile->frames;
+    const size_t parent = frames->entries[frames->count - 1].path;
+    size_t path = paths->entries[parent].first_child;
+
+    while (path != 0 && paths->entries[path].rule != rule) {
+        path = paths->entries[path].next_sibling;
+    }
+    if (path == 0) {
+        const struct ink_parser_profile_path child = {
+            .rule = rule,
+            .parent = parent,
+            .first_child = 0,
+            .next_sibling = paths->entries[parent].first_child,
+            .exclusive_ns = 0,
+        };
+
+        path = paths->count;
+        ink_parser_profile_paths_append(paths, child);
+        paths->entries[parent].first_child = path;
+    }
+
+    ink_parser_profile_push(profile, path);
+}
+
+/**
+ * Stop timing the innermost invocation.
+ */
+static void ink_parser_profile_exit(struct ink_parser_profile *profile)
+{
+    const uint64_t end_ns = platform_clock_ns();
+    struct ink_parser_profile_frame frame;
+    struct ink_parser_profile_frame *parent;
+    struct ink_parser_profile_path *path;
+    struct ink_parser_profile_rule *stats;
+    uint64_t elapsed_ns, exclusive_ns, overhead_ns;
+
+    /* Every exit is paired with an earlier push. */
+    assert(!ink_parser_profile_frames_is_empty(&profile->frames));
+    if (ink_parser_profile_frames_pop(&profile->frames, &frame) < 0) {
+        return;
+    }
+
+    path = &profile->paths.entries[frame.path];
+    stats = &profile->rules[path->rule];
+    overhead_ns = frame.overhead_ns + profile->clock_ns;
+    elapsed_ns = end_ns - frame.start_ns;
+    elapsed_ns = elapsed_ns > overhead_ns ? elapsed_ns - overhead_ns : 0;
+    exclusive_ns =
+        elapsed_ns > frame.child_ns ? elapsed_ns - frame.child_ns : 0;
+
+    path->exclusive_ns += exclusive_ns;
+    stats->exclusive_ns += exclusive_ns;
+    stats->depth--;
+
+    if (stats->depth == 0) {
+        stats->inclusive_ns += elapsed_ns;
+        stats->tokens += profile->token_count - frame.token_count;
+    }
+    if (!ink_parser_profile_frames_is_empty(&profile->frames)) {
+        parent = &profile->frames.entries[profile->frames.count - 1];
+        parent->child_ns += elapsed_ns;
+        parent->overhead_ns += overhead_ns;
+    }
+}
+
+static inline struct ink_parser_profile_rule *
+ink_parser_profile_current(struct ink_parser_profile *profile)
+{
+    const struct ink_parser_profile_frames *frames = &profile->frames;
+    const size_t path = frames->entries[frames->count - 1].path;
+
+    return &profile->rules[profile->paths.entries[path].rule];
+}
+
+static inline void ink_parser_profile_hit(struct ink_parser_profile *profile)
+{
+    ink_parser_profile_current(profile)->hits++;
+}
+
+static inline void
+ink_parser_profile_rewind(struct ink_parser_profile *profile)
+{
+    ink_parser_profile_current(profile)->rewinds++;
+}
+
+static inline bool
+ink_parser_profile_is_before(const struct ink_parser_profile *profile,
+                             size_t a, size_t b)
+{
+    return profile->rules[a].exclusive_ns > profile->rules[b].exclusive_ns;
+}
+
+/**
+ * Write a table of the rules that were invoked, ordered by the time spent
+ * in them, exclusive of the rules they invoked.
+ */
+static void
+ink_parser_profile_write_summary(const struct ink_parser_profile *profile,
+                                 FILE *stream)
+{
+    const double total_ms =
+        (double)profile->rules[INK_PARSER_RULE_ID_NONE].inclusive_ns / 1e6;
+    size_t order[INK_PARSER_RULE_ID_COUNT];
+    size_t count = 0;
+
+    for (size_t rule = 0; rule < INK_PARSER_RULE_ID_COUNT; rule++) {
+        if (profile->rules[rule].calls > 0) {
+            order[count++] = rule;
+        }
+    }
+    /* Insertion sort, as there are only a few dozen rules. */
+    for (size_t i = 1; i < count; i++) {
+        const size_t rule = order[i];
+        size_t j = i;
+
+        while (j > 0 && ink_parser_profile_is_before(profile, rule,
+                                                     order[j - 1])) {
+            order[j] = order[j - 1];
+            j--;
+        }
+
+        order[j] = rule;
+    }
+
+    fprintf(stream, "%-30s %9s %8s %8s %9s %10s %10s %6s\n", "rule", "calls",
+            "hits", "rewinds", "tokens", "incl ms", "excl ms", "excl%");
+
+    for (size_t i = 0; i < count; i++) {
+        const struct ink_parser_profile_rule *stats =
+            &profile->rules[order[i]];
+        const double inclusive_ms = (double)stats->inclusive_ns / 1e6;
+        const double exclusive_ms = (double)stats->exclusive_ns / 1e6;
+
+        fprintf(stream, "%-30s %9zu %8zu %8zu %9zu %10.3f %10.3f %5.1f%%\n",
+                INK_PARSER_RULE_NAME[order[i]], stats->calls, stats->hits,
+                stats->rewinds, stats->tokens, inclusive_ms, exclusive_ms,
+                total_ms > 0.0 ? 100.0 * exclusive_ms / total_ms : 0.0);
+    }
+}
+
+static void
+ink_parser_profile_write_path(const struct ink_parser_profile *profile,
+                              size_t path, FILE *stream)
+{
+    const struct ink_parser_profile_path *node = &profile->paths.entries[path];
+
+    if (path != 0) {
+        ink_parser_profile_write_path(profile, node->parent, stream);
+        fputc(';', stream);
+    }
+
+    fputs(INK_PARSER_RULE_NAME[node->rule], stream);
+}
+
+/**
+ * Write the exclusive time spent in each path of rules, in nanoseconds, as
+ * collapsed stacks, with one path per line and its rules separated by
+ * semicolons. This is the format read by flamegraph.pl and speedscope.
+ */
+static void
+ink_parser_profile_write_stacks(const struct ink_parser_profile *profile,
+                                FILE *stream)
+{
+    for (size_t path = 0; path < profile->paths.count; path++) {
+        const uint64_t exclusive_ns = profile->paths.entries[path].exclusive_ns;
+
+        if (exclusive_ns > 0) {
+            ink_parser_profile_write_path(profile, path, stream);
+            fprintf(stream, " %llu\n", (unsigned long long)exclusive_ns);
+        }
+    }
+}
+
+static void ink_parser_trace_initialize(struct ink_parser_trace *trace)
+{
+    const size_t size = sizeof(*trace->events) * INK_PARSER_TRACE_EVENTS;
+
+    trace->head = 0;
+    trace->events = platform_mem_alloc(size);
+    trace->output = NULL;
+}
+
+static void ink_parser_trace_cleanup(struct ink_parser_trace *trace)
+{
+    const size_t size = sizeof(*trace->events) * INK_PARSER_TRACE_EVENTS;
+
+    if (trace->events) {
+        platform_mem_dealloc(trace->events, size);
+    }
+}
+
+/**
+ * Print a tracing event in human-readable form.
+ */
+static int ink_parser_trace_print(const struct ink_parser_trace_event *event,
+                                  FILE *stream)
+{
+    const size_t source_offset = event->source_offset;
+
+    if (event->rule >= INK_PARSER_RULE_ID_COUNT ||
+        event->token_type > INK_TT_ERROR) {
+        return -INK_E_FILE;
+    }
+    switch (event->kind) {
+    case INK_PARSER_TRACE_ENTER:
+        fprintf(stream,
+                "[TRACE] Entering %s(PendingChoices=%u, PendingBlocks=%u, "
+                "TokenType=%s, SourceOffset: %zu, Level: %d)\n",
+                INK_PARSER_RULE_NAME[event->rule], event->choices,
+                event->blocks, ink_token_type_strz(event->token_type),
+                source_offset, event->level);
+        break;
+    case INK_PARSER_TRACE_REWIND:
+        fprintf(stream, "[TRACE] Rewinding scanner to %zu\n", source_offset);
+        break;
+    case INK_PARSER_TRACE_CACHE_HIT:
+        fprintf(stream, "[TRACE] Parser cache hit!\n");
+        break;
+    default:
+        return -INK_E_FILE;
+    }
+    return INK_E_OK;
+}
+
+static void ink_parser_trace_print_dropped(uint64_t recorded, uint64_t count,
+                                           FILE *stream)
+{
+    if (recorded > count) {
+        fprintf(stream, "[TRACE] Dropped %llu earlier events\n",
+                (unsigned long long)(recorded - count));
+    }
+}
+
+static void
+ink_parser_trace_print_summary(const struct ink_parser_trace_summary *summary,
+                               FILE *stream)
+{
+    fprintf(stream,
+            "[TRACE] Lexed %llu bytes, relexed %llu, replayed %llu from the "
+            "token buffer, took %llu pre-lexed\n",
+            (unsigned long long)summary->lexed,
+            (unsigned long long)summary->relexed,
+            (unsigned long long)summary->replayed,
+            (unsigned long long)summary->prelexed);
+    fprintf(stream,
+            "[TRACE] Rewound the scanner %llu times, peeked at %llu bytes\n",
+            (unsigned long long)summary->rewinds,
+            (unsigned long long)summary->peeked);
+    fprintf(stream,
+            "[TRACE] Memoized %llu results in %llu bytes, evicted %llu, %llu "
+            "hits from %llu lookups\n",
+            (unsigned long long)summary->memo_entries,
+            (unsigned long long)summary->memo_bytes,
+            (unsigned long long)summary->memo_evicted,
+            (unsigned long long)summary->memo_hits,
+            (unsigned long long)summary->memo_lookups);
+}
+
+static inline size_t
+ink_parser_trace_count_kept(const struct ink_parser_trace *trace)
+{
+    return trace->head < INK_PARSER_TRACE_EVENTS ? trace->head
+                                                 : INK_PARSER_TRACE_EVENTS;
+}
+
+/**
+ * Print the events kept by the tracer, from oldest to newest.
+ */
+static void ink_parser_trace_print_all(const struct ink_parser_trace *trace,
+                                       FILE *stream)
+{
+    const size_t count = ink_parser_trace_count_kept(trace);
+
+    ink_parser_trace_print_dropped(trace->head, count, stream);
+
+    for (size_t i = trace->head - count; i < trace->head; i++) {
+        ink_parser_trace_print(
+            &trace->events[i & (INK_PARSER_TRACE_EVENTS - 1)], stream);
+    }
+}
+
+/**
+ * Save the events kept by the tracer, from oldest to newest, along with the
+ * summary that follows them.
+ */
+static int
+ink_parser_trace_write(const struct ink_parser_trace *trace,
+                       const struct ink_parser_trace_summary *summary,
+                       FILE *stream)
+{
+    const size_t count = ink_parser_trace_count_kept(trace);
+    const size_t start = (trace->head - count) & (INK_PARSER_TRACE_EVENTS - 1);
+    const size_t first_count = count < INK_PARSER_TRACE_EVENTS - start
+                                   ? count
+                                   : INK_PARSER_TRACE_EVENTS - start;
+    struct ink_parser_trace_header header = {
+        .version = INK_PARSER_TRACE_VERSION,
+        .event_size = sizeof(*trace->events),
+        .recorded = trace->head,
+        .count = count,
+        .summary = *summary,
+    };
+
+    memcpy(header.magic, INK_PARSER_TRACE_MAGIC, sizeof(header.magic));
+    fwrite(&header, sizeof(header), 1, stream);
+    fwrite(&trace->events[start], sizeof(*trace->events), first_count, stream);
+    fwrite(trace->events, sizeof(*trace->events), count - first_count,
+           stream);
+
+    return ferror(stream) ? -INK_E_OS : INK_E_OK;
+}
+
+/*
+ * Output the trace of a parser, followed by the totals of what it lexed,
+ * rewound and memoized.
+ */
+static void ink_parser_trace_flush(const struct ink_parser *parser)
+{
+    const struct ink_parser_trace *trace = &parser->trace;
+    const struct ink_parser_trace_summary summary = {
+        .lexed = parser->stats.lexed,
+        .relexed = parser->stats.relexed,
+        .replayed = parser->stats.replayed,
+        .prelexed = parser->stats.prelexed,
+        .rewinds = parser->stats.rewinds,
+        .peeked = parser->stats.peeked,
+        .memo_entries = parser->cache.count,
+        .memo_bytes = parser->cache.capacity * sizeof(*parser->cache.entries),
+        .memo_evicted = parser->cache.evicted,
+        .memo_hits = parser->cache.hits,
+        .memo_lookups = parser->cache.lookups,
+    };
+
+    if (trace->output) {
+        ink_parser_trace_write(trace, &summary, trace->output);
+        fflush(trace->output);
+    } else {
+        ink_parser_trace_print_all(trace, stdout);
+        ink_parser_trace_print_summary(&summary, stdout);
+        fflush(stdout);
+    }
+}
+
+static struct ink_syntax_seq *
+ink_seq_from_scratch(struct ink_arena *arena,
                      struct ink_parser_scratch *scratch, size_t start_offset,
                      size_t end_offset)
 {
@@ -458,21 +1512,46 @@ static inline enum ink_precedence ink_binding_power(enum ink_token_type type)
     }
 }
 
+/*
+ * Tokens that the parser can recover at during error handling.
+ */
+#define INK_PARSER_SYNC                                                        \
+    (INK_TOKEN_BIT(INK_TT_EOF) | INK_TOKEN_BIT(INK_TT_NL) |                    \
+     INK_TOKEN_BIT(INK_TT_RIGHT_BRACE) | INK_TOKEN_BIT(INK_TT_RIGHT_PAREN))
+
+/*
+ * FIRST set of a logic expression, a divert or a thread, which content
+ * holds alongside its text.
+ */
+#define INK_PARSER_FIRST_INLINE                                                \
+    (INK_TOKEN_BIT(INK_TT_LEFT_BRACE) | INK_TOKEN_BIT(INK_TT_LEFT_ARROW) |     \
+     INK_TOKEN_BIT(INK_TT_RIGHT_ARROW))
+
+/*
+ * FOLLOW sets of the text within each rule that parses content, which are
+ * the tokens that end a run of text there. Text also ends wherever
+ * something inline to the content starts.
+ */
+#define INK_PARSER_FOLLOW_CONTENT                                              \
+    (INK_PARSER_FIRST_INLINE | INK_TOKEN_BIT(INK_TT_RIGHT_BRACE) |             \
+     INK_TOKEN_BIT(INK_TT_NL) | INK_TOKEN_BIT(INK_TT_EOF))
+#define INK_PARSER_FOLLOW_SEQUENCE                                             \
+    (INK_PARSER_FOLLOW_CONTENT | INK_TOKEN_BIT(INK_TT_PIPE))
+#define INK_PARSER_FOLLOW_CHOICE                                               \
+    (INK_PARSER_FOLLOW_CONTENT | INK_TOKEN_BIT(INK_TT_LEFT_BRACKET) |          \
+     INK_TOKEN_BIT(INK_TT_RIGHT_BRACKET))
+#define INK_PARSER_FOLLOW_STRING_EXPR                                          \
+    (INK_TOKEN_BIT(INK_TT_DOUBLE_QUOTE) | INK_TOKEN_BIT(INK_TT_LEFT_BRACE) |   \
+     INK_TOKEN_BIT(INK_TT_RIGHT_BRACE) | INK_TOKEN_BIT(INK_TT_NL) |            \
+     INK_TOKEN_BIT(INK_TT_EOF))
+
 /**
  * Determine if a token can be used to recover the parsing state during
  * error handling.
  */
 static inline bool ink_is_sync_token(enum ink_token_type type)
 {
-    switch (type) {
-    case INK_TT_EOF:
-    case INK_TT_NL:
-    case INK_TT_RIGHT_BRACE:
-    case INK_TT_RIGHT_PAREN:
-        return true;
-    default:
-        return false;
-    }
+    return ink_token_set_has(INK_PARSER_SYNC, type);
 }
 
 static inline enum ink_syntax_node_type
@@ -500,15 +1579,90 @@ static inline void ink_parser_push_scanner(struct ink_parser *parser,
     ink_scanner_push(&parser->scanner, type, parser->current_offset);
 }
 
+/**
+ * Pop the current grammar mode.
+ *
+ * Rewinding never goes further back than the offset at which the base
+ * mode's first nested mode was pushed, so buffered tokens are discarded
+ * once the scanner returns to the base mode.
+ */
 static inline void ink_parser_pop_scanner(struct ink_parser *parser)
 {
     ink_scanner_pop(&parser->scanner);
+
+    if (parser->scanner.mode_depth == 0) {
+        ink_token_buffer_reset(&parser->tokens);
+    }
 }
 
-static inline void ink_parser_next_token(struct ink_parser *parser)
+/**
+ * Lex the next token from the scanner's cursor.
+ */
+static inline void ink_parser_lex(struct ink_parser *parser)
 {
+    struct ink_parser_lex_stats *stats = &parser->stats;
+    const size_t offset = parser->scanner.cursor_offset;
+    size_t end_offset;
+
     ink_scanner_next(&parser->scanner, &parser->token);
-    parser->current_offset = parser->scanner.start_offset;
+    end_offset = parser->scanner.cursor_offset;
+    stats->lexed += end_offset - offset;
+
+    if (offset < stats->high_water) {
+        const size_t seen_offset =
+            end_offset < stats->high_water ? end_offset : stats->high_water;
+
+        stats->relexed += seen_offset - offset;
+    }
+    if (end_offset > stats->high_water) {
+        stats->high_water = end_offset;
+    }
+}
+
+/**
+ * Advance to the next token.
+ *
+ * When buffering, tokens that were already lexed from the same offset in
+ * the same grammar mode are replayed from the token buffer, so rewinding
+ * the scanner never causes source bytes to be lexed twice in one mode.
+ * Only tokens lexed within a nested grammar mode are buffered, as the
+ * scanner is never rewound otherwise. Tokens lexed at the start of a line
+ * are not buffered either, as the scanner treats leading whitespace there
+ * differently, and neither is the end of the file.
+ *
+ * When pre-lexing, tokens in content mode are taken from the pre-lexed
+ * tokens wherever lexing has already started from the same offset.
+ */
+static inline void ink_parser_next_token(struct ink_parser *parser)
+{
+    struct ink_scanner *scanner = &parser->scanner;
+    const size_t offset = scanner->cursor_offset;
+
+    if (scanner->is_line_start) {
+        ink_parser_lex(parser);
+    } else if ((parser->flags & INK_PARSER_F_PRELEXING) &&
+               ink_scanner_current(scanner)->type == INK_GRAMMAR_CONTENT &&
+               ink_token_buffer_replay(&parser->prelexed, scanner,
+                                       &parser->token)) {
+        parser->stats.prelexed += scanner->cursor_offset - offset;
+    } else if (!(parser->flags & INK_PARSER_F_BUFFERING) ||
+               scanner->mode_depth == 0) {
+        ink_parser_lex(parser);
+    } else if (ink_token_buffer_replay(&parser->tokens, scanner,
+                                       &parser->token)) {
+        parser->stats.replayed += scanner->cursor_offset - offset;
+    } else {
+        ink_parser_lex(parser);
+
+        if (parser->token.type != INK_TT_EOF) {
+            ink_token_buffer_record(&parser->tokens,
+                                    ink_scanner_current(scanner)->type, offset,
+                                    &parser->token);
+        }
+    }
+
+    parser->current_offset = scanner->start_offset;
+    parser->profile.token_count++;
 }
 
 static inline bool ink_parser_check(struct ink_parser *parser,
@@ -519,65 +1673,194 @@ static inline bool ink_parser_check(struct ink_parser *parser,
     return token->type == type;
 }
 
+#ifndef INK_PARSER_NO_TRACING
+static inline unsigned short ink_parser_trace_count(size_t count)
+{
+    return count < USHRT_MAX ? (unsigned short)count : USHRT_MAX;
+}
+
 /**
- * Print parser tracing information to the console.
+ * Record a tracing event.
  */
-static void ink_parser_trace(struct ink_parser *parser, const char *rule_name)
+static void ink_parser_trace(struct ink_parser *parser,
+                             enum ink_parser_trace_kind kind,
+                             enum ink_parser_rule_id rule)
 {
-    const struct ink_token *token = ink_parser_current_token(parser);
-
-    ink_trace("Entering %s(PendingChoices=%zu, PendingBlocks=%zu, "
-              "TokenType=%s, SourceOffset: %zu, "
-              "Level: %d)",
-              rule_name, parser->choices.count, parser->blocks.count,
-              ink_token_type_strz(token->type), parser->current_offset,
-              parser->current_level);
+    struct ink_parser_trace *trace = &parser->trace;
+    struct ink_parser_trace_event *event =
+        &trace->events[trace->head++ & (INK_PARSER_TRACE_EVENTS - 1)];
+
+    event->source_offset = (ink_offset_t)parser->current_offset;
+    event->kind = (unsigned char)kind;
+    event->rule = (unsigned char)rule;
+    event->token_type = (unsigned char)parser->token.type;
+    event->level = (signed char)parser->current_level;
+    event->choices = ink_parser_trace_count(parser->choices.count);
+    event->blocks = ink_parser_trace_count(parser->blocks.count);
 }
+#endif
 
 static void ink_parser_rewind_scanner(struct ink_parser *parser)
 {
     const struct ink_scanner_mode *mode = ink_scanner_current(&parser->scanner);
 
-    if (parser->flags & INK_PARSER_F_TRACING) {
-        ink_trace("Rewinding scanner to %zu", parser->current_offset);
+    INK_PARSER_TRACE_EVENT(INK_PARSER_TRACE_REWIND, INK_PARSER_RULE_ID_NONE);
+
+    if (parser->flags & INK_PARSER_F_PROFILING) {
+        ink_parser_profile_rewind(&parser->profile);
     }
 
+    parser->stats.rewinds++;
     ink_scanner_rewind(&parser->scanner, mode->source_offset);
     parser->current_offset = mode->source_offset;
 }
 
-static bool ink_parser_check_many(struct ink_parser *parser,
-                                  const enum ink_token_type *token_set)
-{
-    if (ink_parser_check(parser, INK_TT_EOF)) {
-        return true;
-    }
-    for (size_t i = 0; token_set[i] != INK_TT_EOF; i++) {
-        if (ink_parser_check(parser, token_set[i])) {
-            return true;
-        }
-    }
-    return false;
-}
-
 /**
- * Raise an error in the parser.
+ * Look ahead at up to `count` tokens past the current one, in the grammar
+ * mode `type`, without advancing.
  */
-static void *ink_parser_error(struct ink_parser *parser, const char *format,
-                              ...)
+static size_t ink_parser_peek(struct ink_parser *parser,
+                              enum ink_grammar_type type,
+                              struct ink_token *tokens, size_t count)
 {
-    va_list vargs;
-
-    va_start(vargs, format);
-    ink_log(INK_LOG_LEVEL_ERROR, format, vargs);
-    va_end(vargs);
+    count = ink_scanner_peek(&parser->scanner, type, tokens, count);
 
-    parser->panic_mode = true;
-    ink_token_print(parser->scanner.source, ink_parser_current_token(parser));
+    parser->stats.peeked +=
+        tokens[count - 1].end_offset - parser->scanner.cursor_offset;
+    return count;
+}
+
+static inline bool ink_parser_check_set(struct ink_parser *parser,
+                                        ink_token_set token_set)
+{
+    const struct ink_token *token = ink_parser_current_token(parser);
+
+    return ink_token_set_has(token_set, token->type);
+}
+
+/*
+ * Check whether an error raised at `offset` follows from the last error
+ * raised, which it does if no line ends between them.
+ */
+static bool ink_parser_is_cascade(struct ink_parser *parser, size_t offset)
+{
+    const unsigned char *bytes = parser->scanner.source->bytes;
+    size_t start = parser->panic_offset;
+    size_t end = offset;
+
+    if (start == SIZE_MAX) {
+        return false;
+    }
+    if (start > end) {
+        start = offset;
+        end = parser->panic_offset;
+    }
+    return ink_simd_find_either(bytes, start, end, '\n', '\n') == end;
+}
 
+/**
+ * Raise an error in the parser.
+ *
+ * Errors are recorded to be reported by `ink_parser_report_errors` once
+ * parsing is done. The parser never recovers from an error past the end of
+ * its line, so any other error raised on the same line is taken to follow
+ * from it, and is dropped. Past INK_PARSER_ERROR_LIMIT, errors are only
+ * counted.
+ */
+static void *ink_parser_error(struct ink_parser *parser,
+                              enum ink_parser_error_type type)
+{
+    const struct ink_token *token = ink_parser_current_token(parser);
+    struct ink_parser_error error;
+
+    if (ink_parser_is_cascade(parser, token->start_offset)) {
+        return NULL;
+    }
+
+    parser->panic_offset = token->start_offset;
+
+    if (parser->errors.count >= INK_PARSER_ERROR_LIMIT) {
+        parser->errors_dropped++;
+        return NULL;
+    }
+
+    error.type = type;
+    error.token = *token;
+    ink_parser_errors_append(&parser->errors, error);
     return NULL;
 }
 
+/*
+ * Report errors raised against `source`, in the order given. As when they
+ * are raised, only the first INK_PARSER_ERROR_LIMIT are reported, and the
+ * rest are counted along with the `dropped` errors that were never
+ * recorded.
+ *
+ * Lines and columns are only worked out here, from an index of lines built
+ * for the purpose.
+ */
+static void ink_parser_print_errors(const struct ink_source *source,
+                                    const struct ink_parser_errors *errors,
+                                    size_t dropped)
+{
+    struct ink_source_lines lines;
+    size_t count = errors->count;
+
+    if (count == 0) {
+        return;
+    }
+    if (count > INK_PARSER_ERROR_LIMIT) {
+        dropped += count - INK_PARSER_ERROR_LIMIT;
+        count = INK_PARSER_ERROR_LIMIT;
+    }
+
+    ink_source_lines_initialize(&lines);
+
+    for (size_t i = 0; i < count; i++) {
+        const struct ink_parser_error *error = &errors->entries[i];
+        const char *description = INK_PARSER_ERROR_STR[error->type];
+
+        if (error->type == INK_PARSER_E_UNEXPECTED_TOKEN) {
+            ink_error("%s %s", description,
+                      ink_token_type_strz(error->token.type));
+        } else {
+            ink_error("%s", description);
+        }
+
+        ink_token_print(source, &lines, &error->token);
+    }
+    if (dropped > 0) {
+        ink_error("Too many errors! %zu more were not reported.", dropped);
+    }
+
+    ink_source_lines_cleanup(&lines);
+}
+
+/**
+ * Report the errors recorded by the parser, in the order they were raised.
+ */
+static void ink_parser_report_errors(struct ink_parser *parser)
+{
+    ink_parser_print_errors(parser->scanner.source, &parser->errors,
+                            parser->errors_dropped);
+}
+
+/*
+ * Gather the errors recorded by a parser of part of a source after those
+ * gathered from the parts before it, so that they can be reported as a
+ * parser of the whole source would have reported them.
+ */
+static void ink_parser_gather_errors(const struct ink_parser *parser,
+                                     struct ink_parser_errors *errors,
+                                     size_t *dropped)
+{
+    for (size_t i = 0; i < parser->errors.count; i++) {
+        ink_parser_errors_append(errors, parser->errors.entries[i]);
+    }
+
+    *dropped += parser->errors_dropped;
+}
+
 static inline struct ink_syntax_node *
 ink_parser_create_node(struct ink_parser *parser,
                        enum ink_syntax_node_type type, size_t source_start,
@@ -585,7 +1868,7 @@ ink_parser_create_node(struct ink_parser *parser,
                        struct ink_syntax_node *rhs, struct ink_syntax_seq *seq)
 {
     if (type == INK_NODE_INVALID) {
-        ink_parser_error(parser, "Invalid parse!");
+        ink_parser_error(parser, INK_PARSER_E_INVALID_PARSE);
     }
     return ink_syntax_node_new(parser->arena, type, source_start, source_end,
                                lhs, rhs, seq);
@@ -652,6 +1935,28 @@ static bool ink_parser_eat(struct ink_parser *parser, enum ink_token_type type)
     return false;
 }
 
+/*
+ * Recover from an error by skipping to the next token that ends a line, a
+ * group or a block, or the file.
+ *
+ * The bytes in between are skipped without being lexed, save for comments
+ * and slashes, as none of them can begin such a token.
+ */
+static size_t ink_parser_synchronize(struct ink_parser *parser)
+{
+    size_t source_offset;
+
+    do {
+        if (!ink_parser_check(parser, INK_TT_EOF)) {
+            ink_scanner_skip(&parser->scanner);
+        }
+
+        source_offset = ink_parser_advance(parser);
+    } while (!ink_is_sync_token(parser->token.type));
+
+    return source_offset;
+}
+
 static size_t ink_parser_expect(struct ink_parser *parser,
                                 enum ink_token_type type)
 {
@@ -664,15 +1969,8 @@ static size_t ink_parser_expect(struct ink_parser *parser,
         }
     }
     if (!ink_parser_check(parser, type)) {
-        ink_parser_error(parser, "Unexpected token! %s",
-                         ink_token_type_strz(parser->token.type));
-
-        do {
-            source_offset = ink_parser_advance(parser);
-            type = parser->token.type;
-        } while (!ink_is_sync_token(type));
-
-        return source_offset;
+        ink_parser_error(parser, INK_PARSER_E_UNEXPECTED_TOKEN);
+        return ink_parser_synchronize(parser);
     }
 
     ink_parser_advance(parser);
@@ -684,7 +1982,7 @@ static void ink_parser_expect_stmt_end(struct ink_parser *parser)
 {
     if (!ink_parser_check(parser, INK_TT_EOF) &&
         !ink_parser_check(parser, INK_TT_NL)) {
-        ink_parser_error(parser, "Expected new line!");
+        ink_parser_error(parser, INK_PARSER_E_EXPECTED_NEW_LINE);
     }
 
     ink_parser_advance(parser);
@@ -707,46 +2005,107 @@ static size_t ink_parser_eat_many(struct ink_parser *parser,
     return count;
 }
 
-static int ink_parser_initialize(struct ink_parser *parser,
-                                 const struct ink_source *source,
-                                 struct ink_syntax_tree *tree,
-                                 struct ink_arena *arena, int flags)
+/*
+ * Ready a parser for a source, keeping the memory it already has for its
+ * stacks, buffers and cache.
+ */
+static void ink_parser_reset(struct ink_parser *parser,
+                             const struct ink_source *source,
+                             struct ink_arena *arena, int flags)
 {
     parser->arena = arena;
-    parser->scanner.source = source;
-    parser->scanner.is_line_start = true;
-    parser->scanner.start_offset = 0;
-    parser->scanner.cursor_offset = 0;
-    parser->scanner.mode_stack[0].type = INK_GRAMMAR_CONTENT;
-    parser->scanner.mode_stack[0].source_offset = 0;
+    parser->sink = NULL;
+    ink_scanner_initialize(&parser->scanner, source, 0, true);
     parser->token.type = 0;
     parser->token.start_offset = 0;
     parser->token.end_offset = 0;
-    parser->panic_mode = false;
+    parser->errors_dropped = 0;
+    parser->panic_offset = SIZE_MAX;
     parser->flags = flags;
     parser->current_level = 0;
     parser->current_offset = 0;
 
+    ink_parser_context_stack_shrink(&parser->blocks, 0);
+    ink_parser_context_stack_shrink(&parser->choices, 0);
+    ink_parser_operator_stack_shrink(&parser->operators, 0);
+    ink_parser_scratch_shrink(&parser->scratch, 0);
+    ink_parser_errors_shrink(&parser->errors, 0);
+    ink_parser_cache_reset(&parser->cache);
+    ink_token_buffer_reset(&parser->tokens);
+    ink_token_buffer_reset(&parser->prelexed);
+    memset(&parser->stats, 0, sizeof(parser->stats));
+    memset(&parser->profile, 0, sizeof(parser->profile));
+    memset(&parser->trace, 0, sizeof(parser->trace));
+
+    if (flags & INK_PARSER_F_PROFILING) {
+        ink_parser_profile_initialize(&parser->profile);
+    }
+#ifdef INK_PARSER_NO_TRACING
+    parser->flags &= ~INK_PARSER_F_TRACING;
+#endif
+    /* Tracing only helps diagnose the parser, so it carries on without it. */
+    if (parser->flags & INK_PARSER_F_TRACING) {
+        ink_parser_trace_initialize(&parser->trace);
+        if (parser->trace.events == NULL) {
+            parser->flags &= ~INK_PARSER_F_TRACING;
+        }
+    }
+
+    /* Pre-lexing only saves time, so the parser carries on without it. */
+    if (flags & INK_PARSER_F_PRELEXING) {
+        if (ink_token_buffer_prelex(&parser->prelexed, source,
+                                    platform_cpu_count()) < 0) {
+            ink_token_buffer_reset(&parser->prelexed);
+        }
+    }
+
+    memset(&parser->choices.entries[0], 0, sizeof(*parser->choices.entries));
+    memset(&parser->blocks.entries[0], 0, sizeof(*parser->blocks.entries));
+}
+
+static int ink_parser_initialize(struct ink_parser *parser,
+                                 const struct ink_source *source,
+                                 struct ink_syntax_tree *tree,
+                                 struct ink_arena *arena, int flags)
+{
     ink_parser_context_stack_create(&parser->blocks);
     ink_parser_context_stack_reserve(&parser->blocks, INK_VEC_COUNT_MIN);
     ink_parser_context_stack_create(&parser->choices);
     ink_parser_context_stack_reserve(&parser->choices, INK_VEC_COUNT_MIN);
+    ink_parser_operator_stack_create(&parser->operators);
     ink_parser_scratch_create(&parser->scratch);
     ink_parser_scratch_reserve(&parser->scratch, INK_VEC_COUNT_MIN);
+    ink_parser_errors_create(&parser->errors);
     ink_parser_cache_initialize(&parser->cache);
-
-    memset(&parser->choices.entries[0], 0, sizeof(*parser->choices.entries));
-    memset(&parser->blocks.entries[0], 0, sizeof(*parser->blocks.entries));
+    ink_token_buffer_initialize(&parser->tokens);
+    ink_token_buffer_initialize(&parser->prelexed);
+    ink_parser_reset(parser, source, arena, flags);
 
     return INK_E_OK;
 }
 
+/*
+ * Let a parser append to its source as it scans, if the source is still
+ * being received. Every other source is only read.
+ */
+static void ink_parser_stream(struct ink_parser *parser,
+                              struct ink_source *source)
+{
+    parser->scanner.stream = source->is_streaming ? source : NULL;
+}
+
 static void ink_parser_cleanup(struct ink_parser *parser)
 {
     ink_parser_context_stack_destroy(&parser->blocks);
     ink_parser_context_stack_destroy(&parser->choices);
+    ink_parser_operator_stack_destroy(&parser->operators);
     ink_parser_scratch_destroy(&parser->scratch);
+    ink_parser_errors_destroy(&parser->errors);
     ink_parser_cache_cleanup(&parser->cache);
+    ink_token_buffer_cleanup(&parser->tokens);
+    ink_token_buffer_cleanup(&parser->prelexed);
+    ink_parser_profile_cleanup(&parser->profile);
+    ink_parser_trace_cleanup(&parser->trace);
     memset(parser, 0, sizeof(*parser));
 }
 
@@ -786,11 +2145,11 @@ static struct ink_syntax_node *ink_parse_identifier(struct ink_parser *parser)
 
 static struct ink_syntax_node *
 ink_parse_string(struct ink_parser *parser,
-                 const enum ink_token_type *token_set)
+                 ink_token_set token_set)
 {
     const size_t source_start = parser->current_offset;
 
-    while (!ink_parser_check_many(parser, token_set)) {
+    while (!ink_parser_check_set(parser, token_set)) {
         ink_parser_advance(parser);
     }
     return ink_parser_create_leaf(parser, INK_NODE_STRING_LITERAL, source_start,
@@ -828,14 +2187,14 @@ static struct ink_syntax_node *ink_parse_divert(struct ink_parser *parser)
 
 static struct ink_syntax_node *
 ink_parse_string_expr(struct ink_parser *parser,
-                      const enum ink_token_type *token_set)
+                      ink_token_set token_set)
 {
     struct ink_syntax_node *node = NULL;
     const size_t scratch_offset = parser->scratch.count;
     const size_t source_start = ink_parser_expect(parser, INK_TT_DOUBLE_QUOTE);
 
     do {
-        if (!ink_parser_check_many(parser, token_set)) {
+        if (!ink_parser_check_set(parser, token_set)) {
             INK_PARSER_RULE(node, ink_parse_string, parser, token_set);
         } else if (ink_parser_check(parser, INK_TT_LEFT_BRACE)) {
             INK_PARSER_RULE(node, ink_parse_logic_expr, parser);
@@ -856,10 +2215,6 @@ ink_parse_string_expr(struct ink_parser *parser,
 
 static struct ink_syntax_node *ink_parse_primary_expr(struct ink_parser *parser)
 {
-    static const enum ink_token_type token_set[] = {
-        INK_TT_DOUBLE_QUOTE, INK_TT_LEFT_BRACE, INK_TT_RIGHT_BRACE,
-        INK_TT_NL,           INK_TT_EOF,
-    };
     const struct ink_token *token = ink_parser_current_token(parser);
     const size_t source_start = parser->current_offset;
     struct ink_syntax_node *node = NULL;
@@ -882,14 +2237,8 @@ static struct ink_syntax_node *ink_parse_primary_expr(struct ink_parser *parser)
         break;
     }
     case INK_TT_DOUBLE_QUOTE: {
-        INK_PARSER_RULE(node, ink_parse_string_expr, parser, token_set);
-        break;
-    }
-    case INK_TT_LEFT_PAREN: {
-        ink_parser_advance(parser);
-        INK_PARSER_RULE(node, ink_parse_infix_expr, parser, NULL,
-                        INK_PREC_NONE);
-        ink_parser_expect(parser, INK_TT_RIGHT_PAREN);
+        INK_PARSER_RULE(node, ink_parse_string_expr, parser,
+                        INK_PARSER_FOLLOW_STRING_EXPR);
         break;
     }
     default:
@@ -900,56 +2249,107 @@ static struct ink_syntax_node *ink_parse_primary_expr(struct ink_parser *parser)
     return node;
 }
 
-static struct ink_syntax_node *ink_parse_prefix_expr(struct ink_parser *parser)
+/*
+ * Apply the prefix operators on top of the operator stack to `node`, which
+ * completes their operand, returning the node they form. Stops at the first
+ * infix operator or group, or at `base`.
+ */
+static struct ink_syntax_node *
+ink_parser_apply_prefix(struct ink_parser *parser, size_t base,
+                        struct ink_syntax_node *node)
 {
-    struct ink_syntax_node *node = NULL;
+    struct ink_parser_operator_stack *operators = &parser->operators;
 
-    switch (parser->token.type) {
-    case INK_TT_KEYWORD_NOT:
-    case INK_TT_MINUS:
-    case INK_TT_BANG: {
-        const enum ink_token_type type = parser->token.type;
-        const size_t source_start = ink_parser_advance(parser);
+    while (operators->count > base &&
+           operators->entries[operators->count - 1].kind ==
+               INK_PARSER_OPERATOR_PREFIX) {
+        const struct ink_parser_operator *op =
+            &operators->entries[--operators->count];
 
-        INK_PARSER_RULE(node, ink_parse_prefix_expr, parser);
-        node =
-            ink_parser_create_unary(parser, ink_token_prefix_type(type),
-                                    source_start, parser->current_offset, node);
-        break;
-    }
-    default:
-        INK_PARSER_RULE(node, ink_parse_primary_expr, parser);
-        break;
+        node = ink_parser_create_unary(parser, op->type, op->source_start,
+                                       parser->current_offset, node);
     }
     return node;
 }
 
-static struct ink_syntax_node *ink_parse_infix_expr(struct ink_parser *parser,
-                                                    struct ink_syntax_node *lhs,
-                                                    enum ink_precedence prec)
+/**
+ * Parse an expression of prefix and infix operators by precedence climbing.
+ *
+ * Operators whose operands are still being parsed wait on an explicit
+ * stack rather than the native one, so that neither long chains of
+ * operators nor deeply nested parentheses recurse. Operands are parsed by
+ * `ink_parse_primary_expr`, and only recurse where they contain an
+ * expression of their own, as arguments and interpolated strings do.
+ *
+ * Every infix operator binds to the left. A prefix operator applies to the
+ * operand that follows it, before any infix operator does.
+ */
+static struct ink_syntax_node *ink_parse_infix_expr(struct ink_parser *parser)
 {
-    enum ink_precedence token_prec;
-    enum ink_token_type type;
-    struct ink_syntax_node *rhs = NULL;
+    struct ink_parser_operator_stack *operators = &parser->operators;
+    const size_t base = operators->count;
+    enum ink_precedence prec = INK_PREC_NONE;
+    struct ink_syntax_node *node = NULL;
 
-    if (!lhs) {
-        INK_PARSER_RULE(lhs, ink_parse_prefix_expr, parser);
-    }
+    for (;;) {
+        const enum ink_token_type type = parser->token.type;
+        struct ink_parser_operator op = {0};
+
+        switch (type) {
+        case INK_TT_KEYWORD_NOT:
+        case INK_TT_MINUS:
+        case INK_TT_BANG:
+            op.kind = INK_PARSER_OPERATOR_PREFIX;
+            op.type = ink_token_prefix_type(type);
+            op.source_start = ink_parser_advance(parser);
+            ink_parser_operator_stack_append(operators, op);
+            continue;
+        case INK_TT_LEFT_PAREN:
+            ink_parser_advance(parser);
+            op.kind = INK_PARSER_OPERATOR_GROUP;
+            op.prec = prec;
+            ink_parser_operator_stack_append(operators, op);
+            prec = INK_PREC_NONE;
+            continue;
+        default:
+            break;
+        }
 
-    type = parser->token.type;
-    token_prec = ink_binding_power(type);
+        INK_PARSER_RULE(node, ink_parse_primary_expr, parser);
+        node = ink_parser_apply_prefix(parser, base, node);
 
-    while (token_prec > prec) {
-        const size_t source_start = ink_parser_advance(parser);
+        for (;;) {
+            const enum ink_token_type op_type = parser->token.type;
+            const enum ink_precedence op_prec = ink_binding_power(op_type);
+
+            if (op_prec > prec) {
+                op.kind = INK_PARSER_OPERATOR_INFIX;
+                op.type = ink_token_infix_type(op_type);
+                op.prec = prec;
+                op.lhs = node;
+                op.source_start = ink_parser_advance(parser);
+                ink_parser_operator_stack_append(operators, op);
+                prec = op_prec;
+                break;
+            }
+            if (operators->count == base) {
+                return node;
+            }
 
-        INK_PARSER_RULE(rhs, ink_parse_infix_expr, parser, NULL, token_prec);
-        lhs = ink_parser_create_binary(parser, ink_token_infix_type(type),
-                                       source_start, parser->current_offset,
-                                       lhs, rhs);
-        type = parser->token.type;
-        token_prec = ink_binding_power(type);
+            op = operators->entries[--operators->count];
+            prec = op.prec;
+
+            if (op.kind == INK_PARSER_OPERATOR_INFIX) {
+                node = ink_parser_create_binary(parser, op.type,
+                                                op.source_start,
+                                                parser->current_offset,
+                                                op.lhs, node);
+            } else {
+                ink_parser_expect(parser, INK_TT_RIGHT_PAREN);
+                node = ink_parser_apply_prefix(parser, base, node);
+            }
+        }
     }
-    return lhs;
 }
 
 static struct ink_syntax_node *
@@ -1004,7 +2404,7 @@ static struct ink_syntax_node *ink_parse_expr(struct ink_parser *parser)
 {
     struct ink_syntax_node *node = NULL;
 
-    INK_PARSER_RULE(node, ink_parse_infix_expr, parser, NULL, INK_PREC_NONE);
+    INK_PARSER_RULE(node, ink_parse_infix_expr, parser);
 
     return node;
 }
@@ -1127,11 +2527,7 @@ ink_parse_conditional_branch(struct ink_parser *parser)
 static struct ink_syntax_node *ink_parse_sequence(struct ink_parser *parser,
                                                   struct ink_syntax_node *expr)
 {
-    static const enum ink_token_type token_set[] = {
-        INK_TT_LEFT_BRACE,  INK_TT_LEFT_ARROW, INK_TT_RIGHT_BRACE,
-        INK_TT_RIGHT_ARROW, INK_TT_PIPE,       INK_TT_NL,
-        INK_TT_EOF,
-    };
+    const ink_token_set token_set = INK_PARSER_FOLLOW_SEQUENCE;
     const size_t scratch_offset = parser->scratch.count;
     const size_t source_start = parser->current_offset;
     struct ink_syntax_node *node = NULL;
@@ -1195,28 +2591,141 @@ static struct ink_syntax_node *ink_parse_conditional(struct ink_parser *parser)
     return NULL;
 }
 
+/*
+ * Check whether the logic expression opened by the current brace could be
+ * a conditional, from the tokens that follow the brace.
+ *
+ * A conditional is an expression followed by a colon. Outside of
+ * parentheses, an expression always ends by the first closing brace or
+ * parenthesis, pipe, new line or end of the file, unless it holds a string
+ * or a logic expression of its own. Within them, recovering from an error
+ * can take it further. A new line straight after the brace starts a
+ * multi-line conditional instead.
+ */
+static bool ink_parser_may_be_conditional(struct ink_parser *parser)
+{
+    struct ink_token tokens[INK_PARSER_LOOKAHEAD_MAX];
+    size_t window = INK_PARSER_LOOKAHEAD_MIN;
+
+    for (;;) {
+        const size_t count =
+            ink_parser_peek(parser, INK_GRAMMAR_EXPRESSION, tokens, window);
+        size_t depth = 0;
+
+        if (tokens[0].type == INK_TT_NL) {
+            return true;
+        }
+        for (size_t i = 0; i < count; i++) {
+            switch (tokens[i].type) {
+            case INK_TT_EOF:
+            case INK_TT_NL:
+            case INK_TT_PIPE:
+            case INK_TT_RIGHT_BRACE:
+                if (depth == 0) {
+                    return false;
+                }
+                break;
+            case INK_TT_LEFT_PAREN:
+                depth++;
+                break;
+            case INK_TT_RIGHT_PAREN:
+                if (depth == 0) {
+                    return false;
+                }
+                depth--;
+                break;
+            case INK_TT_COLON:
+            case INK_TT_DOUBLE_QUOTE:
+            case INK_TT_LEFT_BRACE:
+                return true;
+            default:
+                break;
+            }
+        }
+        if (window == INK_PARSER_LOOKAHEAD_MAX) {
+            return true;
+        }
+
+        window = INK_PARSER_LOOKAHEAD_MAX;
+    }
+}
+
+/*
+ * Check whether the logic expression opened by the current brace could be
+ * a sequence, from the tokens that follow the brace in content mode.
+ *
+ * A sequence starts with content followed by a pipe. Content that holds
+ * only text ends at the first pipe, closing brace or new line.
+ */
+static bool ink_parser_may_be_sequence(struct ink_parser *parser)
+{
+    struct ink_token tokens[INK_PARSER_LOOKAHEAD_MAX];
+    size_t window = INK_PARSER_LOOKAHEAD_MIN;
+
+    for (;;) {
+        const size_t count =
+            ink_parser_peek(parser, INK_GRAMMAR_CONTENT, tokens, window);
+
+        for (size_t i = 0; i < count; i++) {
+            switch (tokens[i].type) {
+            case INK_TT_EOF:
+            case INK_TT_NL:
+            case INK_TT_RIGHT_BRACE:
+                return false;
+            case INK_TT_PIPE:
+            case INK_TT_LEFT_ARROW:
+            case INK_TT_LEFT_BRACE:
+            case INK_TT_RIGHT_ARROW:
+                return true;
+            default:
+                break;
+            }
+        }
+        if (window == INK_PARSER_LOOKAHEAD_MAX) {
+            return true;
+        }
+
+        window = INK_PARSER_LOOKAHEAD_MAX;
+    }
+}
+
+/**
+ * Parse a logic expression, which is a conditional, a sequence or a plain
+ * expression, tried in that order.
+ *
+ * Lookahead rules out whichever of the first two cannot match before they
+ * are tried, so that the scanner is only rewound to the opening brace when
+ * the lookahead is not enough to tell.
+ */
 static struct ink_syntax_node *ink_parse_logic_expr(struct ink_parser *parser)
 {
     const size_t source_start = parser->current_offset;
     struct ink_syntax_node *node = NULL;
 
     ink_parser_push_scanner(parser, INK_GRAMMAR_EXPRESSION);
-    INK_PARSER_RULE(node, ink_parse_conditional, parser);
 
-    if (node == NULL) {
-        ink_parser_rewind_scanner(parser);
+    if (ink_parser_may_be_conditional(parser)) {
+        INK_PARSER_RULE(node, ink_parse_conditional, parser);
+
+        if (node == NULL) {
+            ink_parser_rewind_scanner(parser);
+            ink_parser_advance(parser);
+        }
+    }
+    if (node == NULL && ink_parser_may_be_sequence(parser)) {
         ink_parser_push_scanner(parser, INK_GRAMMAR_CONTENT);
-        ink_parser_advance(parser);
         INK_PARSER_RULE(node, ink_parse_sequence, parser, NULL);
         ink_parser_pop_scanner(parser);
 
         if (node == NULL) {
             ink_parser_rewind_scanner(parser);
             ink_parser_advance(parser);
-            ink_parser_advance(parser);
-            INK_PARSER_RULE(node, ink_parse_expr, parser);
         }
     }
+    if (node == NULL) {
+        ink_parser_advance(parser);
+        INK_PARSER_RULE(node, ink_parse_expr, parser);
+    }
 
     ink_parser_pop_scanner(parser);
     ink_parser_expect(parser, INK_TT_RIGHT_BRACE);
@@ -1227,14 +2736,14 @@ static struct ink_syntax_node *ink_parse_logic_expr(struct ink_parser *parser)
 
 static struct ink_syntax_node *
 ink_parse_content_expr(struct ink_parser *parser,
-                       const enum ink_token_type *token_set)
+                       ink_token_set token_set)
 {
     struct ink_syntax_node *node = NULL;
     const size_t source_start = parser->current_offset;
     const size_t scratch_offset = parser->scratch.count;
 
     for (;;) {
-        if (!ink_parser_check_many(parser, token_set)) {
+        if (!ink_parser_check_set(parser, token_set)) {
             INK_PARSER_RULE(node, ink_parse_string, parser, token_set);
         } else if (ink_parser_check(parser, INK_TT_LEFT_BRACE)) {
             INK_PARSER_RULE(node, ink_parse_logic_expr, parser);
@@ -1254,10 +2763,7 @@ ink_parse_content_expr(struct ink_parser *parser,
 
 static struct ink_syntax_node *ink_parse_content_stmt(struct ink_parser *parser)
 {
-    static const enum ink_token_type token_set[] = {
-        INK_TT_LEFT_BRACE,  INK_TT_LEFT_ARROW, INK_TT_RIGHT_BRACE,
-        INK_TT_RIGHT_ARROW, INK_TT_NL,         INK_TT_EOF,
-    };
+    const ink_token_set token_set = INK_PARSER_FOLLOW_CONTENT;
     const size_t source_start = parser->current_offset;
     struct ink_syntax_node *node = NULL;
 
@@ -1279,11 +2785,7 @@ static struct ink_syntax_node *ink_parse_content_stmt(struct ink_parser *parser)
 static struct ink_syntax_node *
 ink_parse_choice_content(struct ink_parser *parser)
 {
-    static const enum ink_token_type token_set[] = {
-        INK_TT_LEFT_BRACE,  INK_TT_LEFT_ARROW,    INK_TT_LEFT_BRACKET,
-        INK_TT_RIGHT_BRACE, INK_TT_RIGHT_BRACKET, INK_TT_RIGHT_ARROW,
-        INK_TT_NL,          INK_TT_EOF,
-    };
+    const ink_token_set token_set = INK_PARSER_FOLLOW_CHOICE;
     const size_t scratch_offset = parser->scratch.count;
     const size_t source_start = parser->current_offset;
     struct ink_syntax_node *node = NULL;
@@ -1309,7 +2811,7 @@ ink_parse_choice_content(struct ink_parser *parser)
 
         ink_parser_expect(parser, INK_TT_RIGHT_BRACKET);
 
-        if (!ink_parser_check_many(parser, token_set)) {
+        if (!ink_parser_check_set(parser, token_set)) {
             INK_PARSER_RULE(node, ink_parse_string, parser, token_set);
 
             if (node) {
@@ -1404,7 +2906,7 @@ static struct ink_syntax_node *ink_parse_list(struct ink_parser *parser)
         INK_PARSER_RULE(node, ink_parse_list_element_def, parser);
 
         if (arg_count == INK_PARSER_ARGS_MAX) {
-            ink_parser_error(parser, "Too many arguments");
+            ink_parser_error(parser, INK_PARSER_E_TOO_MANY_ARGUMENTS);
             break;
         }
 
@@ -1498,7 +3000,7 @@ ink_parse_argument_list(struct ink_parser *parser)
         for (;;) {
             node = ink_parse_expr(parser);
             if (arg_count == 255) {
-                ink_parser_error(parser, "Too many arguments");
+                ink_parser_error(parser, INK_PARSER_E_TOO_MANY_ARGUMENTS);
                 break;
             }
 
@@ -1545,7 +3047,7 @@ ink_parse_parameter_list(struct ink_parser *parser)
     if (!ink_parser_check(parser, INK_TT_RIGHT_PAREN)) {
         for (;;) {
             if (arg_count == 255) {
-                ink_parser_error(parser, "Too many parameters");
+                ink_parser_error(parser, INK_PARSER_E_TOO_MANY_PARAMETERS);
                 break;
             } else {
                 arg_count++;
@@ -1614,6 +3116,29 @@ static struct ink_syntax_node *ink_parse_knot_decl(struct ink_parser *parser)
                                       parser->current_offset, scratch_offset);
 }
 
+/*
+ * Return the keyword that the current token starts a declaration with, or
+ * INK_TT_EOF if it starts none, recognizing the token as that keyword. The
+ * token is looked up once, rather than once per keyword.
+ */
+static enum ink_token_type ink_parser_stmt_keyword(struct ink_parser *parser)
+{
+    struct ink_token *token = &parser->token;
+
+    if (token->keyword == INK_TT_EOF) {
+        token->keyword = ink_scanner_keyword(&parser->scanner, token);
+    }
+    switch (token->keyword) {
+    case INK_TT_KEYWORD_CONST:
+    case INK_TT_KEYWORD_VAR:
+    case INK_TT_KEYWORD_LIST:
+        token->type = token->keyword;
+        return token->type;
+    default:
+        return INK_TT_EOF;
+    }
+}
+
 static struct ink_syntax_node *ink_parse_stmt(struct ink_parser *parser)
 {
     struct ink_syntax_node *node = NULL;
@@ -1647,17 +3172,19 @@ static struct ink_syntax_node *ink_parse_stmt(struct ink_parser *parser)
         break;
     }
     default:
-        if (ink_scanner_try_keyword(&parser->scanner, &parser->token,
-                                    INK_TT_KEYWORD_CONST)) {
+        switch (ink_parser_stmt_keyword(parser)) {
+        case INK_TT_KEYWORD_CONST:
             INK_PARSER_RULE(node, ink_parse_const_decl, parser);
-        } else if (ink_scanner_try_keyword(&parser->scanner, &parser->token,
-                                           INK_TT_KEYWORD_VAR)) {
+            break;
+        case INK_TT_KEYWORD_VAR:
             INK_PARSER_RULE(node, ink_parse_var_decl, parser);
-        } else if (ink_scanner_try_keyword(&parser->scanner, &parser->token,
-                                           INK_TT_KEYWORD_LIST)) {
+            break;
+        case INK_TT_KEYWORD_LIST:
             INK_PARSER_RULE(node, ink_parse_list_decl, parser);
-        } else {
+            break;
+        default:
             INK_PARSER_RULE(node, ink_parse_content_stmt, parser);
+            break;
         }
         break;
     }
@@ -1703,7 +3230,7 @@ ink_parse_stmt_level(struct ink_parser *parser,
                      struct ink_parser_context_stack *choice_stack)
 {
     const size_t start_offset = parser->current_offset;
-    struct ink_syntax_node *branch, *temp, *node;
+    struct ink_syntax_node *branch, *temp = NULL, *node;
     struct ink_parser_context block = {0};
     struct ink_parser_context choice = {0};
     struct ink_parser_scratch *scratch = &parser->scratch;
@@ -1714,7 +3241,7 @@ ink_parse_stmt_level(struct ink_parser *parser,
     INK_PARSER_RULE(node, ink_parse_stmt, parser);
 
     if (parser->current_level > choice.level) {
-        assert(node != NULL);
+        INK_PARSER_ASSERT(node != NULL);
 
         if (node->type == INK_NODE_CHOICE_STAR_STMT ||
             node->type == INK_NODE_CHOICE_PLUS_STMT) {
@@ -1730,7 +3257,7 @@ ink_parse_stmt_level(struct ink_parser *parser,
                                   scratch->count, start_offset);
         }
     } else if (parser->current_level == choice.level) {
-        assert(node != NULL);
+        INK_PARSER_ASSERT(node != NULL);
 
         if (node->type == INK_NODE_CHOICE_STAR_STMT ||
             node->type == INK_NODE_CHOICE_PLUS_STMT) {
@@ -1763,7 +3290,7 @@ ink_parse_stmt_level(struct ink_parser *parser,
          * Close open choices and emit blocks where appropriate.
          */
         while (!ink_parser_context_stack_is_empty(choice_stack)) {
-            assert(!ink_parser_context_stack_is_empty(block_stack));
+            INK_PARSER_ASSERT(!ink_parser_context_stack_is_empty(block_stack));
             ink_parser_context_stack_peek(choice_stack, &choice);
 
             if (choice.level > parser->current_level) {
@@ -1854,10 +3381,74 @@ ink_parse_stmt_level(struct ink_parser *parser,
     return node;
 }
 
+/*
+ * Sink for parses that only check the source.
+ */
+static const struct ink_parse_sink INK_PARSER_NULL_SINK = {0};
+
+/*
+ * Report a node, and everything below it, to a sink.
+ */
+static void ink_parser_sink_node(const struct ink_parse_sink *sink,
+                                 const struct ink_syntax_node *node)
+{
+    if (node->lhs == NULL && node->rhs == NULL && node->seq == NULL) {
+        if (sink->token) {
+            sink->token(sink->context, node->type, node->start_offset,
+                        node->end_offset);
+        }
+        return;
+    }
+    if (sink->enter) {
+        sink->enter(sink->context, node->type, node->start_offset);
+    }
+    if (node->lhs) {
+        ink_parser_sink_node(sink, node->lhs);
+    }
+    if (node->rhs) {
+        ink_parser_sink_node(sink, node->rhs);
+    }
+    if (node->seq) {
+        for (size_t i = 0; i < node->seq->count; i++) {
+            if (node->seq->nodes[i]) {
+                ink_parser_sink_node(sink, node->seq->nodes[i]);
+            }
+        }
+    }
+    if (sink->leave) {
+        sink->leave(sink->context, node->type, node->start_offset,
+                    node->end_offset);
+    }
+}
+
+/*
+ * Report the statements parsed at the top level of the file so far to the
+ * parser's sink, then take back the memory they were parsed into.
+ *
+ * Only the file's own block may be open, with no choices, since anything
+ * deeper can still pop statements from the scratch buffer.
+ */
+static void ink_parser_sink_flush(struct ink_parser *parser,
+                                  size_t scratch_offset)
+{
+    const struct ink_parse_sink *sink = parser->sink;
+    struct ink_parser_scratch *scratch = &parser->scratch;
+
+    if (sink->enter || sink->leave || sink->token) {
+        for (size_t i = scratch_offset; i < scratch->count; i++) {
+            ink_parser_sink_node(sink, scratch->entries[i]);
+        }
+    }
+
+    ink_parser_scratch_shrink(scratch, scratch_offset);
+    ink_arena_restore(parser->arena, &parser->mark);
+}
+
 static struct ink_syntax_node *ink_parse_file(struct ink_parser *parser)
 {
     const size_t scratch_offset = parser->scratch.count;
     const size_t start_offset = parser->current_offset;
+    const struct ink_parse_sink *sink = parser->sink;
     struct ink_parser_scratch *scratch = &parser->scratch;
     struct ink_parser_context_stack *blocks = &parser->blocks;
     struct ink_parser_context_stack *choices = &parser->choices;
@@ -1865,48 +3456,1510 @@ static struct ink_syntax_node *ink_parse_file(struct ink_parser *parser)
 
     ink_parser_stack_push(blocks, 0, 0, start_offset);
 
+    if (sink && sink->enter) {
+        sink->enter(sink->context, INK_NODE_FILE, start_offset);
+        sink->enter(sink->context, INK_NODE_BLOCK_STMT, start_offset);
+    }
     while (parser->current_level >= 0) {
         INK_PARSER_RULE(node, ink_parse_stmt_level, parser, blocks, choices);
 
         if (node) {
             ink_parser_scratch_append(scratch, node);
         }
+        if (parser->flags & INK_PARSER_F_CACHING) {
+            ink_parser_cache_commit(&parser->cache, parser->current_offset);
+        }
+        if (sink && blocks->count == 1 && choices->count == 0) {
+            ink_parser_sink_flush(parser, scratch_offset);
+        }
     }
-    return ink_parser_create_sequence(parser, INK_NODE_FILE, start_offset,
+
+    node = ink_parser_create_sequence(parser, INK_NODE_FILE, start_offset,
                                       parser->current_offset, scratch_offset);
-}
+    if (sink && node && node->seq) {
+        /*
+         * What is left is the file's block, holding the statements from the
+         * last one reported on.
+         */
+        const struct ink_syntax_node *block = node->seq->nodes[0];
 
-/**
- * Parse a source file and output a syntax tree.
+        INK_PARSER_ASSERT(node->seq->count == 1);
+
+        if (block->seq && (sink->enter || sink->leave || sink->token)) {
+            for (size_t i = 0; i < block->seq->count; i++) {
+                if (block->seq->nodes[i]) {
+                    ink_parser_sink_node(sink, block->seq->nodes[i]);
+                }
+            }
+        }
+        if (sink->leave) {
+            sink->leave(sink->context, block->type, block->start_offset,
+                        block->end_offset);
+            sink->leave(sink->context, node->type, node->start_offset,
+                        node->end_offset);
+        }
+    }
+    return node;
+}
+
+/*
+ * Check whether only indentation comes before `offset` on its line.
+ */
+static bool ink_parser_is_line_start(const struct ink_source *source,
+                                     size_t offset)
+{
+    while (offset > 0 && (source->bytes[offset - 1] == ' ' ||
+                          source->bytes[offset - 1] == '\t')) {
+        offset--;
+    }
+    return offset == 0 || source->bytes[offset - 1] == '\n';
+}
+
+/**
+ * Split a source into up to `count` regions for parsing in parallel,
+ * returning the number of regions found.
+ *
+ * Every region after the first starts at the first knot declaration at or
+ * after an even share of the source. A split in the wrong place is caught
+ * once the regions have been parsed.
+ */
+static size_t ink_parser_split_source(const struct ink_source *source,
+                                      struct ink_parser_region *regions,
+                                      size_t count)
+{
+    const size_t length = source->length;
+    struct ink_boundary boundary;
+    size_t found = 1;
+    size_t offset = 0;
+
+    regions[0].start_offset = 0;
+
+    while (found < count) {
+        offset = ink_prescan_next(source->bytes, offset, length,
+                                  INK_BOUNDARY_DECLS, &boundary);
+        if (offset == length) {
+            break;
+        }
+        if (offset >= length / count * found &&
+            boundary.type != INK_BOUNDARY_STITCH) {
+            regions[found++].start_offset = offset;
+        }
+
+        offset = boundary.name_offset;
+    }
+    return found;
+}
+
+/*
+ * Check whether a node declares a knot, a stitch or a function. Stitches are
+ * parsed as knots.
+ */
+static inline bool ink_is_decl_type(enum ink_syntax_node_type type)
+{
+    return type == INK_NODE_KNOT_DECL || type == INK_NODE_FUNCTION_DECL;
+}
+
+static void ink_parser_resume_save(const struct ink_parser *parser,
+                                   const struct ink_syntax_node *node,
+                                   struct ink_parser_resume *resume)
+{
+    resume->type = node ? node->type : INK_NODE_INVALID;
+    resume->start_offset = node ? node->start_offset : 0;
+    resume->end_offset = node ? node->end_offset : 0;
+    resume->cursor_offset = parser->scanner.cursor_offset;
+    resume->current_offset = parser->current_offset;
+    resume->current_level = parser->current_level;
+    resume->is_line_start = parser->scanner.is_line_start;
+    resume->mode_depth = parser->scanner.mode_depth;
+    resume->token = parser->token;
+}
+
+static bool ink_parser_resume_equal(const struct ink_parser_resume *a,
+                                    const struct ink_parser_resume *b)
+{
+    return a->type == b->type && a->start_offset == b->start_offset &&
+           a->end_offset == b->end_offset &&
+           a->cursor_offset == b->cursor_offset &&
+           a->current_offset == b->current_offset &&
+           a->current_level == b->current_level &&
+           a->is_line_start == b->is_line_start &&
+           a->mode_depth == b->mode_depth &&
+           a->token.type == b->token.type &&
+           a->token.start_offset == b->token.start_offset &&
+           a->token.end_offset == b->token.end_offset;
+}
+
+/*
+ * Move the parser to `offset`, at the top level of the source, and lex the
+ * token there.
+ *
+ * Other than at the start of the file, the scanner only skips leading
+ * whitespace after a line comment, so the offset is not treated as the
+ * start of a line. Lexing from the start of an indented line yields its
+ * whitespace as a token, exactly as it does after a newline.
+ */
+static void ink_parser_seek(struct ink_parser *parser, size_t offset)
+{
+    struct ink_scanner *scanner = &parser->scanner;
+
+    scanner->mode_depth = 0;
+    scanner->start_offset = offset;
+    scanner->cursor_offset = offset;
+    scanner->mode_stack[0].source_offset = offset;
+    scanner->is_line_start = offset == 0;
+    parser->current_offset = offset;
+
+    ink_parser_next_token(parser);
+}
+
+/**
+ * Parse a region of the source on a worker.
+ *
+ * Mirrors `ink_parse_file`, except that the file's block is left open
+ * unless the region runs to the end of the file.
+ */
+static void ink_parse_region(void *context, size_t index)
+{
+    struct ink_parser_region *region =
+        (struct ink_parser_region *)context + index;
+    struct ink_parser *parser = &region->parser;
+    struct ink_parser_scratch *scratch = &parser->scratch;
+    struct ink_parser_context_stack *blocks = &parser->blocks;
+    struct ink_parser_context_stack *choices = &parser->choices;
+    struct ink_syntax_node *node;
+    bool is_first = true;
+
+    /* Bytes before the region are validated by whoever scans them. */
+    parser->scanner.utf8_offset = region->start_offset;
+    ink_parser_seek(parser, region->start_offset);
+    ink_parser_stack_push(blocks, 0, 0, parser->current_offset);
+
+    while (parser->current_level >= 0) {
+        const size_t start_offset = parser->current_offset;
+        const size_t error_count = parser->errors.count;
+        const size_t errors_dropped = parser->errors_dropped;
+
+        if (start_offset > region->end_offset) {
+            return;
+        }
+
+        INK_PARSER_RULE(node, ink_parse_stmt_level, parser, blocks, choices);
+
+        if (start_offset == region->end_offset) {
+            ink_parser_resume_save(parser, node, &region->end);
+            ink_parser_errors_shrink(&parser->errors, error_count);
+            parser->errors_dropped = errors_dropped;
+            region->is_valid = blocks->count == 1 && choices->count == 0 &&
+                               !parser->scanner.is_malformed;
+            return;
+        }
+        if (node) {
+            ink_parser_scratch_append(scratch, node);
+        }
+        if (is_first) {
+            ink_parser_resume_save(parser, node, &region->start);
+            is_first = false;
+        }
+        if (parser->flags & INK_PARSER_F_CACHING) {
+            ink_parser_cache_commit(&parser->cache, parser->current_offset);
+        }
+    }
+
+    region->is_valid = region->end_offset == SIZE_MAX &&
+                       !parser->scanner.is_malformed && scratch->count == 1 &&
+                       scratch->entries[0]->type == INK_NODE_BLOCK_STMT;
+}
+
+/*
+ * Parse each region on its own worker, once its start and end offsets are
+ * set.
+ */
+static int ink_parser_regions_parse(struct ink_arena *arena,
+                                    const struct ink_source *source,
+                                    struct ink_syntax_tree *syntax_tree,
+                                    int flags,
+                                    struct ink_parser_region *regions,
+                                    size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        struct ink_parser_region *region = &regions[i];
+
+        region->is_valid = false;
+
+        ink_arena_initialize(&region->arena, arena->default_block_size,
+                             arena->alignment);
+        ink_parser_initialize(&region->parser, source, syntax_tree,
+                              &region->arena,
+                              flags & ~INK_PARSER_F_PRELEXING);
+    }
+    return platform_run_tasks(ink_parse_region, regions, count);
+}
+
+/*
+ * Keep the results of parsing each region, reporting their errors in order
+ * as one parser would have, and handing their memory to `arena`.
+ */
+static void ink_parser_regions_keep(struct ink_arena *arena,
+                                    const struct ink_source *source,
+                                    struct ink_parser_region *regions,
+                                    size_t count)
+{
+    struct ink_parser_errors errors;
+    size_t dropped = 0;
+
+    ink_parser_errors_create(&errors);
+
+    for (size_t i = 0; i < count; i++) {
+        ink_parser_gather_errors(&regions[i].parser, &errors, &dropped);
+        ink_arena_adopt(arena, &regions[i].arena);
+    }
+
+    ink_parser_print_errors(source, &errors, dropped);
+    ink_parser_errors_destroy(&errors);
+}
+
+static void ink_parser_regions_cleanup(struct ink_parser_region *regions,
+                                       size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        ink_parser_cleanup(&regions[i].parser);
+        ink_arena_release(&regions[i].arena);
+    }
+}
+
+/*
+ * Check that each region was parsed exactly as a serial parse would have
+ * parsed it, which is when each worker ended in the same state that the
+ * next one reached after the knot declaration its region starts with.
+ */
+static bool ink_parser_regions_follow(const struct ink_parser_region *regions,
+                                      size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (!regions[i].is_valid) {
+            return false;
+        }
+        if (i > 0) {
+            const struct ink_parser_resume *start = &regions[i].start;
+
+            if (!ink_is_decl_type(start->type) ||
+                !ink_parser_resume_equal(&regions[i - 1].end, start)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * Join the statements parsed by each worker into the file's block, as it
+ * would have been reduced at the end of the file.
+ */
+static struct ink_syntax_node *
+ink_parser_stitch_regions(struct ink_arena *arena,
+                          const struct ink_parser_region *regions,
+                          size_t count)
+{
+    const struct ink_parser *first = &regions[0].parser;
+    const struct ink_parser *last = &regions[count - 1].parser;
+    const struct ink_syntax_node *block = last->scratch.entries[0];
+    const size_t start_offset = first->blocks.entries[0].source_offset;
+    struct ink_syntax_node *node;
+    struct ink_syntax_seq *seq;
+    size_t span = block->seq ? block->seq->count : 0;
+    size_t seq_index = 0;
+
+    for (size_t i = 0; i + 1 < count; i++) {
+        span += regions[i].parser.scratch.count;
+    }
+
+    seq = ink_arena_allocate(arena, sizeof(*seq) + span * sizeof(seq->nodes));
+    if (seq == NULL) {
+        return NULL;
+    }
+
+    seq->count = span;
+
+    for (size_t i = 0; i + 1 < count; i++) {
+        const struct ink_parser_scratch *scratch = &regions[i].parser.scratch;
+
+        for (size_t j = 0; j < scratch->count; j++) {
+            seq->nodes[seq_index++] = scratch->entries[j];
+        }
+    }
+    for (size_t j = 0; block->seq && j < block->seq->count; j++) {
+        seq->nodes[seq_index++] = block->seq->nodes[j];
+    }
+
+    node = ink_syntax_node_new(arena, INK_NODE_BLOCK_STMT, start_offset,
+                               block->end_offset, NULL, NULL, seq);
+    if (node == NULL) {
+        return NULL;
+    }
+
+    seq = ink_arena_allocate(arena, sizeof(*seq) + sizeof(seq->nodes));
+    if (seq == NULL) {
+        return NULL;
+    }
+
+    seq->count = 1;
+    seq->nodes[0] = node;
+
+    return ink_syntax_node_new(arena, INK_NODE_FILE, start_offset,
+                               last->current_offset, NULL, NULL, seq);
+}
+
+/**
+ * Parse a source file in parallel, splitting it between workers at the
+ * declarations of knots.
+ *
+ * Returns the number of regions parsed, or zero if the source could not be
+ * split, in which case it must be parsed serially. Streaming sources are
+ * never split, as they have not been received yet, and neither are sources
+ * being traced or profiled.
+ */
+static size_t ink_parse_regions(struct ink_arena *arena,
+                                const struct ink_source *source,
+                                struct ink_syntax_tree *syntax_tree, int flags,
+                                const struct ink_parser_output *output, int *rc)
+{
+    struct ink_parse_stats *stats = output->stats;
+    struct ink_parser_region *regions;
+    size_t jobs = output->jobs ? output->jobs : platform_cpu_count();
+    size_t capacity = source->length / INK_PARSER_REGION_MIN;
+    size_t count;
+    bool is_split = false;
+
+    if (source->is_streaming ||
+        (flags & (INK_PARSER_F_TRACING | INK_PARSER_F_PROFILING))) {
+        return 0;
+    }
+    if (capacity > jobs) {
+        capacity = jobs;
+    }
+    if (capacity < 2) {
+        return 0;
+    }
+
+    regions = platform_mem_alloc(capacity * sizeof(*regions));
+    if (regions == NULL) {
+        return 0;
+    }
+
+    count = ink_parser_split_source(source, regions, capacity);
+    if (count < 2) {
+        platform_mem_dealloc(regions, capacity * sizeof(*regions));
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        regions[i].end_offset =
+            i + 1 < count ? regions[i + 1].start_offset : SIZE_MAX;
+    }
+    if (ink_parser_regions_parse(arena, source, syntax_tree, flags, regions,
+                                 count) == 0 &&
+        ink_parser_regions_follow(regions, count)) {
+        is_split = true;
+
+        ink_parser_regions_keep(arena, source, regions, count);
+        syntax_tree->root = ink_parser_stitch_regions(arena, regions, count);
+        *rc = syntax_tree->root ? INK_E_OK : -INK_E_PARSE_FAIL;
+    }
+    if (is_split && stats) {
+        memset(stats, 0, sizeof(*stats));
+
+        for (size_t i = 0; i < count; i++) {
+            const struct ink_parser *parser = &regions[i].parser;
+
+            stats->lexed_bytes += parser->stats.lexed;
+            stats->relexed_bytes += parser->stats.relexed;
+            stats->peeked_bytes += parser->stats.peeked;
+            stats->rewinds += parser->stats.rewinds;
+            stats->memo_lookups += parser->cache.lookups;
+            stats->memo_hits += parser->cache.hits;
+            stats->memo_entries += parser->cache.count;
+            stats->memo_evicted += parser->cache.evicted;
+            stats->memo_bytes +=
+                parser->cache.capacity * sizeof(*parser->cache.entries);
+        }
+    }
+    ink_parser_regions_cleanup(regions, count);
+    platform_mem_dealloc(regions, capacity * sizeof(*regions));
+    return is_split ? count : 0;
+}
+
+/*
+ * A region of a previously parsed file, from one declaration of a knot or
+ * stitch at the top level of the file up to the next, as a range of
+ * statements in the file's block.
+ *
+ * Offsets are into the source as it was before editing. A region is edited
+ * when an edit touches it, or touches the declaration that ends it, since
+ * that is where its choices and blocks were closed. Otherwise, it is moved
+ * by the total change in length of the edits before it.
+ */
+struct ink_parser_reuse {
+    size_t first;
+    size_t last;
+    size_t start_offset;
+    size_t end_offset;
+    ptrdiff_t delta;
+    bool is_edited;
+    size_t region;
+};
+
+/*
+ * Find the start of the line containing `offset`.
+ */
+static size_t ink_parser_line_start(const struct ink_source *source,
+                                    size_t offset)
+{
+    while (offset > 0 && source->bytes[offset - 1] != '\n') {
+        offset--;
+    }
+    return offset;
+}
+
+/*
+ * Find where a region starts in the edited source, which is at the start
+ * of the line its declaration was moved to.
+ */
+static size_t ink_parser_reuse_start(const struct ink_source *source,
+                                     const struct ink_parser_reuse *reuse)
+{
+    return ink_parser_line_start(
+        source, (size_t)((ptrdiff_t)reuse->start_offset + reuse->delta));
+}
+
+/*
+ * Check whether a statement at the top level of the previous source starts
+ * a region. Declarations that follow another statement on the same line do
+ * not, as the statement before them was parsed from the start of the line.
+ */
+static bool ink_parser_is_boundary(const struct ink_source *source,
+                                   const struct ink_syntax_node *node)
+{
+    return ink_is_decl_type(node->type) &&
+           ink_parser_is_line_start(source, node->start_offset);
+}
+
+static bool ink_parse_edits_touch(const struct ink_parse_edit *edits,
+                                  size_t count, size_t start_offset,
+                                  size_t end_offset)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (edits[i].start_offset <= end_offset &&
+            edits[i].start_offset + edits[i].old_length >= start_offset) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Total change in length of the edits made before `offset`.
+ */
+static ptrdiff_t ink_parse_edits_delta(const struct ink_parse_edit *edits,
+                                       size_t count, size_t offset)
+{
+    ptrdiff_t delta = 0;
+
+    for (size_t i = 0; i < count && edits[i].start_offset < offset; i++) {
+        delta += (ptrdiff_t)edits[i].new_length -
+                 (ptrdiff_t)edits[i].old_length;
+    }
+    return delta;
+}
+
+static inline ink_offset_t ink_offset_move(ink_offset_t offset,
+                                           ptrdiff_t delta)
+{
+    return (ink_offset_t)((ptrdiff_t)offset + delta);
+}
+
+/*
+ * Move a subtree by `delta` bytes.
+ *
+ * Gathered choices are created with a start offset of zero, rather than at
+ * their choices, so theirs is left as it is.
+ */
+static void ink_syntax_node_move(struct ink_syntax_node *node,
+                                 ptrdiff_t delta)
+{
+    if (node == NULL) {
+        return;
+    }
+    if (node->type != INK_NODE_GATHERED_CHOICE_STMT) {
+        node->start_offset = ink_offset_move(node->start_offset, delta);
+    }
+
+    node->end_offset = ink_offset_move(node->end_offset, delta);
+
+    ink_syntax_node_move(node->lhs, delta);
+    ink_syntax_node_move(node->rhs, delta);
+
+    if (node->seq) {
+        for (size_t i = 0; i < node->seq->count; i++) {
+            ink_syntax_node_move(node->seq->nodes[i], delta);
+        }
+    }
+}
+
+/*
+ * Check that each edited run of regions was parsed exactly as a serial
+ * parse of the edited source would have parsed it. A run that ends before
+ * the end of the file must end in the same state as a fresh parse of the
+ * declaration that starts the next region, and that declaration must have
+ * only moved.
+ */
+static bool ink_parser_reuse_follows(const struct ink_parser_reuse *reuses,
+                                     size_t count,
+                                     const struct ink_syntax_seq *stmts,
+                                     const struct ink_parser_region *regions)
+{
+    for (size_t i = 0; i < count; i++) {
+        const struct ink_parser_region *region = &regions[reuses[i].region];
+        const struct ink_parser_region *probe = region + 1;
+        const struct ink_syntax_node *decl;
+
+        if (!reuses[i].is_edited || (i > 0 && reuses[i - 1].is_edited)) {
+            continue;
+        }
+        if (!region->is_valid || (region->start_offset > 0 &&
+                                  !ink_is_decl_type(region->start.type))) {
+            return false;
+        }
+        while (i + 1 < count && reuses[i + 1].is_edited) {
+            i++;
+        }
+        if (i + 1 == count) {
+            continue;
+        }
+
+        decl = stmts->nodes[reuses[i + 1].first];
+
+        if (!probe->is_valid ||
+            !ink_parser_resume_equal(&region->end, &probe->end) ||
+            probe->end.type != decl->type ||
+            probe->end.start_offset !=
+                ink_offset_move(decl->start_offset, reuses[i + 1].delta) ||
+            probe->end.end_offset !=
+                ink_offset_move(decl->end_offset, reuses[i + 1].delta)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Find the statements parsed by a worker. A region that runs to the end of
+ * the file has had them reduced into the file's block already.
+ */
+static struct ink_syntax_node **
+ink_parser_region_stmts(const struct ink_parser_region *region, size_t *count)
+{
+    const struct ink_parser_scratch *scratch = &region->parser.scratch;
+    struct ink_syntax_node *block;
+
+    if (region->end_offset != SIZE_MAX) {
+        *count = scratch->count;
+        return scratch->entries;
+    }
+
+    block = scratch->entries[0];
+    if (block->seq == NULL) {
+        *count = 0;
+        return NULL;
+    }
+
+    *count = block->seq->count;
+    return block->seq->nodes;
+}
+
+/*
+ * Join the statements of the regions that were only moved with those of
+ * the edited runs of regions, which were parsed again, updating the file's
+ * block in place.
+ */
+static struct ink_syntax_node *
+ink_parser_stitch_reuses(struct ink_arena *arena, struct ink_syntax_node *file,
+                         const struct ink_parser_reuse *reuses, size_t count,
+                         const struct ink_parser_region *regions)
+{
+    struct ink_syntax_node *block = file->seq->nodes[0];
+    const struct ink_syntax_seq *stmts = block->seq;
+    const struct ink_parser_reuse *last = &reuses[count - 1];
+    struct ink_syntax_node **nodes;
+    struct ink_syntax_seq *seq;
+    size_t span = 0;
+    size_t seq_index = 0;
+    size_t node_count;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!reuses[i].is_edited) {
+            span += reuses[i].last - reuses[i].first;
+        } else if (i == 0 || !reuses[i - 1].is_edited) {
+            ink_parser_region_stmts(&regions[reuses[i].region], &node_count);
+            span += node_count;
+        }
+    }
+
+    if (span > 0) {
+        seq = ink_arena_allocate(arena,
+                                 sizeof(*seq) + span * sizeof(seq->nodes));
+        if (seq == NULL) {
+            return NULL;
+        }
+
+        seq->count = span;
+    } else {
+        seq = NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const struct ink_parser_reuse *reuse = &reuses[i];
+
+        if (!reuse->is_edited) {
+            for (size_t j = reuse->first; j < reuse->last; j++) {
+                if (reuse->delta != 0) {
+                    ink_syntax_node_move(stmts->nodes[j], reuse->delta);
+                }
+
+                seq->nodes[seq_index++] = stmts->nodes[j];
+            }
+        } else if (i == 0 || !reuses[i - 1].is_edited) {
+            nodes =
+                ink_parser_region_stmts(&regions[reuse->region], &node_count);
+
+            for (size_t j = 0; j < node_count; j++) {
+                seq->nodes[seq_index++] = nodes[j];
+            }
+        }
+    }
+    if (reuses[0].is_edited) {
+        const struct ink_parser *parser = &regions[reuses[0].region].parser;
+
+        block->start_offset =
+            (ink_offset_t)parser->blocks.entries[0].source_offset;
+    }
+    if (last->is_edited) {
+        const struct ink_parser *parser = &regions[last->region].parser;
+
+        block->end_offset = parser->scratch.entries[0]->end_offset;
+        file->end_offset = (ink_offset_t)parser->current_offset;
+    } else {
+        block->end_offset = ink_offset_move(block->end_offset, last->delta);
+        file->end_offset = ink_offset_move(file->end_offset, last->delta);
+    }
+
+    file->start_offset = block->start_offset;
+    block->seq = seq;
+    return file;
+}
+
+/**
+ * Parse an edited source again, reusing the syntax tree of the source as
+ * it was before wherever the edits did not reach.
+ *
+ * The file's statements are split into regions at the declarations of
+ * knots and stitches. Each run of edited regions is parsed again on its own
+ * worker, as when parsing in parallel, and the statements of every other
+ * region are moved in place. Returns false, leaving the syntax tree as it
+ * was, if it cannot be reused.
+ */
+static bool ink_parser_reparse(struct ink_arena *arena,
+                               const struct ink_source *source,
+                               struct ink_syntax_tree *syntax_tree, int flags,
+                               const struct ink_parse_edit *edits,
+                               size_t edit_count)
+{
+    struct ink_syntax_node *file = syntax_tree->root;
+    const struct ink_syntax_seq *stmts;
+    struct ink_parser_reuse *reuses = NULL;
+    struct ink_parser_region *regions = NULL;
+    size_t count = 1;
+    size_t region_count = 0;
+    size_t j = 0;
+    bool is_reused = false;
+
+    if (source->is_streaming ||
+        (flags & (INK_PARSER_F_TRACING | INK_PARSER_F_PROFILING)) ||
+        file == NULL || file->type != INK_NODE_FILE || file->seq == NULL ||
+        file->seq->count != 1 ||
+        file->seq->nodes[0]->type != INK_NODE_BLOCK_STMT ||
+        file->seq->nodes[0]->seq == NULL) {
+        return false;
+    }
+
+    stmts = file->seq->nodes[0]->seq;
+
+    for (size_t i = 1; i < stmts->count; i++) {
+        if (ink_parser_is_boundary(syntax_tree->source, stmts->nodes[i])) {
+            count++;
+        }
+    }
+
+    reuses = platform_mem_alloc(count * sizeof(*reuses));
+    regions = platform_mem_alloc(2 * count * sizeof(*regions));
+    if (reuses == NULL || regions == NULL) {
+        goto cleanup;
+    }
+
+    reuses[0].first = 0;
+    reuses[0].start_offset = 0;
+
+    for (size_t i = 1; i < stmts->count; i++) {
+        const struct ink_syntax_node *node = stmts->nodes[i];
+
+        if (ink_parser_is_boundary(syntax_tree->source, node)) {
+            reuses[j].last = i;
+            reuses[j].end_offset = node->end_offset;
+            j++;
+            reuses[j].first = i;
+            reuses[j].start_offset = node->start_offset;
+        }
+    }
+
+    reuses[j].last = stmts->count;
+    reuses[j].end_offset = SIZE_MAX;
+
+    for (size_t i = 0; i < count; i++) {
+        struct ink_parser_reuse *reuse = &reuses[i];
+
+        reuse->delta =
+            ink_parse_edits_delta(edits, edit_count, reuse->start_offset);
+        reuse->is_edited =
+            ink_parse_edits_touch(edits, edit_count, reuse->start_offset,
+                                  reuse->end_offset);
+        reuse->region = 0;
+
+        if ((ptrdiff_t)reuse->start_offset + reuse->delta >
+            (ptrdiff_t)source->length) {
+            goto cleanup;
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        struct ink_parser_region *region = &regions[region_count];
+        size_t end = i;
+
+        if (!reuses[i].is_edited) {
+            continue;
+        }
+        while (end < count && reuses[end].is_edited) {
+            reuses[end++].region = region_count;
+        }
+
+        region->start_offset = ink_parser_reuse_start(source, &reuses[i]);
+        region->end_offset =
+            end == count ? SIZE_MAX
+                         : ink_parser_reuse_start(source, &reuses[end]);
+        region_count++;
+
+        if (region->end_offset != SIZE_MAX) {
+            regions[region_count].start_offset = region->end_offset;
+            regions[region_count].end_offset = region->end_offset;
+            region_count++;
+        }
+
+        i = end - 1;
+    }
+    if (ink_parser_regions_parse(arena, source, syntax_tree, flags, regions,
+                                 region_count) == 0 &&
+        ink_parser_reuse_follows(reuses, count, stmts, regions)) {
+        is_reused = true;
+
+        for (size_t i = 0; i < count; i++) {
+            if (reuses[i].is_edited && (i == 0 || !reuses[i - 1].is_edited)) {
+                ink_parser_report_errors(&regions[reuses[i].region].parser);
+            }
+        }
+        for (size_t i = 0; i < region_count; i++) {
+            ink_arena_adopt(arena, &regions[i].arena);
+        }
+
+        syntax_tree->source = source;
+        syntax_tree->root =
+            ink_parser_stitch_reuses(arena, file, reuses, count, regions);
+    }
+
+    ink_parser_regions_cleanup(regions, region_count);
+cleanup:
+    if (regions) {
+        platform_mem_dealloc(regions, 2 * count * sizeof(*regions));
+    }
+    if (reuses) {
+        platform_mem_dealloc(reuses, count * sizeof(*reuses));
+    }
+    return is_reused;
+}
+
+/*
+ * Parse a file without parsing the statements between its declarations of
+ * knots, stitches and functions, which are left as lazy blocks until they
+ * are accessed.
+ *
+ * Lines that declare global variables, constants and lists are parsed as
+ * well, and kept in the lazy block they were found in, so that the block's
+ * sequence indexes them until it is parsed. Everything else is skipped by
+ * the pre-scanner, up to the last declaration, after which the file is
+ * parsed in full.
+ */
+static struct ink_syntax_node *ink_parse_file_lazily(struct ink_parser *parser)
+{
+    const struct ink_source *source = parser->scanner.source;
+    const size_t scratch_offset = parser->scratch.count;
+    const size_t start_offset = parser->current_offset;
+    const unsigned int types = INK_BOUNDARY_DECLS | INK_BOUNDARY_GLOBALS;
+    struct ink_parser_scratch *scratch = &parser->scratch;
+    struct ink_parser_context_stack *blocks = &parser->blocks;
+    struct ink_parser_context_stack *choices = &parser->choices;
+    struct ink_syntax_node *node;
+
+    ink_parser_stack_push(blocks, 0, 0, start_offset);
+
+    while (parser->current_level >= 0) {
+        const size_t body_offset = parser->current_offset;
+        const size_t body_scratch = scratch->count;
+        struct ink_boundary first, boundary;
+        const size_t first_offset = ink_prescan_next(
+            source->bytes, body_offset, source->length, types, &first);
+        size_t offset = first_offset;
+
+        boundary = first;
+        while (offset < source->length &&
+               (INK_BOUNDARY_BIT(boundary.type) & INK_BOUNDARY_GLOBALS)) {
+            offset = ink_prescan_next(source->bytes, boundary.name_offset,
+                                      source->length, types, &boundary);
+        }
+        /*
+         * What follows the last declaration is parsed as it would be by a
+         * serial parse, so that the file ends where that parse ends it.
+         */
+        if (offset >= source->length) {
+            break;
+        }
+
+        offset = first_offset;
+        boundary = first;
+        while (offset < source->length &&
+               (INK_BOUNDARY_BIT(boundary.type) & INK_BOUNDARY_GLOBALS)) {
+            ink_parser_seek(parser, offset);
+            INK_PARSER_RULE(node, ink_parse_stmt, parser);
+
+            if (node) {
+                ink_parser_scratch_append(scratch, node);
+            }
+
+            offset = parser->current_offset > boundary.name_offset
+                         ? parser->current_offset
+                         : boundary.name_offset;
+            offset = ink_prescan_next(source->bytes, offset, source->length,
+                                      types, &boundary);
+        }
+
+        ink_parser_seek(parser, offset);
+        if (parser->current_offset > body_offset) {
+            node = ink_parser_create_sequence(
+                parser, INK_NODE_LAZY_BLOCK_STMT, body_offset,
+                parser->current_offset, body_scratch);
+            ink_parser_scratch_append(scratch, node);
+        }
+
+        INK_PARSER_RULE(node, ink_parse_stmt_level, parser, blocks, choices);
+
+        if (node) {
+            ink_parser_scratch_append(scratch, node);
+        }
+        if (parser->flags & INK_PARSER_F_CACHING) {
+            ink_parser_cache_commit(&parser->cache, parser->current_offset);
+        }
+    }
+    while (parser->current_level >= 0) {
+        INK_PARSER_RULE(node, ink_parse_stmt_level, parser, blocks, choices);
+
+        if (node) {
+            ink_parser_scratch_append(scratch, node);
+        }
+        if (parser->flags & INK_PARSER_F_CACHING) {
+            ink_parser_cache_commit(&parser->cache, parser->current_offset);
+        }
+    }
+    return ink_parser_create_sequence(parser, INK_NODE_FILE, start_offset,
+                                      parser->current_offset, scratch_offset);
+}
+
+/*
+ * Parse the statements of a lazy block into `*seq`, as the region of the
+ * file that runs from the start of the block up to the declaration that
+ * follows it, and gather the errors raised.
+ *
+ * The block is only parsed if the region was parsed exactly as a serial
+ * parse would have parsed it, which is when it ends at a declaration of a
+ * knot, stitch or function with no choices or blocks left open.
  */
-int ink_parse(struct ink_arena *arena, const struct ink_source *source,
-              struct ink_syntax_tree *syntax_tree, int flags)
+static int ink_parse_body(struct ink_syntax_tree *syntax_tree,
+                          const struct ink_syntax_node *node,
+                          struct ink_syntax_seq **seq,
+                          struct ink_parser_errors *errors, size_t *dropped)
 {
+    struct ink_parser_region region;
+    struct ink_parser *parser = &region.parser;
+    struct ink_syntax_node **nodes;
+    size_t count;
     int rc;
-    struct ink_parser parser;
 
-    rc = ink_parser_initialize(&parser, source, syntax_tree, arena, flags);
+    *seq = NULL;
+
+    region.start_offset = node->start_offset;
+    region.end_offset = node->end_offset;
+    region.is_valid = false;
+
+    rc = ink_parser_initialize(parser, syntax_tree->source, syntax_tree,
+                               syntax_tree->arena, syntax_tree->flags);
     if (rc < 0) {
         return rc;
     }
 
-    ink_parser_next_token(&parser);
+    ink_parse_region(&region, 0);
+
+    if (!region.is_valid || !ink_is_decl_type(region.end.type)) {
+        rc = -INK_E_PARSE_FAIL;
+        goto cleanup;
+    }
+
+    nodes = ink_parser_region_stmts(&region, &count);
+    if (count > 0) {
+        *seq = ink_arena_allocate(syntax_tree->arena,
+                                  sizeof(**seq) + count * sizeof(nodes[0]));
+        if (*seq == NULL) {
+            rc = -INK_E_OOM;
+            goto cleanup;
+        }
+
+        (*seq)->count = count;
+        memcpy((*seq)->nodes, nodes, count * sizeof(*nodes));
+    }
+
+    ink_parser_gather_errors(parser, errors, dropped);
+cleanup:
+    ink_parser_cleanup(parser);
+    return rc;
+}
+
+/*
+ * Parse the statements of lazy blocks, given in the order they appear in
+ * the file. Once parsed, each becomes an ordinary block holding them.
+ *
+ * Either every block is parsed, and the errors raised in them are reported
+ * together as a serial parse would have reported them, or none is, and
+ * nothing is reported, so that the caller can parse the file in full
+ * without reporting any error twice.
+ */
+static int ink_parse_bodies(struct ink_syntax_tree *syntax_tree,
+                            struct ink_syntax_node **nodes, size_t count)
+{
+    struct ink_parser_errors errors;
+    struct ink_syntax_seq **seqs;
+    size_t dropped = 0;
+    int rc = INK_E_OK;
+
+    if (count == 0) {
+        return INK_E_OK;
+    }
+
+    seqs = platform_mem_alloc(count * sizeof(*seqs));
+    if (seqs == NULL) {
+        return -INK_E_OOM;
+    }
+
+    ink_parser_errors_create(&errors);
+
+    for (size_t i = 0; i < count && rc == INK_E_OK; i++) {
+        rc = ink_parse_body(syntax_tree, nodes[i], &seqs[i], &errors,
+                            &dropped);
+    }
+    if (rc == INK_E_OK) {
+        for (size_t i = 0; i < count; i++) {
+            nodes[i]->type = INK_NODE_BLOCK_STMT;
+            nodes[i]->seq = seqs[i];
+        }
+
+        ink_parser_print_errors(syntax_tree->source, &errors, dropped);
+    }
+
+    ink_parser_errors_destroy(&errors);
+    platform_mem_dealloc(seqs, count * sizeof(*seqs));
+    return rc;
+}
+
+/*
+ * Mask out the flags that do not apply to a parse of `source` into
+ * `output`.
+ */
+static int ink_parser_output_flags(const struct ink_source *source, int flags,
+                                   const struct ink_parser_output *output)
+{
+    if (source->is_streaming) {
+        flags &= ~INK_PARSER_F_LAZY;
+    }
+    /*
+     * Memoized results, and the nodes of lazy and parallel parses, outlive
+     * the statement they were parsed for, and the profiler and tracer would
+     * only see a parse that is not the usual one.
+     */
+    if (output->sink) {
+        flags &= ~(INK_PARSER_F_CACHING | INK_PARSER_F_PARALLEL |
+                   INK_PARSER_F_LAZY | INK_PARSER_F_PROFILING |
+                   INK_PARSER_F_TRACING);
+    }
+    return flags;
+}
+
+/*
+ * Run a parser readied for a source, outputting a syntax tree along with
+ * whatever else `output` asks for.
+ */
+static int ink_parser_run(struct ink_parser *parser,
+                          struct ink_syntax_tree *syntax_tree,
+                          const struct ink_parser_output *output)
+{
+    struct ink_parse_stats *stats = output->stats;
+    struct ink_arena *arena = parser->arena;
+    const int flags = parser->flags;
+    int rc;
+
+    if (flags & INK_PARSER_F_PROFILING) {
+        ink_parser_profile_start(&parser->profile);
+    }
+
+    parser->trace.output = output->trace;
+
+    if (output->sink) {
+        parser->sink = output->sink;
+        ink_arena_save(arena, &parser->mark);
+    }
+
+    ink_parser_next_token(parser);
 
-    syntax_tree->root = ink_parse_file(&parser);
-    if (syntax_tree->root) {
+    if (flags & INK_PARSER_F_LAZY) {
+        syntax_tree->arena = arena;
+        syntax_tree->flags =
+            flags & ~(INK_PARSER_F_LAZY | INK_PARSER_F_PRELEXING |
+                      INK_PARSER_F_TRACING | INK_PARSER_F_PROFILING);
+        syntax_tree->parse_bodies = ink_parse_bodies;
+        syntax_tree->root = ink_parse_file_lazily(parser);
+    } else {
+        syntax_tree->root = ink_parse_file(parser);
+    }
+    if (parser->scanner.is_malformed) {
+        rc = -INK_E_FILE_ENCODING;
+    } else if (syntax_tree->root) {
         rc = INK_E_OK;
     } else {
         rc = -INK_E_PARSE_FAIL;
     }
+    if (parser->sink) {
+        if (parser->errors.count > 0 || parser->errors_dropped > 0) {
+            rc = -INK_E_PARSE_FAIL;
+        }
+
+        syntax_tree->root = NULL;
+        ink_arena_restore(arena, &parser->mark);
+    }
+
+    ink_parser_report_errors(parser);
 
     /*
     ink_trace("left over blocks=%zu, left over choices=%zu, left over "
               "nodes=%zu, current level=%d",
-              parser.blocks.count, parser.choices.count, parser.scratch.count,
-              parser.current_level);
+              parser->blocks.count, parser->choices.count,
+              parser->scratch.count, parser->current_level);
     */
 
+    if (flags & INK_PARSER_F_PROFILING) {
+        ink_parser_profile_exit(&parser->profile);
+
+        if (output->summary) {
+            ink_parser_profile_write_summary(&parser->profile,
+                                             output->summary);
+        }
+        if (output->stacks) {
+            ink_parser_profile_write_stacks(&parser->profile, output->stacks);
+        }
+    }
+    if (flags & INK_PARSER_F_TRACING) {
+        ink_parser_trace_flush(parser);
+    }
+    if (stats) {
+        stats->lexed_bytes = parser->stats.lexed;
+        stats->relexed_bytes = parser->stats.relexed;
+        stats->peeked_bytes = parser->stats.peeked;
+        stats->rewinds = parser->stats.rewinds;
+        stats->memo_lookups = parser->cache.lookups;
+        stats->memo_hits = parser->cache.hits;
+        stats->memo_entries = parser->cache.count;
+        stats->memo_evicted = parser->cache.evicted;
+        stats->memo_bytes =
+            parser->cache.capacity * sizeof(*parser->cache.entries);
+    }
+    return rc;
+}
+
+/**
+ * Parse a source file and output a syntax tree, along with whatever else
+ * `output` asks for.
+ *
+ * Streaming sources are filled as the scanner consumes them, so parsing can
+ * overlap with the arrival of the remaining input.
+ */
+static int ink_parse_source(struct ink_arena *arena, struct ink_source *source,
+                            struct ink_syntax_tree *syntax_tree, int flags,
+                            const struct ink_parser_output *output)
+{
+    int rc;
+    struct ink_parser parser;
+
+    flags = ink_parser_output_flags(source, flags, output);
+    if ((flags & INK_PARSER_F_PARALLEL) && !(flags & INK_PARSER_F_LAZY) &&
+        ink_parse_regions(arena, source, syntax_tree, flags, output, &rc)) {
+        return rc;
+    }
+
+    rc = ink_parser_initialize(&parser, source, syntax_tree, arena, flags);
+    if (rc < 0) {
+        return rc;
+    }
+
+    ink_parser_stream(&parser, source);
+    rc = ink_parser_run(&parser, syntax_tree, output);
     ink_parser_cleanup(&parser);
+    return rc;
+}
+
+/**
+ * Limit the memoization table of each parser to `bytes`, for parses started
+ * from now on. Once a table reaches its limit, results are evicted from it,
+ * and if none can be, they are no longer memoized. The limit is
+ * INK_PARSER_CACHE_LIMIT until set, and must not be set while parsing.
+ */
+void ink_parse_set_cache_limit(size_t bytes)
+{
+    ink_parser_cache_limit = bytes;
+}
+
+/**
+ * Parse a source file and output a syntax tree.
+ *
+ * The source is only written to while it is still being received from a
+ * stream, as the scanner appends the bytes that arrive. When profiling, a
+ * summary of the profile is written to STDOUT.
+ */
+int ink_parse(struct ink_arena *arena, struct ink_source *source,
+              struct ink_syntax_tree *syntax_tree, int flags)
+{
+    return ink_parse_with_stats(arena, source, syntax_tree, flags, NULL);
+}
+
+/**
+ * Parse a source file and output a syntax tree, recording counters for the
+ * parse in `stats` unless it is NULL.
+ */
+int ink_parse_with_stats(struct ink_arena *arena, struct ink_source *source,
+                         struct ink_syntax_tree *syntax_tree, int flags,
+                         struct ink_parse_stats *stats)
+{
+    const struct ink_parser_output output = {
+        .stats = stats,
+        .summary = stdout,
+        .stacks = NULL,
+        .trace = NULL,
+        .jobs = 0,
+    };
+
+    return ink_parse_source(arena, source, syntax_tree, flags, &output);
+}
+
+/**
+ * Parse a source file, reporting its syntax tree to `sink` as it goes.
+ */
+int ink_parse_events(struct ink_arena *arena, struct ink_source *source,
+                     int flags, const struct ink_parse_sink *sink)
+{
+    struct ink_syntax_tree syntax_tree;
+    const struct ink_parser_output output = {
+        .stats = NULL,
+        .summary = NULL,
+        .stacks = NULL,
+        .trace = NULL,
+        .jobs = 0,
+        .sink = sink ? sink : &INK_PARSER_NULL_SINK,
+    };
+    int rc;
+
+    rc = ink_syntax_tree_initialize(source, &syntax_tree);
+    if (rc < 0) {
+        return rc;
+    }
+
+    rc = ink_parse_source(arena, source, &syntax_tree, flags, &output);
+    ink_syntax_tree_cleanup(&syntax_tree);
+    return rc;
+}
+
+/**
+ * Parse session.
+ *
+ * Keeps a parser and an arena from one parse to the next. The parser's
+ * stacks, scratch buffer, token buffers and memoization table are emptied
+ * rather than freed, and the arena is restored to where it started rather
+ * than released, so once a session has parsed a source as large as the
+ * next one, parsing it allocates nothing more.
+ */
+struct ink_parse_session {
+    struct ink_arena arena;
+    struct ink_arena_mark start;
+    struct ink_parser parser;
+    bool is_warm;
+};
+
+/**
+ * Create a parse session, returning NULL if out of memory.
+ */
+struct ink_parse_session *ink_parse_session_new(void)
+{
+    struct ink_parse_session *session;
+
+    session = platform_mem_alloc(sizeof(*session));
+    if (session == NULL) {
+        return NULL;
+    }
+
+    ink_arena_initialize(&session->arena, INK_PARSE_SESSION_BLOCK_SIZE,
+                         INK_PARSE_SESSION_ALIGNMENT);
+    ink_arena_save(&session->arena, &session->start);
+    session->is_warm = false;
+    return session;
+}
+
+/**
+ * Free a parse session, along with every syntax tree parsed with it.
+ */
+void ink_parse_session_free(struct ink_parse_session *session)
+{
+    if (session->is_warm) {
+        ink_parser_cleanup(&session->parser);
+    }
+
+    ink_arena_release(&session->arena);
+    platform_mem_dealloc(session, sizeof(*session));
+}
+
+/*
+ * Parse a source with a session's parser and arena, giving back the memory
+ * of the syntax tree it parsed before.
+ *
+ * Profiling and tracing are left to `ink_parse_profile` and
+ * `ink_parse_trace`, which write their results out once done.
+ */
+static int ink_parse_session_run(struct ink_parse_session *session,
+                                 struct ink_source *source,
+                                 struct ink_syntax_tree *syntax_tree,
+                                 int flags,
+                                 const struct ink_parser_output *output)
+{
+    struct ink_parser *parser = &session->parser;
+    int rc;
+
+    flags &= ~(INK_PARSER_F_PROFILING | INK_PARSER_F_TRACING);
+    flags = ink_parser_output_flags(source, flags, output);
+    ink_arena_restore(&session->arena, &session->start);
+
+    if ((flags & INK_PARSER_F_PARALLEL) && !(flags & INK_PARSER_F_LAZY) &&
+        ink_parse_regions(&session->arena, source, syntax_tree, flags, output,
+                          &rc)) {
+        return rc;
+    }
+    if (session->is_warm) {
+        ink_parser_reset(parser, source, &session->arena, flags);
+    } else {
+        rc = ink_parser_initialize(parser, source, syntax_tree,
+                                   &session->arena, flags);
+        if (rc < 0) {
+            return rc;
+        }
+
+        session->is_warm = true;
+    }
+
+    ink_parser_stream(parser, source);
+    return ink_parser_run(parser, syntax_tree, output);
+}
+
+/**
+ * Parse a source file with a session and output a syntax tree.
+ *
+ * The tree is kept in the session's arena, and is only valid until the
+ * session parses another source or is freed.
+ */
+int ink_parse_session_parse(struct ink_parse_session *session,
+                            struct ink_source *source,
+                            struct ink_syntax_tree *syntax_tree, int flags)
+{
+    const struct ink_parser_output output = {
+        .stats = NULL,
+        .summary = NULL,
+        .stacks = NULL,
+        .trace = NULL,
+        .jobs = 0,
+        .sink = NULL,
+    };
+
+    return ink_parse_session_run(session, source, syntax_tree, flags,
+                                 &output);
+}
+
+/**
+ * Parse a source file with a session, reporting its syntax tree to `sink`
+ * as it goes, or only checking it if `sink` is NULL.
+ */
+int ink_parse_session_events(struct ink_parse_session *session,
+                             struct ink_source *source, int flags,
+                             const struct ink_parse_sink *sink)
+{
+    struct ink_syntax_tree syntax_tree;
+    const struct ink_parser_output output = {
+        .stats = NULL,
+        .summary = NULL,
+        .stacks = NULL,
+        .trace = NULL,
+        .jobs = 0,
+        .sink = sink ? sink : &INK_PARSER_NULL_SINK,
+    };
+    int rc;
+
+    rc = ink_syntax_tree_initialize(source, &syntax_tree);
+    if (rc < 0) {
+        return rc;
+    }
 
+    rc = ink_parse_session_run(session, source, &syntax_tree, flags, &output);
+    ink_syntax_tree_cleanup(&syntax_tree);
     return rc;
 }
+
+/**
+ * Parse a source file and output a syntax tree, splitting the source between
+ * up to `jobs` workers at the declarations of knots.
+ *
+ * Sources too small to be worth splitting, and those with too few knots to
+ * split, are parsed serially.
+ */
+int ink_parse_parallel(struct ink_arena *arena, struct ink_source *source,
+                       struct ink_syntax_tree *syntax_tree, int flags,
+                       size_t jobs)
+{
+    const struct ink_parser_output output = {
+        .stats = NULL,
+        .summary = stdout,
+        .stacks = NULL,
+        .trace = NULL,
+        .jobs = jobs,
+    };
+
+    return ink_parse_source(arena, source, syntax_tree,
+                            flags | INK_PARSER_F_PARALLEL, &output);
+}
+
+/**
+ * Parse an edited source, reusing the syntax tree of the source as it was
+ * before the edits.
+ *
+ * On entry, `syntax_tree` holds the tree of the previous source, whose
+ * nodes must have been allocated from `arena`, and the previous source must
+ * still be loaded. Only the knots and stitches
+ * touched by an edit are parsed again; the subtrees of the others are
+ * moved in place to their new offsets, so the previous tree is consumed.
+ * Errors are only reported for the parts parsed again. If the previous
+ * tree cannot be reused, the source is parsed in full.
+ */
+int ink_parse_incremental(struct ink_arena *arena, struct ink_source *source,
+                          struct ink_syntax_tree *syntax_tree, int flags,
+                          const struct ink_parse_edit *edits, size_t count)
+{
+    if (ink_parser_reparse(arena, source, syntax_tree, flags, edits, count)) {
+        return syntax_tree->root ? INK_E_OK : -INK_E_PARSE_FAIL;
+    }
+
+    ink_syntax_tree_initialize(source, syntax_tree);
+    return ink_parse(arena, source, syntax_tree, flags);
+}
+
+/**
+ * Parse a source file and output a syntax tree, profiling the parser.
+ */
+int ink_parse_profile(struct ink_arena *arena, struct ink_source *source,
+                      struct ink_syntax_tree *syntax_tree, int flags,
+                      FILE *summary, FILE *stacks)
+{
+    const struct ink_parser_output output = {
+        .stats = NULL,
+        .summary = summary,
+        .stacks = stacks,
+        .trace = NULL,
+        .jobs = 0,
+    };
+
+    return ink_parse_source(arena, source, syntax_tree,
+                            flags | INK_PARSER_F_PROFILING, &output);
+}
+
+/**
+ * Parse a source file and output a syntax tree, saving the trace of the
+ * parse to `trace`.
+ */
+int ink_parse_trace(struct ink_arena *arena, struct ink_source *source,
+                    struct ink_syntax_tree *syntax_tree, int flags,
+                    FILE *trace)
+{
+    const struct ink_parser_output output = {
+        .stats = NULL,
+        .summary = stdout,
+        .stacks = NULL,
+        .trace = trace,
+        .jobs = 0,
+    };
+
+    return ink_parse_source(arena, source, syntax_tree,
+                            flags | INK_PARSER_F_TRACING, &output);
+}
+
+/**
+ * Print a saved trace in human-readable form.
+ */
+int ink_parse_trace_decode(FILE *input, FILE *output)
+{
+    int rc;
+    struct ink_parser_trace_header header;
+    struct ink_parser_trace_event event;
+
+    if (fread(&header, sizeof(header), 1, input) != 1 ||
+        memcmp(header.magic, INK_PARSER_TRACE_MAGIC, sizeof(header.magic)) ||
+        header.version != INK_PARSER_TRACE_VERSION ||
+        header.event_size != sizeof(event)) {
+        return -INK_E_FILE;
+    }
+
+    ink_parser_trace_print_dropped(header.recorded, header.count, output);
+
+    for (uint64_t i = 0; i < header.count; i++) {
+        if (fread(&event, sizeof(event), 1, input) != 1) {
+            return -INK_E_FILE;
+        }
+
+        rc = ink_parser_trace_print(&event, output);
+        if (rc < 0) {
+            return rc;
+        }
+    }
+
+    ink_parser_trace_print_summary(&header.summary, output);
+    return INK_E_OK;
+}
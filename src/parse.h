@@ -7,6 +7,10 @@ extern "C" {
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
+
+#include "common.h"
+#include "tree.h"
 
 #define INK_PARSE_DEPTH 128
 
@@ -17,10 +21,146 @@ struct ink_syntax_tree;
 enum ink_parser_flags {
     INK_PARSER_F_TRACING = (1 << 0),
     INK_PARSER_F_CACHING = (1 << 1),
+    INK_PARSER_F_BUFFERING = (1 << 2),
+    INK_PARSER_F_PRELEXING = (1 << 3),
+    INK_PARSER_F_PROFILING = (1 << 4),
+    INK_PARSER_F_PARALLEL = (1 << 5),
+    INK_PARSER_F_LAZY = (1 << 6),
+};
+
+/**
+ * Counters gathered over a single parse.
+ *
+ * Relexed bytes are those lexed again after the scanner was rewound past
+ * them, and peeked bytes those lexed ahead of the parser to decide between
+ * productions, which are lexed again once it reaches them. Rewinds count
+ * every time the parser backtracked to try another production.
+ *
+ * Memo bytes are the size of the memoization table once parsing finished,
+ * and memo entries those left in it after any evictions.
+ * The memo counters are zero unless INK_PARSER_F_CACHING was set.
+ */
+struct ink_parse_stats {
+    size_t lexed_bytes;
+    size_t relexed_bytes;
+    size_t peeked_bytes;
+    size_t rewinds;
+    size_t memo_lookups;
+    size_t memo_hits;
+    size_t memo_entries;
+    size_t memo_evicted;
+    size_t memo_bytes;
+};
+
+/**
+ * An edit to a source, replacing `old_length` bytes from `start_offset` with
+ * `new_length` new bytes. Offsets are into the source as it was before any
+ * of the edits were made.
+ */
+struct ink_parse_edit {
+    size_t start_offset;
+    size_t old_length;
+    size_t new_length;
+};
+
+/**
+ * Receiver of the events of a parse, in place of a syntax tree.
+ *
+ * Nodes with children are reported by `enter` before their children and by
+ * `leave` after them, and nodes without any by `token`, in the order the
+ * syntax tree printer visits them. The file and its block are always
+ * entered and left, even when empty, since they are entered before anything
+ * is parsed. Offsets are into the source, and `enter` is only given where a
+ * node starts. Any of the callbacks may be NULL.
+ */
+struct ink_parse_sink {
+    void *context;
+    void (*enter)(void *context, enum ink_syntax_node_type type,
+                  size_t start_offset);
+    void (*leave)(void *context, enum ink_syntax_node_type type,
+                  size_t start_offset, size_t end_offset);
+    void (*token)(void *context, enum ink_syntax_node_type type,
+                  size_t start_offset, size_t end_offset);
 };
 
-extern int ink_parse(struct ink_arena *arena, const struct ink_source *source,
-                     struct ink_syntax_tree *tree, int flags);
+extern INK_API void ink_parse_set_cache_limit(size_t bytes);
+extern INK_API int ink_parse(struct ink_arena *arena,
+                             struct ink_source *source,
+                             struct ink_syntax_tree *tree, int flags);
+extern int ink_parse_with_stats(struct ink_arena *arena,
+                                struct ink_source *source,
+                                struct ink_syntax_tree *tree, int flags,
+                                struct ink_parse_stats *stats);
+
+/**
+ * Parse with the top-level knots of the source split between up to `jobs`
+ * workers, or one for each processor if `jobs` is zero. The syntax tree is
+ * identical to that of a serial parse.
+ */
+extern int ink_parse_parallel(struct ink_arena *arena,
+                              struct ink_source *source,
+                              struct ink_syntax_tree *tree, int flags,
+                              size_t jobs);
+
+/**
+ * Parse a source again after it was edited, reusing `tree` from the parse
+ * of the source as it was before, which must still be loaded. Edits must be
+ * in order of their offsets, and must not overlap.
+ */
+extern INK_API int
+ink_parse_incremental(struct ink_arena *arena, struct ink_source *source,
+                      struct ink_syntax_tree *tree, int flags,
+                      const struct ink_parse_edit *edits, size_t count);
+
+/**
+ * Parse with profiling, writing a table of the time spent in each grammar
+ * rule to `summary`, and the time spent in each path of rules to `stacks`
+ * as collapsed stacks for flamegraph tools. Either may be NULL.
+ */
+extern int ink_parse_profile(struct ink_arena *arena, struct ink_source *source,
+                             struct ink_syntax_tree *tree, int flags,
+                             FILE *summary, FILE *stacks);
+
+/**
+ * Parse with tracing, saving the trace to `trace` in binary form rather than
+ * printing it. Saved traces are printed by `ink_parse_trace_decode`.
+ */
+extern int ink_parse_trace(struct ink_arena *arena, struct ink_source *source,
+                           struct ink_syntax_tree *tree, int flags,
+                           FILE *trace);
+extern int ink_parse_trace_decode(FILE *input, FILE *output);
+
+/**
+ * Parse, reporting the syntax tree to `sink` rather than keeping it, or only
+ * checking the source if `sink` is NULL. Each top-level statement is
+ * reported once it is parsed, after which its memory in `arena` is reused,
+ * so the memory taken is that of the largest statement rather than that of
+ * the whole tree. Fails if the source has any syntax errors.
+ */
+extern INK_API int ink_parse_events(struct ink_arena *arena,
+                                    struct ink_source *source, int flags,
+                                    const struct ink_parse_sink *sink);
+
+/**
+ * Parse session, keeping the memory of one parse warm for the next, so that
+ * parsing many sources in turn does not set up and tear down a parser and
+ * an arena for each. Each parse gives back the memory of the syntax tree
+ * from the one before, so a tree is only valid until the session parses
+ * another source or is freed. A session must only be used by one thread at
+ * a time.
+ */
+struct ink_parse_session;
+
+extern INK_API struct ink_parse_session *ink_parse_session_new(void);
+extern INK_API void ink_parse_session_free(struct ink_parse_session *session);
+extern INK_API int
+ink_parse_session_parse(struct ink_parse_session *session,
+                        struct ink_source *source, struct ink_syntax_tree *tree,
+                        int flags);
+extern INK_API int
+ink_parse_session_events(struct ink_parse_session *session,
+                         struct ink_source *source, int flags,
+                         const struct ink_parse_sink *sink);
 
 #ifdef __cplusplus
 }
@@ -1,5 +1,6 @@
 #include <stddef.h>
 
+#include "platform.h"
 #include "unix.h"
 
 /* TODO(Brett): Add a Win32 abstraction. */
@@ -13,6 +14,43 @@ int platform_load_file(const char *filename, unsigned char **bytes,
     return unix_load_file(filename, bytes, length);
 }
 
+/**
+ * Request the platform to load the contents of STDIN into a buffer of bytes.
+ *
+ * Returns -1 on a read error, or -2 if memory could not be allocated.
+ */
+int platform_load_stdin(unsigned char **bytes, size_t *length)
+{
+    return unix_load_stdin(bytes, length);
+}
+
+/**
+ * Request the platform to read the next available bytes from STDIN.
+ */
+int platform_read_stdin(unsigned char *bytes, size_t size, size_t *nread)
+{
+    return unix_read_stdin(bytes, size, nread);
+}
+
+/**
+ * Request the platform to map a file into memory.
+ *
+ * The mapping is read-only and is followed by a NUL byte.
+ */
+int platform_map_file(const char *filename, unsigned char **bytes,
+                      size_t *length)
+{
+    return unix_map_file(filename, bytes, length);
+}
+
+/**
+ * Release a file mapping created by `platform_map_file`.
+ */
+void platform_unmap_file(unsigned char *bytes, size_t length)
+{
+    unix_unmap_file(bytes, length);
+}
+
 /**
  * Request the platform to allocate memory.
  */
@@ -36,3 +74,30 @@ void platform_mem_dealloc(void *address, size_t size)
 {
     unix_dealloc(address, size);
 }
+
+/**
+ * Request the time elapsed on a monotonic clock, in nanoseconds.
+ *
+ * Only differences between two readings are meaningful.
+ */
+uint64_t platform_clock_ns(void)
+{
+    return unix_clock_ns();
+}
+
+/**
+ * Request the number of processors available to run tasks on.
+ */
+size_t platform_cpu_count(void)
+{
+    return unix_cpu_count();
+}
+
+/**
+ * Request the platform to run `count` tasks in parallel, calling `task`
+ * with each index from zero to `count - 1`, and to wait for all of them.
+ */
+int platform_run_tasks(platform_task_fn *task, void *context, size_t count)
+{
+    return unix_run_tasks(task, context, count);
+}
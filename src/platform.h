@@ -6,13 +6,26 @@ extern "C" {
 #endif
 
 #include <stddef.h>
+#include <stdint.h>
+
+typedef void platform_task_fn(void *context, size_t index);
 
 extern int platform_load_file(const char *filename, unsigned char **bytes,
                               size_t *length);
+extern int platform_load_stdin(unsigned char **bytes, size_t *length);
+extern int platform_read_stdin(unsigned char *bytes, size_t size,
+                               size_t *nread);
+extern int platform_map_file(const char *filename, unsigned char **bytes,
+                             size_t *length);
+extern void platform_unmap_file(unsigned char *bytes, size_t length);
 extern void *platform_mem_alloc(size_t size);
 extern void *platform_mem_realloc(void *address, size_t old_size,
                                   size_t new_size);
 extern void platform_mem_dealloc(void *pointer, size_t size);
+extern uint64_t platform_clock_ns(void);
+extern size_t platform_cpu_count(void);
+extern int platform_run_tasks(platform_task_fn *task, void *context,
+                              size_t count);
 
 #ifdef __cplusplus
 }
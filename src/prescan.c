@@ -0,0 +1,288 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common.h"
+#include "prescan.h"
+#include "simd.h"
+#include "source.h"
+
+/**
+ * Pre-scanner for the top-level structure of a source.
+ *
+ * Lines that declare something are found without lexing, by jumping from
+ * one structural byte to the next, through masks of the structural bytes
+ * in each block of 64 bytes. Newlines start lines, block and line
+ * comments are skipped whole, and lines within braces or continued by an
+ * escape are passed over, since they cannot declare anything. Nothing else
+ * about the grammar is known here, so a line found in the wrong place, such
+ * as one that a divert carries onto from the line before it, is only caught
+ * once the statements around it are parsed.
+ */
+
+#define T(name, description) description,
+static const char *INK_BOUNDARY_TYPE_STR[] = {INK_BOUNDARY(T)};
+#undef T
+
+/**
+ * Return a NULL-terminated string describing a boundary type.
+ */
+const char *ink_boundary_type_strz(enum ink_boundary_type type)
+{
+    return INK_BOUNDARY_TYPE_STR[type];
+}
+
+/*
+ * Check whether the word at `offset` is `keyword`, returning the offset of
+ * the end of the word.
+ */
+static bool ink_prescan_is_word(const unsigned char *bytes, size_t offset,
+                                size_t length, const char *keyword,
+                                size_t *end)
+{
+    const size_t keyword_length = strlen(keyword);
+
+    *end = ink_simd_span_word(bytes, offset, length);
+    return *end - offset == keyword_length &&
+           memcmp(bytes + offset, keyword, keyword_length) == 0;
+}
+
+/*
+ * Classify the line starting at `offset`, filling in `boundary` if it
+ * declares something of one of `types`.
+ */
+static bool ink_prescan_line(const unsigned char *bytes, size_t offset,
+                             size_t length, unsigned int types,
+                             struct ink_boundary *boundary)
+{
+    enum ink_boundary_type type;
+    size_t start = offset;
+    size_t end;
+    size_t name_end;
+
+    while (start < length && (bytes[start] == ' ' || bytes[start] == '\t')) {
+        start++;
+    }
+    if (start == length) {
+        return false;
+    }
+    switch (bytes[start]) {
+    case '=':
+        end = start;
+        while (end < length && bytes[end] == '=') {
+            end++;
+        }
+        if (end - start == 1) {
+            type = INK_BOUNDARY_STITCH;
+            break;
+        }
+
+        type = INK_BOUNDARY_KNOT;
+        end = ink_simd_span_blank(bytes, end, length);
+        if (ink_prescan_is_word(bytes, end, length, "function", &name_end)) {
+            type = INK_BOUNDARY_FUNCTION;
+            end = name_end;
+        }
+        break;
+    case 'V':
+        if (!ink_prescan_is_word(bytes, start, length, "VAR", &end)) {
+            return false;
+        }
+
+        type = INK_BOUNDARY_VAR;
+        break;
+    case 'C':
+        if (!ink_prescan_is_word(bytes, start, length, "CONST", &end)) {
+            return false;
+        }
+
+        type = INK_BOUNDARY_CONST;
+        break;
+    case 'L':
+        if (!ink_prescan_is_word(bytes, start, length, "LIST", &end)) {
+            return false;
+        }
+
+        type = INK_BOUNDARY_LIST;
+        break;
+    case 'I':
+        if (!ink_prescan_is_word(bytes, start, length, "INCLUDE", &end)) {
+            return false;
+        }
+
+        type = INK_BOUNDARY_INCLUDE;
+        break;
+    default:
+        return false;
+    }
+    if (!(types & INK_BOUNDARY_BIT(type))) {
+        return false;
+    }
+
+    end = ink_simd_span_blank(bytes, end, length);
+    if (type == INK_BOUNDARY_INCLUDE) {
+        name_end = ink_simd_find_either(bytes, end, length, '\n', '\n');
+        while (name_end > end &&
+               (bytes[name_end - 1] == ' ' || bytes[name_end - 1] == '\t' ||
+                bytes[name_end - 1] == '\r')) {
+            name_end--;
+        }
+    } else {
+        name_end = ink_simd_span_word(bytes, end, length);
+    }
+
+    boundary->offset = (ink_offset_t)offset;
+    boundary->name_offset = (ink_offset_t)end;
+    boundary->name_length = (ink_offset_t)(name_end - end);
+    boundary->type = (unsigned char)type;
+    return true;
+}
+
+/**
+ * Block of 64 bytes, and a mask of the structural bytes within it.
+ */
+struct ink_prescan_block {
+    size_t offset;
+    uint64_t mask;
+};
+
+/*
+ * Return the offset of the first structural byte at or after `offset`, or
+ * `length` if there is none.
+ */
+static inline size_t ink_prescan_find(const unsigned char *bytes,
+                                      size_t offset, size_t length,
+                                      struct ink_prescan_block *block)
+{
+    while (offset < length) {
+        if (offset >= block->offset && offset - block->offset < 64) {
+            const uint64_t mask =
+                block->mask & (~(uint64_t)0 << (offset - block->offset));
+
+            if (mask != 0) {
+                return block->offset + (size_t)__builtin_ctzll(mask);
+            }
+
+            offset = block->offset + 64;
+            continue;
+        }
+
+        block->offset = offset;
+        block->mask = ink_simd_structural_mask(bytes, offset, length);
+    }
+    return length;
+}
+
+/*
+ * Return the offset just past the end of the block comment whose body
+ * starts at `offset`, or `length` if it is never closed.
+ */
+static size_t ink_prescan_skip_comment(const unsigned char *bytes,
+                                       size_t offset, size_t length)
+{
+    for (;;) {
+        offset = ink_simd_find_either(bytes, offset, length, '*', '*');
+        if (offset + 1 >= length) {
+            return length;
+        }
+        if (bytes[offset + 1] == '/') {
+            return offset + 2;
+        }
+
+        offset++;
+    }
+}
+
+/**
+ * Find the first line at or after `offset` that declares something of one
+ * of `types`, filling in `boundary` for it. Returns the start of the line,
+ * or `length` if there is none.
+ *
+ * `offset` must be at the top level of the source, outside of any block
+ * comment or braces. To carry on from a boundary, scan again from its
+ * `name_offset`.
+ */
+size_t ink_prescan_next(const unsigned char *bytes, size_t offset,
+                        size_t length, unsigned int types,
+                        struct ink_boundary *boundary)
+{
+    struct ink_prescan_block block = {SIZE_MAX, 0};
+    size_t depth = 0;
+    size_t start = offset;
+    bool is_line_start;
+
+    while (start > 0 && (bytes[start - 1] == ' ' || bytes[start - 1] == '\t')) {
+        start--;
+    }
+
+    is_line_start = start == 0 || bytes[start - 1] == '\n';
+
+    while (offset < length) {
+        if (is_line_start && depth == 0 &&
+            ink_prescan_line(bytes, offset, length, types, boundary)) {
+            return offset;
+        }
+
+        is_line_start = false;
+        offset = ink_prescan_find(bytes, offset, length, &block);
+        if (offset == length) {
+            break;
+        }
+        switch (bytes[offset]) {
+        case '\n':
+            is_line_start = true;
+            break;
+        case '\\':
+            offset++;
+            break;
+        case '{':
+            depth++;
+            break;
+        case '}':
+            if (depth > 0) {
+                depth--;
+            }
+            break;
+        case '/':
+            if (offset + 1 < length && bytes[offset + 1] == '*') {
+                offset = ink_prescan_skip_comment(bytes, offset + 2, length);
+                continue;
+            }
+            if (offset + 1 < length && bytes[offset + 1] == '/') {
+                offset = ink_simd_find_either(bytes, offset, length, '\n',
+                                              '\n');
+                continue;
+            }
+            break;
+        default:
+            break;
+        }
+
+        offset++;
+    }
+    return length;
+}
+
+/**
+ * Find every line of a source that declares something, appending them to
+ * `table` in order.
+ */
+void ink_prescan(const struct ink_source *source,
+                 struct ink_boundary_table *table)
+{
+    const size_t length = source->length;
+    struct ink_boundary boundary;
+    size_t offset = 0;
+
+    for (;;) {
+        offset = ink_prescan_next(source->bytes, offset, length,
+                                  INK_BOUNDARY_ALL, &boundary);
+        if (offset == length) {
+            break;
+        }
+
+        ink_boundary_table_append(table, boundary);
+        offset = boundary.name_offset;
+    }
+}
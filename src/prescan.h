@@ -0,0 +1,83 @@
+#ifndef __INK_PRESCAN_H__
+#define __INK_PRESCAN_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common.h"
+#include "source.h"
+#include "vec.h"
+
+#define INK_BOUNDARY(T)                                                        \
+    T(BOUNDARY_KNOT, "Knot")                                                   \
+    T(BOUNDARY_STITCH, "Stitch")                                               \
+    T(BOUNDARY_FUNCTION, "Function")                                           \
+    T(BOUNDARY_INCLUDE, "Include")                                             \
+    T(BOUNDARY_VAR, "Var")                                                     \
+    T(BOUNDARY_CONST, "Const")                                                 \
+    T(BOUNDARY_LIST, "List")
+
+#define T(name, description) INK_##name,
+enum ink_boundary_type {
+    INK_BOUNDARY(T)
+};
+#undef T
+
+/**
+ * Bit for a boundary type, for sets of types.
+ */
+#define INK_BOUNDARY_BIT(type) (1u << (type))
+
+/**
+ * Boundary types that start a new container: knots, stitches and functions.
+ */
+#define INK_BOUNDARY_DECLS                                                     \
+    (INK_BOUNDARY_BIT(INK_BOUNDARY_KNOT) |                                     \
+     INK_BOUNDARY_BIT(INK_BOUNDARY_STITCH) |                                   \
+     INK_BOUNDARY_BIT(INK_BOUNDARY_FUNCTION))
+
+/**
+ * Boundary types that declare a global variable, constant or list.
+ */
+#define INK_BOUNDARY_GLOBALS                                                   \
+    (INK_BOUNDARY_BIT(INK_BOUNDARY_VAR) |                                      \
+     INK_BOUNDARY_BIT(INK_BOUNDARY_CONST) |                                    \
+     INK_BOUNDARY_BIT(INK_BOUNDARY_LIST))
+
+#define INK_BOUNDARY_ALL                                                       \
+    (INK_BOUNDARY_DECLS | INK_BOUNDARY_GLOBALS |                               \
+     INK_BOUNDARY_BIT(INK_BOUNDARY_INCLUDE))
+
+/**
+ * Line of a source that declares something at the top level.
+ *
+ * `offset` is the start of the line, before any indentation. The name is
+ * the word that follows the keyword, or for an INCLUDE, the rest of the
+ * line, and is empty if there is none. `name_offset` is where the name
+ * would start even so, which is always past the keyword.
+ */
+struct ink_boundary {
+    ink_offset_t offset;
+    ink_offset_t name_offset;
+    ink_offset_t name_length;
+    unsigned char type;
+};
+
+INK_VEC_DECLARE(ink_boundary_table, struct ink_boundary)
+
+extern const char *ink_boundary_type_strz(enum ink_boundary_type type);
+extern size_t ink_prescan_next(const unsigned char *bytes, size_t offset,
+                               size_t length, unsigned int types,
+                               struct ink_boundary *boundary);
+extern void ink_prescan(const struct ink_source *source,
+                        struct ink_boundary_table *table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,7 +2,10 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include "common.h"
+#include "platform.h"
 #include "scanner.h"
+#include "simd.h"
 #include "source.h"
 #include "token.h"
 
@@ -19,6 +22,7 @@ enum ink_lex_state {
     INK_LEX_NUMBER,
     INK_LEX_NUMBER_DOT,
     INK_LEX_NUMBER_DECIMAL,
+    INK_LEX_NON_ASCII,
     INK_LEX_WHITESPACE,
     INK_LEX_COMMENT_LINE,
     INK_LEX_COMMENT_BLOCK,
@@ -51,6 +55,38 @@ static inline bool ink_is_identifier(unsigned char c)
     return ink_is_alpha(c) || ink_is_digit(c) || c == '_';
 }
 
+/*
+ * The scanner validates bytes as UTF-8 before it reaches them, and stops at
+ * a malformed sequence, so every byte with the high bit set that it scans
+ * belongs to a well-formed multi-byte character. Words of content can take
+ * such bytes in without decoding them.
+ */
+static inline bool ink_is_word(unsigned char c)
+{
+    return ink_is_identifier(c) || c >= 0x80;
+}
+
+/**
+ * Ready a scanner to lex a source in content mode from `offset`, which must
+ * not fall within a multi-byte character.
+ */
+void ink_scanner_initialize(struct ink_scanner *scanner,
+                            const struct ink_source *source, size_t offset,
+                            bool is_line_start)
+{
+    scanner->source = source;
+    scanner->stream = NULL;
+    scanner->is_line_start = is_line_start;
+    scanner->is_ascii = true;
+    scanner->is_malformed = false;
+    scanner->cursor_offset = offset;
+    scanner->start_offset = offset;
+    scanner->utf8_offset = offset;
+    scanner->mode_depth = 0;
+    scanner->mode_stack[0].type = INK_GRAMMAR_CONTENT;
+    scanner->mode_stack[0].source_offset = offset;
+}
+
 struct ink_scanner_mode *ink_scanner_current(struct ink_scanner *scanner)
 {
     return &scanner->mode_stack[scanner->mode_depth];
@@ -87,95 +123,135 @@ void ink_scanner_rewind(struct ink_scanner *scanner, size_t source_offset)
     scanner->cursor_offset = source_offset;
 }
 
+/*
+ * Reserved words, along with the token types they are recognized as and
+ * their first two bytes, which are needed to place them in
+ * INK_KEYWORD_TABLE at compile time.
+ */
+#define INK_KEYWORD(T)                                                         \
+    T(TT_KEYWORD_AND, "and", 'a', 'n')                                         \
+    T(TT_KEYWORD_CONST, "CONST", 'C', 'O')                                     \
+    T(TT_KEYWORD_FALSE, "false", 'f', 'a')                                     \
+    T(TT_KEYWORD_FUNCTION, "function", 'f', 'u')                               \
+    T(TT_KEYWORD_LIST, "LIST", 'L', 'I')                                       \
+    T(TT_KEYWORD_MOD, "mod", 'm', 'o')                                         \
+    T(TT_KEYWORD_NOT, "not", 'n', 'o')                                         \
+    T(TT_KEYWORD_OR, "or", 'o', 'r')                                           \
+    T(TT_KEYWORD_REF, "ref", 'r', 'e')                                         \
+    T(TT_KEYWORD_RETURN, "return", 'r', 'e')                                   \
+    T(TT_KEYWORD_TEMP, "temp", 't', 'e')                                       \
+    T(TT_KEYWORD_TRUE, "true", 't', 'r')                                       \
+    T(TT_KEYWORD_VAR, "VAR", 'V', 'A')
+
+#define INK_KEYWORD_LENGTH_MIN 2
+#define INK_KEYWORD_LENGTH_MAX 8
+#define INK_KEYWORD_SLOTS 32
+
+/*
+ * Perfect hash over the reserved words. Two words hashing to the same slot
+ * would initialize the same element of INK_KEYWORD_TABLE twice, which the
+ * compiler reports through -Woverride-init.
+ */
+#define INK_KEYWORD_HASH(c0, c1, length)                                       \
+    ((((unsigned int)(c0) << 4) ^ ((unsigned int)(c1) << 2) ^                  \
+      (unsigned int)(length)) &                                                \
+     (INK_KEYWORD_SLOTS - 1))
+
+struct ink_keyword {
+    const char *lexeme;
+    size_t length;
+    enum ink_token_type type;
+};
+
+#define T(name, lexeme, c0, c1)                                                \
+    [INK_KEYWORD_HASH(c0, c1, sizeof(lexeme) - 1)] = {                         \
+        lexeme,                                                                \
+        sizeof(lexeme) - 1,                                                    \
+        INK_##name,                                                            \
+    },
+static const struct ink_keyword INK_KEYWORD_TABLE[INK_KEYWORD_SLOTS] = {
+    INK_KEYWORD(T)
+};
+#undef T
+
 /**
  * Return a token type representing a keyword that the specified token
  * represents. If the token's type does not correspond to a keyword,
  * the token's type will be returned instead.
- *
- * TODO(Brett): Perhaps we could add an early return to ignore any
- * UTF-8 encoded byte sequence, as no reserved words contain such things.
  */
-static enum ink_token_type ink_scanner_keyword(struct ink_scanner *scanner,
-                                               const struct ink_token *token)
+enum ink_token_type ink_scanner_keyword(struct ink_scanner *scanner,
+                                        const struct ink_token *token)
 {
     const unsigned char *source = scanner->source->bytes;
     const unsigned char *lexeme = source + token->start_offset;
     const size_t length = token->end_offset - token->start_offset;
-    enum ink_token_type type = token->type;
+    const struct ink_keyword *keyword;
 
-    switch (length) {
-    case 2: {
-        if (memcmp(lexeme, "or", length) == 0) {
-            type = INK_TT_KEYWORD_OR;
-        }
-        break;
-    }
-    case 3: {
-        if (memcmp(lexeme, "and", length) == 0) {
-            type = INK_TT_KEYWORD_AND;
-        } else if (memcmp(lexeme, "mod", length) == 0) {
-            type = INK_TT_KEYWORD_MOD;
-        } else if (memcmp(lexeme, "not", length) == 0) {
-            type = INK_TT_KEYWORD_NOT;
-        } else if (memcmp(lexeme, "ref", length) == 0) {
-            type = INK_TT_KEYWORD_REF;
-        } else if (memcmp(lexeme, "VAR", length) == 0) {
-            type = INK_TT_KEYWORD_VAR;
-        }
-        break;
-    }
-    case 4: {
-        if (memcmp(lexeme, "temp", length) == 0) {
-            type = INK_TT_KEYWORD_TEMP;
-        } else if (memcmp(lexeme, "true", length) == 0) {
-            type = INK_TT_KEYWORD_TRUE;
-        } else if (memcmp(lexeme, "LIST", length) == 0) {
-            type = INK_TT_KEYWORD_LIST;
-        }
-        break;
-    }
-    case 5: {
-        if (memcmp(lexeme, "false", length) == 0) {
-            type = INK_TT_KEYWORD_FALSE;
-        } else if (memcmp(lexeme, "CONST", length) == 0) {
-            type = INK_TT_KEYWORD_CONST;
-        }
-        break;
+    if (length < INK_KEYWORD_LENGTH_MIN || length > INK_KEYWORD_LENGTH_MAX) {
+        return token->type;
     }
-    case 6: {
-        if (memcmp(lexeme, "return", length) == 0) {
-            type = INK_TT_KEYWORD_RETURN;
-        }
-        break;
+
+    keyword = &INK_KEYWORD_TABLE[INK_KEYWORD_HASH(lexeme[0], lexeme[1],
+                                                  length)];
+    if (keyword->length != length) {
+        return token->type;
     }
-    case 8: {
-        if (memcmp(lexeme, "function", length) == 0) {
-            type = INK_TT_KEYWORD_FUNCTION;
+    for (size_t i = 0; i < length; i++) {
+        if (lexeme[i] != (unsigned char)keyword->lexeme[i]) {
+            return token->type;
         }
-        break;
-    }
-    default:
-        break;
     }
-    return type;
+    return keyword->type;
 }
 
-/**
- * Try to recognize the current token as a keyword.
+/*
+ * Validate the bytes of the source up to and past the cursor, from the end
+ * of those validated so far, receiving more of a streaming source once
+ * every byte received has been validated.
  *
- * If true, the specified token will have its type modified.
+ * Validation covers at least INK_SCANNER_UTF8_REGION bytes past the cursor
+ * at a time, stopping short of a multi-byte character that the region would
+ * cut in two. Returns false once the cursor has reached the end of the
+ * source or a malformed sequence.
  */
-bool ink_scanner_try_keyword(struct ink_scanner *scanner,
-                             struct ink_token *token, enum ink_token_type type)
+static bool ink_scanner_validate(struct ink_scanner *scanner)
 {
-    const enum ink_token_type keyword_type =
-        ink_scanner_keyword(scanner, token);
+    const struct ink_source *source = scanner->source;
+
+    while (scanner->cursor_offset >= scanner->utf8_offset) {
+        const unsigned char *bytes = source->bytes;
+        const size_t length = source->length;
+        size_t offset = scanner->utf8_offset;
+        size_t end = length;
+
+        if (scanner->is_malformed) {
+            return false;
+        }
+        if (length - scanner->cursor_offset > INK_SCANNER_UTF8_REGION) {
+            end = ink_simd_utf8_boundary(
+                bytes, offset, scanner->cursor_offset + INK_SCANNER_UTF8_REGION);
+        } else if (source->is_streaming) {
+            end = ink_simd_utf8_boundary(bytes, offset, length);
+        }
+        if (end == offset) {
+            /* A stream that ends in the middle of a character is malformed. */
+            if (scanner->stream == NULL ||
+                (ink_source_fill(scanner->stream) <= 0 &&
+                 scanner->utf8_offset == source->length)) {
+                return false;
+            }
+            continue;
+        }
+        if (scanner->is_ascii) {
+            offset = ink_simd_span_ascii(bytes, offset, end);
+            scanner->is_ascii = offset == end;
+        }
 
-    if (keyword_type == type) {
-        token->type = type;
-        return true;
+        offset = ink_simd_validate_utf8(bytes, offset, end);
+        scanner->utf8_offset = offset;
+        scanner->is_malformed = offset != end;
     }
-    return false;
+    return true;
 }
 
 void ink_scanner_next(struct ink_scanner *scanner, struct ink_token *token)
@@ -186,12 +262,13 @@ void ink_scanner_next(struct ink_scanner *scanner, struct ink_token *token)
     const struct ink_scanner_mode *mode = ink_scanner_current(scanner);
 
     for (;;) {
-        c = source->bytes[scanner->cursor_offset];
-
-        if (scanner->cursor_offset >= source->length) {
+        if (scanner->cursor_offset >= scanner->utf8_offset &&
+            !ink_scanner_validate(scanner)) {
             token->type = INK_TT_EOF;
             break;
         }
+
+        c = source->bytes[scanner->cursor_offset];
         switch (state) {
         case INK_LEX_START: {
             scanner->start_offset = scanner->cursor_offset;
@@ -315,6 +392,8 @@ void ink_scanner_next(struct ink_scanner *scanner, struct ink_token *token)
                         state = INK_LEX_IDENTIFIER;
                     } else if (ink_is_digit(c)) {
                         state = INK_LEX_NUMBER;
+                    } else if (c >= 0x80) {
+                        state = INK_LEX_NON_ASCII;
                     } else {
                         token->type = INK_TT_ERROR;
                         scanner->cursor_offset++;
@@ -403,11 +482,18 @@ void ink_scanner_next(struct ink_scanner *scanner, struct ink_token *token)
             goto exit_loop;
         }
         case INK_LEX_WORD: {
-            if (!ink_is_identifier(c)) {
+            if (!ink_is_word(c)) {
                 token->type = INK_TT_STRING;
                 goto exit_loop;
             }
-            break;
+            if (scanner->is_ascii) {
+                scanner->cursor_offset = ink_simd_span_identifier(
+                    source->bytes, scanner->cursor_offset, source->length);
+            } else {
+                scanner->cursor_offset = ink_simd_span_word(
+                    source->bytes, scanner->cursor_offset, source->length);
+            }
+            continue;
         }
         case INK_LEX_NUMBER: {
             if (c == '.') {
@@ -445,11 +531,20 @@ void ink_scanner_next(struct ink_scanner *scanner, struct ink_token *token)
             }
             break;
         }
+        case INK_LEX_NON_ASCII: {
+            if (c < 0x80) {
+                token->type = INK_TT_ERROR;
+                goto exit_loop;
+            }
+            break;
+        }
         case INK_LEX_WHITESPACE: {
             switch (c) {
             case ' ':
             case '\t':
-                break;
+                scanner->cursor_offset = ink_simd_span_blank(
+                    source->bytes, scanner->cursor_offset, source->length);
+                continue;
             default:
                 if (scanner->is_line_start ||
                     mode->type == INK_GRAMMAR_EXPRESSION) {
@@ -474,7 +569,10 @@ void ink_scanner_next(struct ink_scanner *scanner, struct ink_token *token)
                 break;
             }
             default:
-                break;
+                scanner->cursor_offset =
+                    ink_simd_find_either(source->bytes, scanner->cursor_offset,
+                                         source->length, '\n', '\0');
+                continue;
             }
             break;
         }
@@ -487,7 +585,10 @@ void ink_scanner_next(struct ink_scanner *scanner, struct ink_token *token)
                 state = INK_LEX_COMMENT_BLOCK_STAR;
                 break;
             default:
-                break;
+                scanner->cursor_offset =
+                    ink_simd_find_either(source->bytes, scanner->cursor_offset,
+                                         source->length, '*', '\0');
+                continue;
             }
             break;
         }
@@ -530,6 +631,616 @@ exit_loop:
         scanner->is_line_start = false;
     }
 
-    token->start_offset = scanner->start_offset;
-    token->end_offset = scanner->cursor_offset;
+    token->keyword = INK_TT_EOF;
+    token->start_offset = (ink_offset_t)scanner->start_offset;
+    token->end_offset = (ink_offset_t)scanner->cursor_offset;
+}
+
+/**
+ * Look ahead at up to `count` tokens from the scanner's cursor, lexed in the
+ * grammar mode `type`, without moving the scanner.
+ *
+ * Returns the number of tokens stored in `tokens`, which is only less than
+ * `count` when the last of them is the end of the file.
+ */
+size_t ink_scanner_peek(struct ink_scanner *scanner,
+                        enum ink_grammar_type type, struct ink_token *tokens,
+                        size_t count)
+{
+    const bool is_line_start = scanner->is_line_start;
+    const size_t start_offset = scanner->start_offset;
+    const size_t cursor_offset = scanner->cursor_offset;
+    size_t i = 0;
+
+    ink_scanner_push(scanner, type, cursor_offset);
+
+    while (i < count) {
+        ink_scanner_next(scanner, &tokens[i]);
+        if (tokens[i++].type == INK_TT_EOF) {
+            break;
+        }
+    }
+
+    ink_scanner_pop(scanner);
+    scanner->is_line_start = is_line_start;
+    scanner->start_offset = start_offset;
+    scanner->cursor_offset = cursor_offset;
+    return i;
+}
+
+/**
+ * Move the cursor past the source bytes that come before the next token the
+ * parser could synchronize on after an error, without lexing them.
+ *
+ * Only a newline, a closing brace or parenthesis, or the end of the source
+ * begins such a token, and no token spans one of them but a comment. The
+ * cursor is left on the first of those bytes, or on a slash, so that any
+ * comment is still lexed in full. At the start of a line, leading
+ * whitespace decides whether a newline is a token of its own, so the
+ * cursor is left untouched.
+ *
+ * The cursor is also left untouched if none of those bytes has been
+ * received yet. The end of the source is only reached by lexing up to it,
+ * as its token starts where the last token lexed before it starts.
+ *
+ * The cursor must be at the end of a token.
+ */
+void ink_scanner_skip(struct ink_scanner *scanner)
+{
+    const struct ink_source *source = scanner->source;
+    size_t offset;
+
+    if (!scanner->is_line_start) {
+        offset = ink_simd_find_sync(source->bytes, scanner->cursor_offset,
+                                    source->length);
+        if (offset < source->length) {
+            scanner->cursor_offset = offset;
+        }
+    }
+}
+
+#define INK_TOKEN_LANE_MIN_CAPACITY 64
+#define INK_TOKEN_LANE_GROWTH_FACTOR 2
+
+static void ink_token_lane_initialize(struct ink_token_lane *lane)
+{
+    lane->count = 0;
+    lane->capacity = 0;
+    lane->position = 0;
+    lane->offsets = NULL;
+    lane->types = NULL;
+    lane->starts = NULL;
+    lane->lengths = NULL;
+}
+
+static void ink_token_lane_cleanup(struct ink_token_lane *lane)
+{
+    const size_t capacity = lane->capacity;
+
+    if (capacity > 0) {
+        platform_mem_dealloc(lane->offsets, capacity * sizeof(*lane->offsets));
+        platform_mem_dealloc(lane->types, capacity * sizeof(*lane->types));
+        platform_mem_dealloc(lane->starts, capacity * sizeof(*lane->starts));
+        platform_mem_dealloc(lane->lengths, capacity * sizeof(*lane->lengths));
+    }
+
+    ink_token_lane_initialize(lane);
+}
+
+static int ink_token_lane_reserve(struct ink_token_lane *lane,
+                                  size_t new_capacity)
+{
+    ink_offset_t *offsets, *starts, *lengths;
+    unsigned char *types;
+    const size_t old_capacity = lane->capacity;
+
+    if (new_capacity <= old_capacity) {
+        return INK_E_OK;
+    }
+
+    offsets = platform_mem_realloc(lane->offsets,
+                                   old_capacity * sizeof(*offsets),
+                                   new_capacity * sizeof(*offsets));
+    if (offsets == NULL) {
+        return -INK_E_OOM;
+    }
+
+    lane->offsets = offsets;
+
+    types = platform_mem_realloc(lane->types, old_capacity * sizeof(*types),
+                                 new_capacity * sizeof(*types));
+    if (types == NULL) {
+        return -INK_E_OOM;
+    }
+
+    lane->types = types;
+
+    starts = platform_mem_realloc(lane->starts, old_capacity * sizeof(*starts),
+                                  new_capacity * sizeof(*starts));
+    if (starts == NULL) {
+        return -INK_E_OOM;
+    }
+
+    lane->starts = starts;
+
+    lengths = platform_mem_realloc(lane->lengths,
+                                   old_capacity * sizeof(*lengths),
+                                   new_capacity * sizeof(*lengths));
+    if (lengths == NULL) {
+        return -INK_E_OOM;
+    }
+
+    lane->lengths = lengths;
+    lane->capacity = new_capacity;
+    return INK_E_OK;
+}
+
+static int ink_token_lane_grow(struct ink_token_lane *lane)
+{
+    const size_t capacity = lane->capacity;
+
+    return ink_token_lane_reserve(lane,
+                                  capacity < INK_TOKEN_LANE_MIN_CAPACITY
+                                      ? INK_TOKEN_LANE_MIN_CAPACITY
+                                      : capacity * INK_TOKEN_LANE_GROWTH_FACTOR);
+}
+
+static inline int ink_token_lane_append(struct ink_token_lane *lane,
+                                        size_t offset,
+                                        const struct ink_token *token)
+{
+    const size_t i = lane->count;
+
+    if (i == lane->capacity) {
+        const int rc = ink_token_lane_grow(lane);
+
+        if (rc < 0) {
+            return rc;
+        }
+    }
+
+    lane->offsets[i] = (ink_offset_t)offset;
+    lane->types[i] = token->type;
+    lane->starts[i] = token->start_offset;
+    lane->lengths[i] = token->end_offset - token->start_offset;
+    lane->count++;
+    return INK_E_OK;
+}
+
+/*
+ * Copy the tokens at indices `first` up to `last` of one lane onto the end
+ * of another, which must have room for them.
+ */
+static void ink_token_lane_copy(struct ink_token_lane *lane,
+                                const struct ink_token_lane *from,
+                                size_t first, size_t last)
+{
+    const size_t i = lane->count;
+    const size_t n = last - first;
+
+    assert(i + n <= lane->capacity);
+
+    if (n > 0) {
+        memcpy(&lane->offsets[i], &from->offsets[first],
+               n * sizeof(*lane->offsets));
+        memcpy(&lane->types[i], &from->types[first], n * sizeof(*lane->types));
+        memcpy(&lane->starts[i], &from->starts[first],
+               n * sizeof(*lane->starts));
+        memcpy(&lane->lengths[i], &from->lengths[first],
+               n * sizeof(*lane->lengths));
+    }
+
+    lane->count += n;
+}
+
+/**
+ * Find the index of the first token lexed at or after `offset`.
+ */
+static size_t ink_token_lane_search(const struct ink_token_lane *lane,
+                                    size_t offset)
+{
+    size_t low = 0;
+    size_t high = lane->count;
+
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+
+        if (lane->offsets[middle] < offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+void ink_token_buffer_initialize(struct ink_token_buffer *buffer)
+{
+    for (size_t i = 0; i < INK_GRAMMAR_EXPRESSION + 1; i++) {
+        ink_token_lane_initialize(&buffer->lanes[i]);
+    }
+}
+
+void ink_token_buffer_cleanup(struct ink_token_buffer *buffer)
+{
+    for (size_t i = 0; i < INK_GRAMMAR_EXPRESSION + 1; i++) {
+        ink_token_lane_cleanup(&buffer->lanes[i]);
+    }
+}
+
+/**
+ * Discard all buffered tokens, keeping the memory for reuse.
+ */
+void ink_token_buffer_reset(struct ink_token_buffer *buffer)
+{
+    for (size_t i = 0; i < INK_GRAMMAR_EXPRESSION + 1; i++) {
+        buffer->lanes[i].count = 0;
+        buffer->lanes[i].position = 0;
+    }
+}
+
+/**
+ * Replay a token lexed earlier from the scanner's cursor, in the scanner's
+ * current grammar mode.
+ *
+ * Returns false if no such token has been recorded, leaving the scanner
+ * untouched. The lane is then positioned where that token would be
+ * recorded.
+ */
+bool ink_token_buffer_replay(struct ink_token_buffer *buffer,
+                             struct ink_scanner *scanner,
+                             struct ink_token *token)
+{
+    const struct ink_scanner_mode *mode = ink_scanner_current(scanner);
+    struct ink_token_lane *lane = &buffer->lanes[mode->type];
+    const size_t offset = scanner->cursor_offset;
+    size_t i = lane->position;
+
+    if (i >= lane->count || lane->offsets[i] != offset) {
+        if (lane->count == 0 || lane->offsets[lane->count - 1] < offset) {
+            lane->position = lane->count;
+            return false;
+        }
+
+        i = ink_token_lane_search(lane, offset);
+        if (i >= lane->count || lane->offsets[i] != offset) {
+            lane->position = i;
+            return false;
+        }
+    }
+
+    token->type = lane->types[i];
+    token->keyword = INK_TT_EOF;
+    token->start_offset = lane->starts[i];
+    token->end_offset = lane->starts[i] + lane->lengths[i];
+    scanner->is_line_start = false;
+    scanner->start_offset = token->start_offset;
+    scanner->cursor_offset = token->end_offset;
+    lane->position = i + 1;
+    return true;
+}
+
+/**
+ * Record a token lexed from `offset` in the specified grammar mode.
+ *
+ * Must follow a failed call to `ink_token_buffer_replay` for the same
+ * offset and mode, which positioned the lane for insertion.
+ */
+int ink_token_buffer_record(struct ink_token_buffer *buffer,
+                            enum ink_grammar_type type, size_t offset,
+                            const struct ink_token *token)
+{
+    int rc;
+    struct ink_token_lane *lane = &buffer->lanes[type];
+    const size_t i = lane->position;
+    const size_t tail = lane->count - i;
+
+    assert(i <= lane->count);
+    assert(i == lane->count || lane->offsets[i] > offset);
+
+    if (lane->count == lane->capacity) {
+        rc = ink_token_lane_grow(lane);
+        if (rc < 0) {
+            return rc;
+        }
+    }
+    if (tail > 0) {
+        memmove(&lane->offsets[i + 1], &lane->offsets[i],
+                tail * sizeof(*lane->offsets));
+        memmove(&lane->types[i + 1], &lane->types[i],
+                tail * sizeof(*lane->types));
+        memmove(&lane->starts[i + 1], &lane->starts[i],
+                tail * sizeof(*lane->starts));
+        memmove(&lane->lengths[i + 1], &lane->lengths[i],
+                tail * sizeof(*lane->lengths));
+    }
+
+    lane->offsets[i] = (ink_offset_t)offset;
+    lane->types[i] = token->type;
+    lane->starts[i] = token->start_offset;
+    lane->lengths[i] = token->end_offset - token->start_offset;
+    lane->count++;
+    lane->position = i + 1;
+    return INK_E_OK;
+}
+
+/*
+ * Chunks are never made smaller than this, so that small sources are not
+ * spread across more threads than they can keep busy.
+ */
+#define INK_PRELEX_CHUNK_MIN (256 * 1024)
+
+/*
+ * Typical stories average a little over two bytes per token, counting
+ * whitespace. Reserving room for this many tokens per byte up front saves
+ * workers from regrowing their lanes as they go.
+ */
+#define INK_PRELEX_TOKEN_RATIO 2
+
+/**
+ * Part of a source pre-lexed by one worker.
+ *
+ * A worker lexes tokens in content mode from `start_offset` for as long
+ * as lexing starts before `end_offset`, so a token may run past the end of
+ * its chunk, and the worker's cursor is left at `cursor_offset`. Tokens
+ * relexed to repair the start of the chunk are kept in `repairs`, and
+ * `sync` is the index of the first of the worker's tokens that lexing the
+ * source from the start would also produce.
+ */
+struct ink_prelex_chunk {
+    const struct ink_source *source;
+    size_t start_offset;
+    size_t end_offset;
+    size_t cursor_offset;
+    size_t sync;
+    bool is_eof;
+    int rc;
+    struct ink_token_lane tokens;
+    struct ink_token_lane repairs;
+};
+
+/*
+ * Lex one chunk of a source, on a worker thread.
+ *
+ * Every chunk but the first starts at the beginning of a line, where
+ * lexing that starts at the beginning of the source usually starts afresh
+ * as well. The first chunk starts at the beginning of the source, whose
+ * first token is skipped, as only that token is lexed at the start of a
+ * line.
+ */
+static void ink_prelex_chunk(void *context, size_t index)
+{
+    struct ink_prelex_chunk *chunk = &((struct ink_prelex_chunk *)context)[index];
+    struct ink_scanner scanner;
+    struct ink_token token;
+
+    ink_scanner_initialize(&scanner, chunk->source, chunk->start_offset,
+                            index == 0);
+
+    chunk->rc = ink_token_lane_reserve(
+        &chunk->tokens, (chunk->end_offset - chunk->start_offset) /
+                                INK_PRELEX_TOKEN_RATIO +
+                            INK_TOKEN_LANE_MIN_CAPACITY);
+    if (chunk->rc < 0) {
+        return;
+    }
+    while (scanner.cursor_offset < chunk->end_offset) {
+        const size_t offset = scanner.cursor_offset;
+        const bool is_line_start = scanner.is_line_start;
+
+        ink_scanner_next(&scanner, &token);
+        if (token.type == INK_TT_EOF) {
+            chunk->is_eof = true;
+            break;
+        }
+        if (!is_line_start) {
+            chunk->rc = ink_token_lane_append(&chunk->tokens, offset, &token);
+            if (chunk->rc < 0) {
+                break;
+            }
+        }
+    }
+    if (scanner.is_malformed) {
+        chunk->rc = -INK_E_FILE_ENCODING;
+    }
+
+    chunk->cursor_offset = scanner.cursor_offset;
+}
+
+/*
+ * Find where lexing from the start of the source picks up within a chunk,
+ * given the offset it has reached, relexing tokens until it lands on one
+ * that the chunk's worker also started from.
+ *
+ * This is needed where a chunk starts inside a block comment, or right
+ * after a line comment, after which leading whitespace is not a token.
+ * Returns the offset reached. `*is_eof` is set if the end of the source is
+ * reached while relexing.
+ */
+static size_t ink_prelex_repair(struct ink_prelex_chunk *chunk, size_t offset,
+                                bool *is_eof)
+{
+    struct ink_scanner scanner;
+    struct ink_token token;
+    const struct ink_token_lane *tokens = &chunk->tokens;
+    size_t i = ink_token_lane_search(tokens, offset);
+
+    ink_scanner_initialize(&scanner, chunk->source, offset, false);
+
+    while (i == tokens->count || tokens->offsets[i] != offset) {
+        if (offset >= chunk->end_offset) {
+            chunk->sync = tokens->count;
+            return offset;
+        }
+
+        ink_scanner_next(&scanner, &token);
+        if (scanner.is_malformed) {
+            chunk->rc = -INK_E_FILE_ENCODING;
+            return offset;
+        }
+        if (token.type == INK_TT_EOF) {
+            chunk->sync = tokens->count;
+            *is_eof = true;
+            return offset;
+        }
+
+        chunk->rc = ink_token_lane_append(&chunk->repairs, offset, &token);
+        if (chunk->rc < 0) {
+            return offset;
+        }
+
+        offset = scanner.cursor_offset;
+        while (i < tokens->count && tokens->offsets[i] < offset) {
+            i++;
+        }
+    }
+
+    chunk->sync = i;
+    *is_eof = chunk->is_eof;
+    return chunk->cursor_offset;
+}
+
+/*
+ * Find the start of the first line that begins at or after `offset`, not
+ * counting blank lines, which the lexer folds into the newline before
+ * them.
+ */
+static size_t ink_prelex_line_start(const struct ink_source *source,
+                                    size_t offset)
+{
+    const unsigned char *bytes = source->bytes;
+    const size_t length = source->length;
+
+    offset = ink_simd_find_either(bytes, offset, length, '\n', '\0');
+    while (offset < length && bytes[offset] == '\n') {
+        offset++;
+    }
+    return offset;
+}
+
+/**
+ * Lex an entire source in content mode ahead of parsing, splitting it into
+ * chunks at line boundaries and lexing up to `jobs` chunks in parallel.
+ *
+ * Tokens are recorded in the buffer's content lane, keyed by the offset
+ * lexing started from, exactly as `ink_token_buffer_record` would have
+ * recorded them. Lexing only ever depends on that offset and the grammar
+ * mode, so a token is replayed wherever the parser reaches its offset in
+ * content mode, including after rewinding. Where the parser switches to
+ * expression mode, it lexes for itself as before.
+ *
+ * Streaming sources are not pre-lexed, as they have not been received yet.
+ * Fails with -INK_E_FILE_ENCODING on a malformed UTF-8 sequence, which the
+ * parser then reaches for itself.
+ */
+int ink_token_buffer_prelex(struct ink_token_buffer *buffer,
+                            const struct ink_source *source, size_t jobs)
+{
+    int rc = INK_E_OK;
+    bool is_eof;
+    size_t count, total, offset;
+    struct ink_prelex_chunk *chunks;
+    struct ink_token_lane *lane = &buffer->lanes[INK_GRAMMAR_CONTENT];
+
+    lane->count = 0;
+    lane->position = 0;
+
+    if (source->is_streaming || source->length == 0) {
+        return INK_E_OK;
+    }
+
+    count = source->length / INK_PRELEX_CHUNK_MIN;
+    if (count > jobs) {
+        count = jobs;
+    }
+    if (count == 0) {
+        count = 1;
+    }
+
+    chunks = platform_mem_alloc(count * sizeof(*chunks));
+    if (chunks == NULL) {
+        return -INK_E_OOM;
+    }
+
+    offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        struct ink_prelex_chunk *chunk = &chunks[i];
+
+        chunk->source = source;
+        chunk->start_offset = offset;
+        chunk->cursor_offset = offset;
+        chunk->sync = 0;
+        chunk->is_eof = false;
+        chunk->rc = INK_E_OK;
+        ink_token_lane_initialize(&chunk->tokens);
+        ink_token_lane_initialize(&chunk->repairs);
+
+        if (i + 1 < count) {
+            offset = source->length / count * (i + 1);
+            if (offset < chunk->start_offset) {
+                offset = chunk->start_offset;
+            }
+
+            offset = ink_prelex_line_start(source, offset);
+        } else {
+            offset = source->length;
+        }
+
+        chunk->end_offset = offset;
+    }
+    if (platform_run_tasks(ink_prelex_chunk, chunks, count) < 0) {
+        rc = -INK_E_OOM;
+        goto cleanup;
+    }
+
+    /* Follow lexing from the start of the source across each boundary. */
+    is_eof = chunks[0].is_eof;
+    offset = chunks[0].cursor_offset;
+    total = chunks[0].tokens.count;
+
+    for (size_t i = 1; i < count; i++) {
+        struct ink_prelex_chunk *chunk = &chunks[i];
+
+        if (is_eof) {
+            chunk->sync = chunk->tokens.count;
+        } else {
+            offset = ink_prelex_repair(chunk, offset, &is_eof);
+        }
+
+        total += chunk->repairs.count + chunk->tokens.count - chunk->sync;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (chunks[i].rc < 0) {
+            rc = chunks[i].rc;
+            goto cleanup;
+        }
+    }
+
+    /* A lone chunk's tokens need no copying. */
+    if (count == 1) {
+        ink_token_lane_cleanup(lane);
+        *lane = chunks[0].tokens;
+        ink_token_lane_initialize(&chunks[0].tokens);
+        goto cleanup;
+    }
+
+    rc = ink_token_lane_reserve(lane, total);
+    if (rc < 0) {
+        goto cleanup;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const struct ink_prelex_chunk *chunk = &chunks[i];
+
+        ink_token_lane_copy(lane, &chunk->repairs, 0, chunk->repairs.count);
+        ink_token_lane_copy(lane, &chunk->tokens, chunk->sync,
+                            chunk->tokens.count);
+    }
+cleanup:
+    for (size_t i = 0; i < count; i++) {
+        ink_token_lane_cleanup(&chunks[i].tokens);
+        ink_token_lane_cleanup(&chunks[i].repairs);
+    }
+
+    platform_mem_dealloc(chunks, count * sizeof(*chunks));
+    return rc;
 }
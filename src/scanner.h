@@ -11,6 +11,7 @@ extern "C" {
 #include "token.h"
 
 #define INK_SCANNER_DEPTH_MAX 128
+#define INK_SCANNER_UTF8_REGION 65536
 
 enum ink_grammar_type {
     INK_GRAMMAR_CONTENT,
@@ -22,18 +23,63 @@ struct ink_scanner_mode {
     size_t source_offset;
 };
 
+/**
+ * Tokens lexed in one grammar mode.
+ *
+ * Tokens are stored as a structure of arrays, ordered by the offset that
+ * lexing started from. `position` is the index of the token expected to be
+ * requested next, so that replaying a run of tokens after a rewind only
+ * needs to locate its first one.
+ */
+struct ink_token_lane {
+    size_t count;
+    size_t capacity;
+    size_t position;
+    ink_offset_t *offsets;
+    unsigned char *types;
+    ink_offset_t *starts;
+    ink_offset_t *lengths;
+};
+
+/**
+ * Previously lexed tokens, keyed by (offset, grammar mode).
+ */
+struct ink_token_buffer {
+    struct ink_token_lane lanes[INK_GRAMMAR_EXPRESSION + 1];
+};
+
+/**
+ * Scanner state.
+ *
+ * The scanner only reads its source. `stream` is the same source while it is
+ * still being received, to which the scanner appends bytes as it needs them,
+ * and NULL otherwise.
+ *
+ * Bytes are validated as UTF-8 as the scanner reaches them, a region at a
+ * time, and `utf8_offset` marks the end of those validated so far. It is
+ * only ever moved forwards, so bytes that were validated once are not
+ * validated again after a rewind. `is_ascii` remains set for as long as
+ * every byte validated is ASCII. At a malformed sequence, `is_malformed` is
+ * set and the scanner stops short, as if the source ended there.
+ */
 struct ink_scanner {
     const struct ink_source *source;
+    struct ink_source *stream;
     bool is_line_start;
+    bool is_ascii;
+    bool is_malformed;
     size_t cursor_offset;
     size_t start_offset;
+    size_t utf8_offset;
     size_t mode_depth;
     struct ink_scanner_mode mode_stack[INK_SCANNER_DEPTH_MAX];
 };
 
-extern bool ink_scanner_try_keyword(struct ink_scanner *scanner,
-                                    struct ink_token *token,
-                                    enum ink_token_type type);
+extern void ink_scanner_initialize(struct ink_scanner *scanner,
+                                   const struct ink_source *source,
+                                   size_t offset, bool is_line_start);
+extern enum ink_token_type
+ink_scanner_keyword(struct ink_scanner *scanner, const struct ink_token *token);
 extern struct ink_scanner_mode *
 ink_scanner_current(struct ink_scanner *scanner);
 extern void ink_scanner_push(struct ink_scanner *scanner,
@@ -43,6 +89,43 @@ extern void ink_scanner_rewind(struct ink_scanner *scanner,
                                size_t source_offset);
 extern void ink_scanner_next(struct ink_scanner *scanner,
                              struct ink_token *token);
+extern size_t ink_scanner_peek(struct ink_scanner *scanner,
+                               enum ink_grammar_type type,
+                               struct ink_token *tokens, size_t count);
+extern void ink_scanner_skip(struct ink_scanner *scanner);
+extern void ink_token_buffer_initialize(struct ink_token_buffer *buffer);
+extern void ink_token_buffer_cleanup(struct ink_token_buffer *buffer);
+extern void ink_token_buffer_reset(struct ink_token_buffer *buffer);
+extern bool ink_token_buffer_replay(struct ink_token_buffer *buffer,
+                                    struct ink_scanner *scanner,
+                                    struct ink_token *token);
+extern int ink_token_buffer_record(struct ink_token_buffer *buffer,
+                                   enum ink_grammar_type type, size_t offset,
+                                   const struct ink_token *token);
+extern int ink_token_buffer_prelex(struct ink_token_buffer *buffer,
+                                   const struct ink_source *source,
+                                   size_t jobs);
+
+/**
+ * Try to recognize the current token as a keyword.
+ *
+ * If true, the specified token will have its type modified. The token's
+ * keyword class is looked up on first use and cached on the token, so that
+ * trying several keywords against one token only hashes it once.
+ */
+static inline bool ink_scanner_try_keyword(struct ink_scanner *scanner,
+                                           struct ink_token *token,
+                                           enum ink_token_type type)
+{
+    if (token->keyword == INK_TT_EOF) {
+        token->keyword = ink_scanner_keyword(scanner, token);
+    }
+    if (token->keyword == type) {
+        token->type = type;
+        return true;
+    }
+    return false;
+}
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,987 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include "simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define INK_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * Vectorized byte scanning primitives.
+ *
+ * Each primitive scans `bytes[offset..length)` and returns the offset of the
+ * first byte that ends the run, or `length` if there is none. Vector
+ * implementations only ever load whole blocks that lie within the range, and
+ * finish the remainder with the scalar implementation, so no bytes past
+ * `length` are read.
+ */
+struct ink_simd_ops {
+    size_t (*span_identifier)(const unsigned char *, size_t, size_t);
+    size_t (*span_blank)(const unsigned char *, size_t, size_t);
+    size_t (*find_either)(const unsigned char *, size_t, size_t,
+                          unsigned char, unsigned char);
+    size_t (*span_word)(const unsigned char *, size_t, size_t);
+    size_t (*span_ascii)(const unsigned char *, size_t, size_t);
+    size_t (*validate_utf8)(const unsigned char *, size_t, size_t);
+    uint64_t (*structural_mask)(const unsigned char *, size_t, size_t);
+    size_t (*find_sync)(const unsigned char *, size_t, size_t);
+};
+
+static const char *INK_SIMD_LEVEL_STR[] = {
+    [INK_SIMD_SCALAR] = "Scalar",
+    [INK_SIMD_SSE2] = "SSE2",
+    [INK_SIMD_AVX2] = "AVX2",
+};
+
+static inline int ink_simd_is_identifier(unsigned char c)
+{
+    return ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+static size_t ink_simd_span_identifier_scalar(const unsigned char *bytes,
+                                              size_t offset, size_t length)
+{
+    while (offset < length && ink_simd_is_identifier(bytes[offset])) {
+        offset++;
+    }
+    return offset;
+}
+
+static size_t ink_simd_span_blank_scalar(const unsigned char *bytes,
+                                         size_t offset, size_t length)
+{
+    while (offset < length &&
+           (bytes[offset] == ' ' || bytes[offset] == '\t')) {
+        offset++;
+    }
+    return offset;
+}
+
+static size_t ink_simd_find_either_scalar(const unsigned char *bytes,
+                                          size_t offset, size_t length,
+                                          unsigned char a, unsigned char b)
+{
+    while (offset < length && bytes[offset] != a && bytes[offset] != b) {
+        offset++;
+    }
+    return offset;
+}
+
+static size_t ink_simd_span_word_scalar(const unsigned char *bytes,
+                                        size_t offset, size_t length)
+{
+    while (offset < length &&
+           (ink_simd_is_identifier(bytes[offset]) || bytes[offset] >= 0x80)) {
+        offset++;
+    }
+    return offset;
+}
+
+static size_t ink_simd_span_ascii_scalar(const unsigned char *bytes,
+                                         size_t offset, size_t length)
+{
+    while (offset < length && bytes[offset] < 0x80) {
+        offset++;
+    }
+    return offset;
+}
+
+/*
+ * Bytes that can change how the lines after them are read: newlines,
+ * escapes, braces and the slashes that open comments.
+ */
+static const unsigned char INK_SIMD_STRUCTURAL[256] = {
+    ['\n'] = 1, ['\\'] = 1, ['{'] = 1, ['}'] = 1, ['/'] = 1,
+};
+
+static uint64_t ink_simd_structural_mask_scalar(const unsigned char *bytes,
+                                                size_t offset, size_t length)
+{
+    const size_t count = length - offset < 64 ? length - offset : 64;
+    uint64_t mask = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        mask |= (uint64_t)INK_SIMD_STRUCTURAL[bytes[offset + i]] << i;
+    }
+    return mask;
+}
+
+/*
+ * Bytes that can begin a token the parser synchronizes on after an error,
+ * or a comment that could hide one: newlines, closing braces and
+ * parentheses, the NUL that ends a source and slashes.
+ */
+static const unsigned char INK_SIMD_SYNC[256] = {
+    ['\n'] = 1, ['}'] = 1, [')'] = 1, ['\0'] = 1, ['/'] = 1,
+};
+
+static size_t ink_simd_find_sync_scalar(const unsigned char *bytes,
+                                        size_t offset, size_t length)
+{
+    while (offset < length && !INK_SIMD_SYNC[bytes[offset]]) {
+        offset++;
+    }
+    return offset;
+}
+
+/*
+ * Return the length of the multi-byte sequence at `offset`, or zero if it
+ * is not well-formed or is cut short by `length`.
+ *
+ * Sequences are checked against the table of well-formed UTF-8 byte
+ * sequences in the Unicode Standard, which rules out overlong encodings,
+ * surrogates and code points above U+10FFFF by narrowing the range allowed
+ * for the second byte.
+ */
+static inline size_t ink_simd_utf8_sequence(const unsigned char *bytes,
+                                            size_t offset, size_t length)
+{
+    const unsigned char c = bytes[offset];
+    unsigned char low = 0x80, high = 0xbf;
+    size_t count;
+
+    if (c >= 0xc2 && c <= 0xdf) {
+        count = 2;
+    } else if (c >= 0xe0 && c <= 0xef) {
+        count = 3;
+        low = c == 0xe0 ? 0xa0 : low;
+        high = c == 0xed ? 0x9f : high;
+    } else if (c >= 0xf0 && c <= 0xf4) {
+        count = 4;
+        low = c == 0xf0 ? 0x90 : low;
+        high = c == 0xf4 ? 0x8f : high;
+    } else {
+        return 0;
+    }
+    if (length - offset < count) {
+        return 0;
+    }
+    if (bytes[offset + 1] < low || bytes[offset + 1] > high) {
+        return 0;
+    }
+    for (size_t i = 2; i < count; i++) {
+        if ((bytes[offset + i] & 0xc0) != 0x80) {
+            return 0;
+        }
+    }
+    return count;
+}
+
+static size_t ink_simd_validate_utf8_scalar(const unsigned char *bytes,
+                                            size_t offset, size_t length)
+{
+    while (offset < length) {
+        if (bytes[offset] < 0x80) {
+            offset++;
+        } else {
+            const size_t count = ink_simd_utf8_sequence(bytes, offset, length);
+
+            if (count == 0) {
+                break;
+            }
+            offset += count;
+        }
+    }
+    return offset;
+}
+
+static const struct ink_simd_ops INK_SIMD_OPS_SCALAR = {
+    .span_identifier = ink_simd_span_identifier_scalar,
+    .span_blank = ink_simd_span_blank_scalar,
+    .find_either = ink_simd_find_either_scalar,
+    .span_word = ink_simd_span_word_scalar,
+    .span_ascii = ink_simd_span_ascii_scalar,
+    .validate_utf8 = ink_simd_validate_utf8_scalar,
+    .structural_mask = ink_simd_structural_mask_scalar,
+    .find_sync = ink_simd_find_sync_scalar,
+};
+
+/**
+ * Return the offset of the multi-byte sequence that begins within the three
+ * bytes before `offset` and would extend past it, or `offset` if there is
+ * none. No byte before `start` is considered.
+ *
+ * This is where validation resumes when only the bytes before `offset` are
+ * known to be well-formed, or where it must stop when the bytes after
+ * `offset` are yet to arrive.
+ */
+size_t ink_simd_utf8_boundary(const unsigned char *bytes, size_t start,
+                              size_t offset)
+{
+    for (size_t i = 1; i <= 3 && i <= offset - start; i++) {
+        const unsigned char c = bytes[offset - i];
+        const size_t count = c >= 0xf0 ? 4 : c >= 0xe0 ? 3 : 2;
+
+        if ((c & 0xc0) == 0x80) {
+            continue;
+        }
+        if (c >= 0xc0 && i < count) {
+            return offset - i;
+        }
+        break;
+    }
+    return offset;
+}
+
+#if defined(INK_SIMD_X86)
+
+/*
+ * Identifier bytes are classified with signed comparisons. Every byte of
+ * interest is ASCII, and bytes with the high bit set compare as negative, so
+ * they fall outside of every range. Letters are folded to lowercase first.
+ */
+__attribute__((target("sse2"))) static inline __m128i
+ink_simd_identifier_mask_sse2(__m128i x)
+{
+    const __m128i folded = _mm_or_si128(x, _mm_set1_epi8(0x20));
+    const __m128i alpha =
+        _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), folded));
+    const __m128i digit =
+        _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('0' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), x));
+
+    return _mm_or_si128(_mm_or_si128(alpha, digit),
+                        _mm_cmpeq_epi8(x, _mm_set1_epi8('_')));
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+ink_simd_identifier_mask_avx2(__m256i x)
+{
+    const __m256i folded = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+    const __m256i alpha =
+        _mm256_and_si256(_mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), folded));
+    const __m256i digit =
+        _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8('0' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), x));
+
+    return _mm256_or_si256(_mm256_or_si256(alpha, digit),
+                           _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_')));
+}
+
+__attribute__((target("sse2"))) static size_t
+ink_simd_span_identifier_sse2(const unsigned char *bytes, size_t offset,
+                              size_t length)
+{
+    for (; offset + 16 <= length; offset += 16) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(bytes + offset));
+        const __m128i m = ink_simd_identifier_mask_sse2(x);
+        const unsigned int mask = ~(unsigned int)_mm_movemask_epi8(m) & 0xffff;
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return ink_simd_span_identifier_scalar(bytes, offset, length);
+}
+
+__attribute__((target("sse2"))) static size_t
+ink_simd_span_blank_sse2(const unsigned char *bytes, size_t offset,
+                         size_t length)
+{
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+
+    for (; offset + 16 <= length; offset += 16) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(bytes + offset));
+        const __m128i m =
+            _mm_or_si128(_mm_cmpeq_epi8(x, space), _mm_cmpeq_epi8(x, tab));
+        const unsigned int mask = ~(unsigned int)_mm_movemask_epi8(m) & 0xffff;
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return ink_simd_span_blank_scalar(bytes, offset, length);
+}
+
+__attribute__((target("sse2"))) static size_t
+ink_simd_find_either_sse2(const unsigned char *bytes, size_t offset,
+                          size_t length, unsigned char a, unsigned char b)
+{
+    const __m128i va = _mm_set1_epi8((char)a);
+    const __m128i vb = _mm_set1_epi8((char)b);
+
+    for (; offset + 16 <= length; offset += 16) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(bytes + offset));
+        const __m128i m =
+            _mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb));
+        const unsigned int mask = (unsigned int)_mm_movemask_epi8(m);
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return ink_simd_find_either_scalar(bytes, offset, length, a, b);
+}
+
+__attribute__((target("sse2"))) static size_t
+ink_simd_span_word_sse2(const unsigned char *bytes, size_t offset,
+                        size_t length)
+{
+    for (; offset + 16 <= length; offset += 16) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(bytes + offset));
+        const __m128i m = ink_simd_identifier_mask_sse2(x);
+        const unsigned int mask =
+            ~((unsigned int)_mm_movemask_epi8(m) |
+              (unsigned int)_mm_movemask_epi8(x)) &
+            0xffff;
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return ink_simd_span_word_scalar(bytes, offset, length);
+}
+
+__attribute__((target("sse2"))) static size_t
+ink_simd_span_ascii_sse2(const unsigned char *bytes, size_t offset,
+                         size_t length)
+{
+    for (; offset + 16 <= length; offset += 16) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(bytes + offset));
+        const unsigned int mask = (unsigned int)_mm_movemask_epi8(x);
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return ink_simd_span_ascii_scalar(bytes, offset, length);
+}
+
+__attribute__((target("sse2"))) static inline unsigned int
+ink_simd_structural_sse2(__m128i x)
+{
+    const __m128i newline = _mm_cmpeq_epi8(x, _mm_set1_epi8('\n'));
+    const __m128i escape = _mm_cmpeq_epi8(x, _mm_set1_epi8('\\'));
+    const __m128i open = _mm_cmpeq_epi8(x, _mm_set1_epi8('{'));
+    const __m128i close = _mm_cmpeq_epi8(x, _mm_set1_epi8('}'));
+    const __m128i slash = _mm_cmpeq_epi8(x, _mm_set1_epi8('/'));
+    const __m128i m = _mm_or_si128(_mm_or_si128(newline, escape),
+                                   _mm_or_si128(_mm_or_si128(open, close),
+                                                slash));
+
+    return (unsigned int)_mm_movemask_epi8(m);
+}
+
+__attribute__((target("sse2"))) static uint64_t
+ink_simd_structural_mask_sse2(const unsigned char *bytes, size_t offset,
+                              size_t length)
+{
+    uint64_t mask = 0;
+
+    if (length - offset < 64) {
+        return ink_simd_structural_mask_scalar(bytes, offset, length);
+    }
+    for (unsigned int i = 0; i < 64; i += 16) {
+        const __m128i x =
+            _mm_loadu_si128((const __m128i *)(bytes + offset + i));
+
+        mask |= (uint64_t)ink_simd_structural_sse2(x) << i;
+    }
+    return mask;
+}
+
+__attribute__((target("sse2"))) static inline unsigned int
+ink_simd_sync_sse2(__m128i x)
+{
+    const __m128i newline = _mm_cmpeq_epi8(x, _mm_set1_epi8('\n'));
+    const __m128i brace = _mm_cmpeq_epi8(x, _mm_set1_epi8('}'));
+    const __m128i paren = _mm_cmpeq_epi8(x, _mm_set1_epi8(')'));
+    const __m128i nul = _mm_cmpeq_epi8(x, _mm_setzero_si128());
+    const __m128i slash = _mm_cmpeq_epi8(x, _mm_set1_epi8('/'));
+    const __m128i m = _mm_or_si128(_mm_or_si128(newline, brace),
+                                   _mm_or_si128(_mm_or_si128(paren, nul),
+                                                slash));
+
+    return (unsigned int)_mm_movemask_epi8(m);
+}
+
+__attribute__((target("sse2"))) static size_t
+ink_simd_find_sync_sse2(const unsigned char *bytes, size_t offset,
+                        size_t length)
+{
+    for (; offset + 16 <= length; offset += 16) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(bytes + offset));
+        const unsigned int mask = ink_simd_sync_sse2(x);
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return ink_simd_find_sync_scalar(bytes, offset, length);
+}
+
+/*
+ * Without a byte shuffle, SSE2 cannot classify multi-byte sequences in
+ * parallel. Blocks of ASCII are skipped whole, and any other block is
+ * checked a byte at a time, up to the end of the sequence that crosses out
+ * of it.
+ */
+__attribute__((target("sse2"))) static size_t
+ink_simd_validate_utf8_sse2(const unsigned char *bytes, size_t offset,
+                            size_t length)
+{
+    while (offset + 16 <= length) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(bytes + offset));
+        const size_t end = offset + 16;
+
+        if (_mm_movemask_epi8(x) == 0) {
+            offset = end;
+            continue;
+        }
+        while (offset < end) {
+            if (bytes[offset] < 0x80) {
+                offset++;
+            } else {
+                const size_t count =
+                    ink_simd_utf8_sequence(bytes, offset, length);
+
+                if (count == 0) {
+                    return offset;
+                }
+                offset += count;
+            }
+        }
+    }
+    return ink_simd_validate_utf8_scalar(bytes, offset, length);
+}
+
+/*
+ * Most runs in prose are shorter than a single block. The AVX2 primitives
+ * probe the first sixteen bytes with 128-bit operations before moving to
+ * 32-byte strides, so short runs do not pay for the wider loads.
+ */
+__attribute__((target("avx2"))) static size_t
+ink_simd_span_identifier_avx2(const unsigned char *bytes, size_t offset,
+                              size_t length)
+{
+    if (offset + 16 <= length) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(bytes + offset));
+        const __m128i m = ink_simd_identifier_mask_sse2(x);
+        const unsigned int mask = ~(unsigned int)_mm_movemask_epi8(m) & 0xffff;
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+        offset += 16;
+    }
+    for (; offset + 32 <= length; offset += 32) {
+        const __m256i x =
+            _mm256_loadu_si256((const __m256i *)(bytes + offset));
+        const __m256i m = ink_simd_identifier_mask_avx2(x);
+        const unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(m);
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return ink_simd_span_identifier_scalar(bytes, offset, length);
+}
+
+__attribute__((target("avx2"))) static size_t
+ink_simd_span_blank_avx2(const unsigned char *bytes, size_t offset,
+                         size_t length)
+{
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+
+    if (offset + 16 <= length) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(bytes + offset));
+        const __m128i m =
+            _mm_or_si128(_mm_cmpeq_epi8(x, _mm256_castsi256_si128(space)),
+                         _mm_cmpeq_epi8(x, _mm256_castsi256_si128(tab)));
+        const unsigned int mask = ~(unsigned int)_mm_movemask_epi8(m) & 0xffff;
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+        offset += 16;
+    }
+    for (; offset + 32 <= length; offset += 32) {
+        const __m256i x =
+            _mm256_loadu_si256((const __m256i *)(bytes + offset));
+        const __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(x, space),
+                                          _mm256_cmpeq_epi8(x, tab));
+        const unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(m);
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return ink_simd_span_blank_scalar(bytes, offset, length);
+}
+
+__attribute__((target("avx2"))) static size_t
+ink_simd_find_either_avx2(const unsigned char *bytes, size_t offset,
+                          size_t length, unsigned char a, unsigned char b)
+{
+    const __m256i va = _mm256_set1_epi8((char)a);
+    const __m256i vb = _mm256_set1_epi8((char)b);
+
+    if (offset + 16 <= length) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(bytes + offset));
+        const __m128i m =
+            _mm_or_si128(_mm_cmpeq_epi8(x, _mm256_castsi256_si128(va)),
+                         _mm_cmpeq_epi8(x, _mm256_castsi256_si128(vb)));
+        const unsigned int mask = (unsigned int)_mm_movemask_epi8(m);
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+        offset += 16;
+    }
+    for (; offset + 32 <= length; offset += 32) {
+        const __m256i x =
+            _mm256_loadu_si256((const __m256i *)(bytes + offset));
+        const __m256i m =
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, va), _mm256_cmpeq_epi8(x, vb));
+        const unsigned int mask = (unsigned int)_mm256_movemask_epi8(m);
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return ink_simd_find_either_scalar(bytes, offset, length, a, b);
+}
+
+__attribute__((target("avx2"))) static size_t
+ink_simd_span_word_avx2(const unsigned char *bytes, size_t offset,
+                        size_t length)
+{
+    if (offset + 16 <= length) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(bytes + offset));
+        const __m128i m = ink_simd_identifier_mask_sse2(x);
+        const unsigned int mask =
+            ~((unsigned int)_mm_movemask_epi8(m) |
+              (unsigned int)_mm_movemask_epi8(x)) &
+            0xffff;
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+        offset += 16;
+    }
+    for (; offset + 32 <= length; offset += 32) {
+        const __m256i x =
+            _mm256_loadu_si256((const __m256i *)(bytes + offset));
+        const __m256i m = ink_simd_identifier_mask_avx2(x);
+        const unsigned int mask = ~((unsigned int)_mm256_movemask_epi8(m) |
+                                    (unsigned int)_mm256_movemask_epi8(x));
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return ink_simd_span_word_scalar(bytes, offset, length);
+}
+
+__attribute__((target("avx2"))) static size_t
+ink_simd_span_ascii_avx2(const unsigned char *bytes, size_t offset,
+                         size_t length)
+{
+    for (; offset + 32 <= length; offset += 32) {
+        const __m256i x =
+            _mm256_loadu_si256((const __m256i *)(bytes + offset));
+        const unsigned int mask = (unsigned int)_mm256_movemask_epi8(x);
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return ink_simd_span_ascii_sse2(bytes, offset, length);
+}
+
+__attribute__((target("avx2"))) static inline unsigned int
+ink_simd_structural_avx2(__m256i x)
+{
+    const __m256i newline = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n'));
+    const __m256i escape = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\'));
+    const __m256i open = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('{'));
+    const __m256i close = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('}'));
+    const __m256i slash = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('/'));
+    const __m256i m =
+        _mm256_or_si256(_mm256_or_si256(newline, escape),
+                        _mm256_or_si256(_mm256_or_si256(open, close), slash));
+
+    return (unsigned int)_mm256_movemask_epi8(m);
+}
+
+__attribute__((target("avx2"))) static uint64_t
+ink_simd_structural_mask_avx2(const unsigned char *bytes, size_t offset,
+                              size_t length)
+{
+    __m256i lo, hi;
+
+    if (length - offset < 64) {
+        return ink_simd_structural_mask_scalar(bytes, offset, length);
+    }
+
+    lo = _mm256_loadu_si256((const __m256i *)(bytes + offset));
+    hi = _mm256_loadu_si256((const __m256i *)(bytes + offset + 32));
+    return (uint64_t)ink_simd_structural_avx2(lo) |
+           (uint64_t)ink_simd_structural_avx2(hi) << 32;
+}
+
+__attribute__((target("avx2"))) static size_t
+ink_simd_find_sync_avx2(const unsigned char *bytes, size_t offset,
+                        size_t length)
+{
+    for (; offset + 32 <= length; offset += 32) {
+        const __m256i x =
+            _mm256_loadu_si256((const __m256i *)(bytes + offset));
+        const __m256i newline = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n'));
+        const __m256i brace = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('}'));
+        const __m256i paren = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(')'));
+        const __m256i nul = _mm256_cmpeq_epi8(x, _mm256_setzero_si256());
+        const __m256i slash = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('/'));
+        const __m256i m = _mm256_or_si256(
+            _mm256_or_si256(newline, brace),
+            _mm256_or_si256(_mm256_or_si256(paren, nul), slash));
+        const unsigned int mask = (unsigned int)_mm256_movemask_epi8(m);
+
+        if (mask != 0) {
+            return offset + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return ink_simd_find_sync_sse2(bytes, offset, length);
+}
+
+/*
+ * UTF-8 validation after Keiser and Lemire, "Validating UTF-8 In Less Than
+ * One Instruction Per Byte". Each byte is classified together with the one
+ * before it through three table lookups, on the high nibble of the previous
+ * byte, the low nibble of the previous byte and the high nibble of the
+ * byte itself. Every bit of the result names an error that the pair of
+ * bytes exhibits, and the lookups are ANDed so that only errors all three
+ * agree on remain.
+ */
+#define INK_UTF8_TOO_SHORT (1 << 0)
+#define INK_UTF8_TOO_LONG (1 << 1)
+#define INK_UTF8_OVERLONG_3 (1 << 2)
+#define INK_UTF8_TOO_LARGE (1 << 3)
+#define INK_UTF8_SURROGATE (1 << 4)
+#define INK_UTF8_OVERLONG_2 (1 << 5)
+#define INK_UTF8_TOO_LARGE_1000 (1 << 6)
+#define INK_UTF8_OVERLONG_4 (1 << 6)
+#define INK_UTF8_TWO_CONTS (1 << 7)
+#define INK_UTF8_CARRY                                                         \
+    (INK_UTF8_TOO_SHORT | INK_UTF8_TOO_LONG | INK_UTF8_TWO_CONTS)
+
+#define INK_UTF8_LOOKUP(t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, \
+                        t13, t14, t15)                                         \
+    _mm256_setr_epi8(t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12,    \
+                     t13, t14, t15, t0, t1, t2, t3, t4, t5, t6, t7, t8, t9,    \
+                     t10, t11, t12, t13, t14, t15)
+
+/* The bytes `n` positions before each byte of `x`, continuing from `prev`. */
+#define INK_UTF8_PREV(x, prev, n)                                              \
+    _mm256_alignr_epi8((x), _mm256_permute2x128_si256((prev), (x), 0x21),    \
+                       16 - (n))
+
+__attribute__((target("avx2"))) static inline __m256i
+ink_simd_utf8_high_nibble(__m256i x)
+{
+    return _mm256_and_si256(_mm256_srli_epi16(x, 4), _mm256_set1_epi8(0x0f));
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+ink_simd_utf8_errors_avx2(__m256i x, __m256i prev)
+{
+    const __m256i prev1 = INK_UTF8_PREV(x, prev, 1);
+    const __m256i prev2 = INK_UTF8_PREV(x, prev, 2);
+    const __m256i prev3 = INK_UTF8_PREV(x, prev, 3);
+    const __m256i byte_1_high = _mm256_shuffle_epi8(
+        INK_UTF8_LOOKUP(
+            INK_UTF8_TOO_LONG, INK_UTF8_TOO_LONG, INK_UTF8_TOO_LONG,
+            INK_UTF8_TOO_LONG, INK_UTF8_TOO_LONG, INK_UTF8_TOO_LONG,
+            INK_UTF8_TOO_LONG, INK_UTF8_TOO_LONG, (char)INK_UTF8_TWO_CONTS,
+            (char)INK_UTF8_TWO_CONTS, (char)INK_UTF8_TWO_CONTS,
+            (char)INK_UTF8_TWO_CONTS, INK_UTF8_TOO_SHORT | INK_UTF8_OVERLONG_2,
+            INK_UTF8_TOO_SHORT,
+            INK_UTF8_TOO_SHORT | INK_UTF8_OVERLONG_3 | INK_UTF8_SURROGATE,
+            INK_UTF8_TOO_SHORT | INK_UTF8_TOO_LARGE | INK_UTF8_TOO_LARGE_1000 |
+                INK_UTF8_OVERLONG_4),
+        ink_simd_utf8_high_nibble(prev1));
+    const __m256i byte_1_low = _mm256_shuffle_epi8(
+        INK_UTF8_LOOKUP(
+            (char)(INK_UTF8_CARRY | INK_UTF8_OVERLONG_3 | INK_UTF8_OVERLONG_2 |
+                   INK_UTF8_OVERLONG_4),
+            (char)(INK_UTF8_CARRY | INK_UTF8_OVERLONG_2),
+            (char)INK_UTF8_CARRY, (char)INK_UTF8_CARRY,
+            (char)(INK_UTF8_CARRY | INK_UTF8_TOO_LARGE),
+            (char)(INK_UTF8_CARRY | INK_UTF8_TOO_LARGE |
+                   INK_UTF8_TOO_LARGE_1000),
+            (char)(INK_UTF8_CARRY | INK_UTF8_TOO_LARGE |
+                   INK_UTF8_TOO_LARGE_1000),
+            (char)(INK_UTF8_CARRY | INK_UTF8_TOO_LARGE |
+                   INK_UTF8_TOO_LARGE_1000),
+            (char)(INK_UTF8_CARRY | INK_UTF8_TOO_LARGE |
+                   INK_UTF8_TOO_LARGE_1000),
+            (char)(INK_UTF8_CARRY | INK_UTF8_TOO_LARGE |
+                   INK_UTF8_TOO_LARGE_1000),
+            (char)(INK_UTF8_CARRY | INK_UTF8_TOO_LARGE |
+                   INK_UTF8_TOO_LARGE_1000),
+            (char)(INK_UTF8_CARRY | INK_UTF8_TOO_LARGE |
+                   INK_UTF8_TOO_LARGE_1000),
+            (char)(INK_UTF8_CARRY | INK_UTF8_TOO_LARGE |
+                   INK_UTF8_TOO_LARGE_1000),
+            (char)(INK_UTF8_CARRY | INK_UTF8_TOO_LARGE |
+                   INK_UTF8_TOO_LARGE_1000 | INK_UTF8_SURROGATE),
+            (char)(INK_UTF8_CARRY | INK_UTF8_TOO_LARGE |
+                   INK_UTF8_TOO_LARGE_1000),
+            (char)(INK_UTF8_CARRY | INK_UTF8_TOO_LARGE |
+                   INK_UTF8_TOO_LARGE_1000)),
+        _mm256_and_si256(prev1, _mm256_set1_epi8(0x0f)));
+    const __m256i byte_2_high = _mm256_shuffle_epi8(
+        INK_UTF8_LOOKUP(
+            INK_UTF8_TOO_SHORT, INK_UTF8_TOO_SHORT, INK_UTF8_TOO_SHORT,
+            INK_UTF8_TOO_SHORT, INK_UTF8_TOO_SHORT, INK_UTF8_TOO_SHORT,
+            INK_UTF8_TOO_SHORT, INK_UTF8_TOO_SHORT,
+            (char)(INK_UTF8_TOO_LONG | INK_UTF8_OVERLONG_2 |
+                   INK_UTF8_TWO_CONTS | INK_UTF8_OVERLONG_3 |
+                   INK_UTF8_TOO_LARGE_1000 | INK_UTF8_OVERLONG_4),
+            (char)(INK_UTF8_TOO_LONG | INK_UTF8_OVERLONG_2 |
+                   INK_UTF8_TWO_CONTS | INK_UTF8_OVERLONG_3 |
+                   INK_UTF8_TOO_LARGE),
+            (char)(INK_UTF8_TOO_LONG | INK_UTF8_OVERLONG_2 |
+                   INK_UTF8_TWO_CONTS | INK_UTF8_SURROGATE |
+                   INK_UTF8_TOO_LARGE),
+            (char)(INK_UTF8_TOO_LONG | INK_UTF8_OVERLONG_2 |
+                   INK_UTF8_TWO_CONTS | INK_UTF8_SURROGATE |
+                   INK_UTF8_TOO_LARGE),
+            INK_UTF8_TOO_SHORT, INK_UTF8_TOO_SHORT, INK_UTF8_TOO_SHORT,
+            INK_UTF8_TOO_SHORT),
+        ink_simd_utf8_high_nibble(x));
+    const __m256i special =
+        _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low),
+                         byte_2_high);
+
+    /*
+     * Two continuation bytes in a row are only valid as the third or
+     * fourth byte of a sequence, which the two bytes before them reveal.
+     */
+    const __m256i is_third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(0x60));
+    const __m256i is_fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(0x70));
+    const __m256i must_continue =
+        _mm256_and_si256(_mm256_or_si256(is_third, is_fourth),
+                         _mm256_set1_epi8((char)0x80));
+
+    return _mm256_xor_si256(must_continue, special);
+}
+
+__attribute__((target("avx2"))) static size_t
+ink_simd_validate_utf8_avx2(const unsigned char *bytes, size_t offset,
+                            size_t length)
+{
+    const size_t start = offset;
+    /* Lead bytes in the last three positions whose sequences run on. */
+    const __m256i incomplete_max = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char)(0xf0 - 1),
+        (char)(0xe0 - 1), (char)(0xc0 - 1));
+    __m256i prev = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+
+    for (; offset + 32 <= length; offset += 32) {
+        const __m256i x =
+            _mm256_loadu_si256((const __m256i *)(bytes + offset));
+        __m256i errors;
+
+        if (_mm256_movemask_epi8(x) == 0) {
+            errors = incomplete;
+            incomplete = _mm256_setzero_si256();
+        } else {
+            errors = ink_simd_utf8_errors_avx2(x, prev);
+            incomplete = _mm256_subs_epu8(x, incomplete_max);
+        }
+        if (!_mm256_testz_si256(errors, errors)) {
+            break;
+        }
+        prev = x;
+    }
+
+    /* Find the exact offset of an error, or finish the remainder. */
+    offset = ink_simd_utf8_boundary(bytes, start, offset);
+    return ink_simd_validate_utf8_sse2(bytes, offset, length);
+}
+
+static const struct ink_simd_ops INK_SIMD_OPS_SSE2 = {
+    .span_identifier = ink_simd_span_identifier_sse2,
+    .span_blank = ink_simd_span_blank_sse2,
+    .find_either = ink_simd_find_either_sse2,
+    .span_word = ink_simd_span_word_sse2,
+    .span_ascii = ink_simd_span_ascii_sse2,
+    .validate_utf8 = ink_simd_validate_utf8_sse2,
+    .structural_mask = ink_simd_structural_mask_sse2,
+    .find_sync = ink_simd_find_sync_sse2,
+};
+
+static const struct ink_simd_ops INK_SIMD_OPS_AVX2 = {
+    .span_identifier = ink_simd_span_identifier_avx2,
+    .span_blank = ink_simd_span_blank_avx2,
+    .find_either = ink_simd_find_either_avx2,
+    .span_word = ink_simd_span_word_avx2,
+    .span_ascii = ink_simd_span_ascii_avx2,
+    .validate_utf8 = ink_simd_validate_utf8_avx2,
+    .structural_mask = ink_simd_structural_mask_avx2,
+    .find_sync = ink_simd_find_sync_avx2,
+};
+
+#endif
+
+/*
+ * The scalar implementation is used until `ink_simd_initialize` has been
+ * called, so the primitives are always safe to use.
+ */
+static const struct ink_simd_ops *ink_simd_ops = &INK_SIMD_OPS_SCALAR;
+
+/**
+ * Return a NULL-terminated string describing an instruction set level.
+ */
+const char *ink_simd_level_strz(enum ink_simd_level level)
+{
+    return INK_SIMD_LEVEL_STR[level];
+}
+
+/**
+ * Determine the highest instruction set level supported by the host CPU.
+ */
+enum ink_simd_level ink_simd_detect(void)
+{
+#if defined(INK_SIMD_X86)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return INK_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return INK_SIMD_SSE2;
+    }
+#endif
+    return INK_SIMD_SCALAR;
+}
+
+/**
+ * Select the implementation used by the scanning primitives.
+ *
+ * Levels the host CPU does not support are lowered to the highest level it
+ * does. Returns the level that was selected.
+ *
+ * Not thread-safe. Selection is expected to happen once at startup, before
+ * any scanning takes place.
+ */
+enum ink_simd_level ink_simd_select(enum ink_simd_level level)
+{
+    const enum ink_simd_level supported = ink_simd_detect();
+
+    if (level > supported) {
+        level = supported;
+    }
+    switch (level) {
+#if defined(INK_SIMD_X86)
+    case INK_SIMD_AVX2:
+        ink_simd_ops = &INK_SIMD_OPS_AVX2;
+        break;
+    case INK_SIMD_SSE2:
+        ink_simd_ops = &INK_SIMD_OPS_SSE2;
+        break;
+#endif
+    default:
+        level = INK_SIMD_SCALAR;
+        ink_simd_ops = &INK_SIMD_OPS_SCALAR;
+        break;
+    }
+    return level;
+}
+
+/**
+ * Select the best implementation supported by the host CPU.
+ */
+void ink_simd_initialize(void)
+{
+    ink_simd_select(ink_simd_detect());
+}
+
+/**
+ * Return the offset of the first byte that cannot appear in an identifier.
+ */
+size_t ink_simd_span_identifier(const unsigned char *bytes, size_t offset,
+                                size_t length)
+{
+    return ink_simd_ops->span_identifier(bytes, offset, length);
+}
+
+/**
+ * Return the offset of the first byte that is not a space or a tab.
+ */
+size_t ink_simd_span_blank(const unsigned char *bytes, size_t offset,
+                           size_t length)
+{
+    return ink_simd_ops->span_blank(bytes, offset, length);
+}
+
+/**
+ * Return the offset of the first byte equal to either `a` or `b`.
+ */
+size_t ink_simd_find_either(const unsigned char *bytes, size_t offset,
+                            size_t length, unsigned char a, unsigned char b)
+{
+    return ink_simd_ops->find_either(bytes, offset, length, a, b);
+}
+
+/**
+ * Return the offset of the first byte that cannot appear in a word of
+ * content, which unlike an identifier may contain non-ASCII characters.
+ */
+size_t ink_simd_span_word(const unsigned char *bytes, size_t offset,
+                          size_t length)
+{
+    return ink_simd_ops->span_word(bytes, offset, length);
+}
+
+/**
+ * Return the offset of the first byte that is not ASCII.
+ */
+size_t ink_simd_span_ascii(const unsigned char *bytes, size_t offset,
+                           size_t length)
+{
+    return ink_simd_ops->span_ascii(bytes, offset, length);
+}
+
+/**
+ * Return the offset of the first byte that does not begin a well-formed,
+ * complete UTF-8 sequence, or `length` if there is none.
+ *
+ * `offset` must not fall within a multi-byte sequence.
+ */
+size_t ink_simd_validate_utf8(const unsigned char *bytes, size_t offset,
+                              size_t length)
+{
+    return ink_simd_ops->validate_utf8(bytes, offset, length);
+}
+
+/**
+ * Return a mask of the newlines, backslashes, braces and slashes among the
+ * 64 bytes at `offset`, with bit `i` set for the byte at `offset + i`. Bytes
+ * past `length` are not read, and their bits are clear.
+ */
+uint64_t ink_simd_structural_mask(const unsigned char *bytes, size_t offset,
+                                  size_t length)
+{
+    return ink_simd_ops->structural_mask(bytes, offset, length);
+}
+
+/**
+ * Return the offset of the first newline, closing brace or parenthesis, NUL
+ * or slash.
+ */
+size_t ink_simd_find_sync(const unsigned char *bytes, size_t offset,
+                          size_t length)
+{
+    return ink_simd_ops->find_sync(bytes, offset, length);
+}
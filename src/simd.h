@@ -0,0 +1,50 @@
+#ifndef __INK_SIMD_H__
+#define __INK_SIMD_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common.h"
+
+/**
+ * Instruction set levels for vectorized byte scanning.
+ */
+enum ink_simd_level {
+    INK_SIMD_SCALAR,
+    INK_SIMD_SSE2,
+    INK_SIMD_AVX2,
+};
+
+extern const char *ink_simd_level_strz(enum ink_simd_level level);
+extern enum ink_simd_level ink_simd_detect(void);
+extern enum ink_simd_level ink_simd_select(enum ink_simd_level level);
+extern INK_API void ink_simd_initialize(void);
+extern size_t ink_simd_span_identifier(const unsigned char *bytes,
+                                       size_t offset, size_t length);
+extern size_t ink_simd_span_blank(const unsigned char *bytes, size_t offset,
+                                  size_t length);
+extern size_t ink_simd_find_either(const unsigned char *bytes, size_t offset,
+                                   size_t length, unsigned char a,
+                                   unsigned char b);
+extern size_t ink_simd_span_word(const unsigned char *bytes, size_t offset,
+                                 size_t length);
+extern size_t ink_simd_span_ascii(const unsigned char *bytes, size_t offset,
+                                  size_t length);
+extern size_t ink_simd_validate_utf8(const unsigned char *bytes,
+                                     size_t offset, size_t length);
+extern uint64_t ink_simd_structural_mask(const unsigned char *bytes,
+                                         size_t offset, size_t length);
+extern size_t ink_simd_utf8_boundary(const unsigned char *bytes, size_t start,
+                                     size_t offset);
+extern size_t ink_simd_find_sync(const unsigned char *bytes, size_t offset,
+                                 size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
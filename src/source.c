@@ -1,12 +1,20 @@
-#include <stdio.h>
-#include <stdlib.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "common.h"
 #include "platform.h"
+#include "simd.h"
 #include "source.h"
+#include "vec.h"
 
-#define INK_SOURCE_BUF_MAX 1024
+#define INK_SOURCE_FILL_MIN 65536
 
 static const char *INK_FILE_EXT = ".ink";
 static const size_t INK_FILE_EXT_LENGTH = 4;
@@ -25,37 +33,80 @@ static char *ink_string_copy(const char *chars, size_t length)
 }
 
 /**
- * Load an Ink source file from STDIN.
+ * Determine if every offset into a source of the given length, including
+ * the offset one past its last byte, can be held by an `ink_offset_t`.
  */
-int ink_source_load_stdin(struct ink_source *source)
+static inline bool ink_source_is_addressable(size_t length)
 {
-    char buf[INK_SOURCE_BUF_MAX];
+#if SIZE_MAX > INK_OFFSET_MAX
+    return length <= INK_OFFSET_MAX;
+#else
+    (void)length;
+    return true;
+#endif
+}
 
+static void ink_source_initialize(struct ink_source *source)
+{
     source->filename = NULL;
     source->bytes = NULL;
     source->length = 0;
+    source->capacity = 0;
+    source->is_mapped = false;
+    source->is_streaming = false;
+}
 
-    while (fgets(buf, INK_SOURCE_BUF_MAX, stdin)) {
-        const size_t len = source->length;
-        const size_t buflen = strlen(buf);
-        unsigned char *tmp;
+/**
+ * Load an Ink source file from STDIN.
+ */
+int ink_source_load_stdin(struct ink_source *source)
+{
+    int rc;
 
-        tmp = realloc(source->bytes, len + buflen + 1);
-        if (tmp == NULL) {
-            ink_source_free(source);
-            return -INK_E_OOM;
-        }
+    ink_source_initialize(source);
 
-        source->bytes = tmp;
-        memcpy(source->bytes + len, buf, buflen);
-        source->length += buflen;
-        source->bytes[source->length] = '\0';
+    rc = platform_load_stdin(&source->bytes, &source->length);
+    if (rc == -2) {
+        return -INK_E_OOM;
     }
-    if (ferror(stdin)) {
+    if (rc == -1) {
+        return -INK_E_OS;
+    }
+
+    source->capacity = source->length + 1;
+
+    if (!ink_source_is_addressable(source->length)) {
+        ink_source_free(source);
+        return -INK_E_FILE_SIZE;
+    }
+
+    source->filename = ink_string_copy("STDIN", 5);
+    if (source->filename == NULL) {
         ink_source_free(source);
         return -INK_E_OOM;
     }
+    return INK_E_OK;
+}
+
+/**
+ * Open a streaming Ink source on STDIN.
+ *
+ * No input is read here. Bytes are read on demand by `ink_source_fill`,
+ * allowing parsing to begin before the writer on the other end of the
+ * stream has finished.
+ */
+int ink_source_stream_stdin(struct ink_source *source)
+{
+    ink_source_initialize(source);
+    source->capacity = INK_SOURCE_FILL_MIN;
+    source->is_streaming = true;
 
+    source->bytes = platform_mem_alloc(source->capacity);
+    if (source->bytes == NULL) {
+        return -INK_E_OOM;
+    }
+
+    source->bytes[0] = '\0';
     source->filename = ink_string_copy("STDIN", 5);
     if (source->filename == NULL) {
         ink_source_free(source);
@@ -64,6 +115,57 @@ int ink_source_load_stdin(struct ink_source *source)
     return INK_E_OK;
 }
 
+/**
+ * Append the next available bytes of a streaming source, blocking until at
+ * least one byte has arrived or the end of the input has been reached.
+ *
+ * Returns a positive value if any bytes were appended. Zero is returned once
+ * the stream has been exhausted, or if the source is not a streaming source.
+ */
+int ink_source_fill(struct ink_source *source)
+{
+    int rc;
+    size_t size;
+    size_t nread = 0;
+    unsigned char *bytes;
+
+    if (!source->is_streaming) {
+        return 0;
+    }
+    if (source->capacity - source->length - 1 < INK_SOURCE_FILL_MIN / 2) {
+        bytes = platform_mem_realloc(source->bytes, source->capacity,
+                                     source->capacity * 2);
+        if (bytes == NULL) {
+            source->is_streaming = false;
+            return -INK_E_OOM;
+        }
+
+        source->bytes = bytes;
+        source->capacity *= 2;
+    }
+
+    size = source->capacity - source->length - 1;
+#if SIZE_MAX > INK_OFFSET_MAX
+    if (size > INK_OFFSET_MAX - source->length) {
+        size = INK_OFFSET_MAX - source->length;
+    }
+#endif
+    if (size == 0) {
+        source->is_streaming = false;
+        return -INK_E_FILE_SIZE;
+    }
+
+    rc = platform_read_stdin(source->bytes + source->length, size, &nread);
+    if (rc == -1 || nread == 0) {
+        source->is_streaming = false;
+        return rc == -1 ? -INK_E_OS : 0;
+    }
+
+    source->length += nread;
+    source->bytes[source->length] = '\0';
+    return 1;
+}
+
 /**
  * Load an Ink source file from the file system.
  */
@@ -73,9 +175,7 @@ int ink_source_load(const char *filename, struct ink_source *source)
     const char *ext;
     const size_t namelen = strlen(filename);
 
-    source->filename = NULL;
-    source->bytes = NULL;
-    source->length = 0;
+    ink_source_initialize(source);
 
     if (namelen < INK_FILE_EXT_LENGTH)
         return -INK_E_FILE;
@@ -89,24 +189,181 @@ int ink_source_load(const char *filename, struct ink_source *source)
     if (source->filename == NULL)
         return -INK_E_OOM;
 
-    rc = platform_load_file(filename, &source->bytes, &source->length);
-    if (rc == -1) {
-        platform_mem_dealloc(source->filename, namelen + 1);
-        return -INK_E_OS;
+    rc = platform_map_file(filename, &source->bytes, &source->length);
+    if (rc == 0) {
+        source->is_mapped = true;
+    } else {
+        rc = platform_load_file(filename, &source->bytes, &source->length);
+        if (rc == -1) {
+            platform_mem_dealloc(source->filename, namelen + 1);
+            return -INK_E_OS;
+        }
+
+        source->capacity = source->length + 1;
+    }
+    if (!ink_source_is_addressable(source->length)) {
+        ink_source_free(source);
+        return -INK_E_FILE_SIZE;
     }
     return 0;
 }
 
+/**
+ * Check that a source is well-formed UTF-8, setting `*offset` to the end of
+ * its longest well-formed prefix.
+ *
+ * Sources are not validated as they are loaded. The scanner validates the
+ * bytes it reaches a region at a time, while they are still in the cache,
+ * and stops short at a malformed sequence. This is for readers of a source
+ * that do not scan it, and for finding where scanning stopped.
+ */
+int ink_source_validate(const struct ink_source *source, size_t *offset)
+{
+    *offset = ink_simd_validate_utf8(source->bytes, 0, source->length);
+    return *offset == source->length ? INK_E_OK : -INK_E_FILE_ENCODING;
+}
+
 void ink_source_free(struct ink_source *source)
 {
     if (source->bytes) {
-        platform_mem_dealloc(source->bytes, source->length + 1);
+        if (source->is_mapped) {
+            platform_unmap_file(source->bytes, source->length);
+        } else {
+            platform_mem_dealloc(source->bytes, source->capacity);
+        }
     }
     if (source->filename) {
         platform_mem_dealloc(source->filename, strlen(source->filename) + 1);
     }
 
-    source->filename = NULL;
-    source->bytes = NULL;
-    source->length = 0;
+    ink_source_initialize(source);
+}
+
+/**
+ * Ready an empty index of lines.
+ */
+void ink_source_lines_initialize(struct ink_source_lines *lines)
+{
+    lines->length = 0;
+    ink_source_line_index_create(&lines->starts);
+}
+
+/**
+ * Release the memory held by an index of lines.
+ */
+void ink_source_lines_cleanup(struct ink_source_lines *lines)
+{
+    ink_source_line_index_destroy(&lines->starts);
+    lines->length = 0;
+}
+
+/**
+ * Extend an index of lines to cover every byte of a source received so far.
+ *
+ * Newlines are located sixteen bytes at a time where SSE2 is available.
+ */
+static void ink_source_lines_extend(const struct ink_source *source,
+                                    struct ink_source_lines *lines)
+{
+    const unsigned char *bytes = source->bytes;
+    const size_t length = source->length;
+    size_t offset = lines->length;
+
+    if (lines->starts.count > 0 && offset >= length) {
+        return;
+    }
+    if (lines->starts.count == 0) {
+        ink_source_line_index_append(&lines->starts, 0);
+    }
+#if defined(__SSE2__)
+    {
+        const __m128i newline = _mm_set1_epi8('\n');
+
+        for (; offset + 16 <= length; offset += 16) {
+            const __m128i chunk =
+                _mm_loadu_si128((const __m128i *)(bytes + offset));
+            unsigned int mask = (unsigned int)_mm_movemask_epi8(
+                _mm_cmpeq_epi8(chunk, newline));
+
+            while (mask != 0) {
+                const size_t index = (size_t)__builtin_ctz(mask);
+
+                ink_source_line_index_append(&lines->starts,
+                                             offset + index + 1);
+                mask &= mask - 1;
+            }
+        }
+    }
+#endif
+    for (; offset < length; offset++) {
+        if (bytes[offset] == '\n') {
+            ink_source_line_index_append(&lines->starts, offset + 1);
+        }
+    }
+
+    lines->length = length;
+}
+
+/**
+ * Return the zero-based line number containing a source offset.
+ *
+ * A newline belongs to the line it terminates. Offsets past the final line,
+ * such as the end of a file that ends with a newline, belong to the final
+ * line.
+ */
+size_t ink_source_line(const struct ink_source *source,
+                       struct ink_source_lines *lines, size_t offset)
+{
+    const size_t *starts;
+    size_t count, low, high;
+
+    ink_source_lines_extend(source, lines);
+
+    starts = lines->starts.entries;
+    count = lines->starts.count;
+
+    /* A trailing newline does not begin another line. */
+    if (count > 1 && starts[count - 1] == source->length) {
+        count--;
+    }
+
+    low = 0;
+    high = count;
+
+    /* Find the last line starting at or before the offset. */
+    while (high - low > 1) {
+        const size_t mid = low + (high - low) / 2;
+
+        if (starts[mid] <= offset) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * Return the source offset at which a zero-based line number starts.
+ */
+size_t ink_source_line_start(const struct ink_source *source,
+                             struct ink_source_lines *lines, size_t line)
+{
+    ink_source_lines_extend(source, lines);
+
+    assert(line < lines->starts.count);
+    return lines->starts.entries[line];
+}
+
+/**
+ * Compute the one-based line and column numbers of a source offset.
+ */
+void ink_source_locate(const struct ink_source *source,
+                       struct ink_source_lines *lines, size_t offset,
+                       struct ink_source_location *location)
+{
+    const size_t line = ink_source_line(source, lines, offset);
+
+    location->line = line + 1;
+    location->column = offset - ink_source_line_start(source, lines, line) + 1;
 }
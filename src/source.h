@@ -5,17 +5,81 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stddef.h>
 
+#include "common.h"
+#include "vec.h"
+
+INK_VEC_DECLARE(ink_source_line_index, size_t)
+
+/**
+ * Ink source file.
+ *
+ * The source's bytes are always followed by a NUL byte. Sources loaded from
+ * the file system are memory-mapped where possible, in which case `bytes` is
+ * read-only and `is_mapped` is set.
+ *
+ * A streaming source starts out empty and receives its bytes incrementally
+ * through `ink_source_fill`, which the scanner calls whenever it reaches the
+ * end of the bytes received so far. Once the end of the input has been
+ * reached, `is_streaming` is cleared and the source behaves like any other.
+ * Since `bytes` may be reallocated by a fill, positions within a source must
+ * be held as offsets rather than pointers.
+ *
+ * Sources must be well-formed UTF-8. Rather than being checked as a whole
+ * when loaded, which would touch every page of a mapped file up front,
+ * bytes are validated by the scanner as it reaches them; see
+ * `ink_source_validate` for readers that do not scan.
+ */
 struct ink_source {
     char *filename;
     unsigned char *bytes;
     size_t length;
+    size_t capacity;
+    bool is_mapped;
+    bool is_streaming;
+};
+
+/**
+ * Index of the lines of a source, recording the offset at which each starts.
+ *
+ * An index is built on its first lookup, and extended on later lookups if
+ * the source has grown since. It is kept apart from the source, which it
+ * only reads, so that a source can be shared between threads that each look
+ * up lines with an index of their own.
+ */
+struct ink_source_lines {
+    size_t length;
+    struct ink_source_line_index starts;
+};
+
+/**
+ * One-based line and column numbers of a source offset.
+ */
+struct ink_source_location {
+    size_t line;
+    size_t column;
 };
 
-extern int ink_source_load(const char *filename, struct ink_source *source);
-extern int ink_source_load_stdin(struct ink_source *source);
-extern void ink_source_free(struct ink_source *source);
+extern INK_API int ink_source_load(const char *filename,
+                                   struct ink_source *source);
+extern INK_API int ink_source_load_stdin(struct ink_source *source);
+extern INK_API int ink_source_stream_stdin(struct ink_source *source);
+extern int ink_source_fill(struct ink_source *source);
+extern INK_API int ink_source_validate(const struct ink_source *source,
+                                       size_t *offset);
+extern INK_API void ink_source_free(struct ink_source *source);
+extern void ink_source_lines_initialize(struct ink_source_lines *lines);
+extern void ink_source_lines_cleanup(struct ink_source_lines *lines);
+extern size_t ink_source_line(const struct ink_source *source,
+                              struct ink_source_lines *lines, size_t offset);
+extern size_t ink_source_line_start(const struct ink_source *source,
+                                    struct ink_source_lines *lines,
+                                    size_t line);
+extern void ink_source_locate(const struct ink_source *source,
+                              struct ink_source_lines *lines, size_t offset,
+                              struct ink_source_location *location);
 
 #ifdef __cplusplus
 }
@@ -7,30 +7,46 @@
 static const char *INK_TT_STR[] = {INK_TT(T)};
 #undef T
 
+/*
+ * Every token type needs a bit of its own in an `ink_token_set`.
+ */
+typedef char ink_token_set_fits[INK_TT_COUNT <= 64 ? 1 : -1];
+
 const char *ink_token_type_strz(enum ink_token_type type)
 {
     return INK_TT_STR[type];
 }
 
+/**
+ * Print a token, along with its source offsets and location, to the console.
+ *
+ * The location is looked up in `lines`, an index of the source's lines.
+ */
 void ink_token_print(const struct ink_source *source,
+                     struct ink_source_lines *lines,
                      const struct ink_token *token)
 {
     const size_t start = token->start_offset;
     const size_t end = token->end_offset;
+    struct ink_source_location location;
+
+    ink_source_locate(source, lines, start, &location);
 
     switch (token->type) {
     case INK_TT_EOF:
-        printf("[DEBUG] %s(%zu, %zu): `\\0`\n",
-               ink_token_type_strz(token->type), start, end);
+        printf("[DEBUG] %s(%zu, %zu) <line:%zu, col:%zu>: `\\0`\n",
+               ink_token_type_strz(token->type), start, end, location.line,
+               location.column);
         break;
     case INK_TT_NL:
-        printf("[DEBUG] %s(%zu, %zu): `\\n`\n",
-               ink_token_type_strz(token->type), start, end);
+        printf("[DEBUG] %s(%zu, %zu) <line:%zu, col:%zu>: `\\n`\n",
+               ink_token_type_strz(token->type), start, end, location.line,
+               location.column);
         break;
     default:
-        printf("[DEBUG] %s(%zu, %zu): `%.*s`\n",
-               ink_token_type_strz(token->type), start, end, (int)(end - start),
-               source->bytes + start);
+        printf("[DEBUG] %s(%zu, %zu) <line:%zu, col:%zu>: `%.*s`\n",
+               ink_token_type_strz(token->type), start, end, location.line,
+               location.column, (int)(end - start), source->bytes + start);
         break;
     }
 }
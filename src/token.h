@@ -5,9 +5,13 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stddef.h>
 
+#include "common.h"
+
 struct ink_source;
+struct ink_source_lines;
 
 #define INK_TT(T)                                                              \
     T(TT_EOF, "EndOfFile")                                                     \
@@ -73,18 +77,46 @@ struct ink_source;
 
 #define T(name, description) INK_##name,
 enum ink_token_type {
-    INK_TT(T)
+    INK_TT(T) INK_TT_COUNT
 };
 #undef T
 
+/**
+ * Set of token types, with a bit for each type.
+ *
+ * There are fewer token types than bits, so that testing a token against a
+ * set is a single AND, and sets are built at compile time by OR-ing
+ * together INK_TOKEN_BIT for each of their types.
+ */
+typedef uint64_t ink_token_set;
+
+#define INK_TOKEN_BIT(type) ((ink_token_set)1 << (type))
+
+static inline bool ink_token_set_has(ink_token_set set,
+                                     enum ink_token_type type)
+{
+    return (set & INK_TOKEN_BIT(type)) != 0;
+}
+
+/**
+ * A token scanned from a source buffer.
+ *
+ * `type` and `keyword` hold values of `enum ink_token_type` in a byte each,
+ * which together with 32-bit offsets keeps a token to 12 bytes.
+ *
+ * `keyword` caches the reserved word the token spells, if any, as found by
+ * `ink_scanner_try_keyword`. It is INK_TT_EOF until first looked up.
+ */
 struct ink_token {
-    enum ink_token_type type;
-    size_t start_offset;
-    size_t end_offset;
+    unsigned char type;
+    unsigned char keyword;
+    ink_offset_t start_offset;
+    ink_offset_t end_offset;
 };
 
 extern const char *ink_token_type_strz(enum ink_token_type type);
 extern void ink_token_print(const struct ink_source *source,
+                            struct ink_source_lines *lines,
                             const struct ink_token *token);
 
 #ifdef __cplusplus
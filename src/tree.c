@@ -18,11 +18,6 @@
 #define ANSI_BOLD_ON "\x1b[1m"
 #define ANSI_BOLD_OFF "\x1b[22m"
 
-struct ink_source_range {
-    size_t start_offset;
-    size_t end_offset;
-};
-
 struct ink_print_context {
     const char *filename;
     const char *node_type_strz;
@@ -35,7 +30,6 @@ struct ink_print_context {
 };
 
 INK_VEC_DECLARE(ink_node_buffer, struct ink_syntax_node *)
-INK_VEC_DECLARE(ink_line_buffer, struct ink_source_range)
 
 #define T(name, description) description,
 static const char *INK_NODE_TYPE_STR[] = {INK_NODE(T)};
@@ -54,48 +48,6 @@ const char *ink_syntax_node_type_strz(enum ink_syntax_node_type type)
     return INK_NODE_TYPE_STR[type];
 }
 
-static void ink_build_lines(struct ink_line_buffer *lines,
-                            const struct ink_source *source)
-{
-    struct ink_source_range range;
-    size_t start_offset = 0;
-    size_t end_offset = 0;
-
-    while (source->bytes[end_offset] != '\0') {
-        if (source->bytes[end_offset] == '\n') {
-            range.start_offset = start_offset;
-            range.end_offset = end_offset;
-
-            ink_line_buffer_append(lines, range);
-            start_offset = end_offset + 1;
-        }
-        end_offset++;
-    }
-    if (start_offset != end_offset || !end_offset) {
-        range.start_offset = start_offset;
-        range.end_offset = end_offset;
-
-        ink_line_buffer_append(lines, range);
-    }
-}
-
-static size_t ink_calculate_line(const struct ink_line_buffer *lines,
-                                 size_t offset)
-{
-    size_t line_number = 0;
-
-    for (size_t i = 0; i < lines->count; i++) {
-        const struct ink_source_range range = lines->entries[i];
-
-        if (offset >= range.start_offset && offset <= range.end_offset) {
-            return line_number;
-        }
-
-        line_number++;
-    }
-    return lines->count - 1;
-}
-
 static void
 ink_syntax_node_print_nocolors(const struct ink_syntax_node *node,
                                const struct ink_print_context *context,
@@ -108,6 +60,7 @@ ink_syntax_node_print_nocolors(const struct ink_syntax_node *node,
         break;
     }
     case INK_NODE_BLOCK_STMT:
+    case INK_NODE_LAZY_BLOCK_STMT:
     case INK_NODE_CHOICE_STMT: {
         snprintf(buffer, length, "%s <line:%zu, line:%zu>",
                  context->node_type_strz, context->line_start,
@@ -158,6 +111,7 @@ ink_syntax_node_print_colors(const struct ink_syntax_node *node,
         break;
     }
     case INK_NODE_BLOCK_STMT:
+    case INK_NODE_LAZY_BLOCK_STMT:
     case INK_NODE_CHOICE_STMT: {
         snprintf(buffer, length,
                  ANSI_COLOR_BLUE ANSI_BOLD_ON
@@ -208,24 +162,27 @@ ink_syntax_node_print_colors(const struct ink_syntax_node *node,
 }
 
 static void ink_syntax_tree_print_node(const struct ink_syntax_tree *tree,
-                                       const struct ink_line_buffer *lines,
+                                       struct ink_source_lines *lines,
                                        const struct ink_syntax_node *node,
                                        const char *prefix,
                                        const char **pointers, bool colors)
 {
     char line[1024];
-    const size_t line_start = ink_calculate_line(lines, node->start_offset);
-    const size_t line_end = ink_calculate_line(lines, node->end_offset);
-    const struct ink_source_range line_range = lines->entries[line_start];
+    const struct ink_source *source = tree->source;
+    const size_t line_start =
+        ink_source_line(source, lines, node->start_offset);
+    const size_t line_end = ink_source_line(source, lines, node->end_offset);
+    const size_t line_offset =
+        ink_source_line_start(source, lines, line_start);
     const struct ink_print_context context = {
-        .filename = tree->source->filename,
+        .filename = source->filename,
         .node_type_strz = ink_syntax_node_type_strz(node->type),
-        .lexeme = tree->source->bytes + node->start_offset,
+        .lexeme = source->bytes + node->start_offset,
         .lexeme_length = node->end_offset - node->start_offset,
         .line_start = line_start + 1,
         .line_end = line_end + 1,
-        .column_start = (node->start_offset - line_range.start_offset) + 1,
-        .column_end = (node->end_offset - line_range.start_offset) + 1,
+        .column_start = (node->start_offset - line_offset) + 1,
+        .column_end = (node->end_offset - line_offset) + 1,
     };
 
     if (colors) {
@@ -238,7 +195,7 @@ static void ink_syntax_tree_print_node(const struct ink_syntax_tree *tree,
 }
 
 static void ink_syntax_tree_print_walk(const struct ink_syntax_tree *tree,
-                                       const struct ink_line_buffer *lines,
+                                       struct ink_source_lines *lines,
                                        const struct ink_syntax_node *node,
                                        const char *prefix,
                                        const char **pointers, bool colors)
@@ -283,19 +240,16 @@ static void ink_syntax_tree_print_walk(const struct ink_syntax_tree *tree,
  */
 void ink_syntax_tree_print(const struct ink_syntax_tree *tree, bool colors)
 {
-    struct ink_line_buffer lines;
-
-    ink_line_buffer_create(&lines);
-    ink_build_lines(&lines, tree->source);
+    struct ink_source_lines lines;
 
     if (tree->root) {
+        ink_source_lines_initialize(&lines);
         ink_syntax_tree_print_node(tree, &lines, tree->root, "",
                                    INK_SYNTAX_TREE_EMPTY, colors);
         ink_syntax_tree_print_walk(tree, &lines, tree->root, "",
                                    INK_SYNTAX_TREE_EMPTY, colors);
+        ink_source_lines_cleanup(&lines);
     }
-
-    ink_line_buffer_destroy(&lines);
 }
 
 /**
@@ -317,8 +271,8 @@ ink_syntax_node_new(struct ink_arena *arena, enum ink_syntax_node_type type,
     }
 
     node->type = type;
-    node->start_offset = start_offset;
-    node->end_offset = end_offset;
+    node->start_offset = (ink_offset_t)start_offset;
+    node->end_offset = (ink_offset_t)end_offset;
     node->lhs = lhs;
     node->rhs = rhs;
     node->seq = seq;
@@ -333,9 +287,141 @@ int ink_syntax_tree_initialize(const struct ink_source *source,
 {
     tree->source = source;
     tree->root = NULL;
+    tree->arena = NULL;
+    tree->flags = 0;
+    tree->parse_bodies = NULL;
     return 0;
 }
 
+/*
+ * Replace lazy blocks that have just been parsed, given in the order they
+ * appear within the block of the file, with the statements parsed from
+ * them, as a full parse would have left them there.
+ */
+static int ink_syntax_tree_splice(struct ink_syntax_tree *tree,
+                                  struct ink_syntax_node **nodes,
+                                  size_t count)
+{
+    struct ink_syntax_node *block = tree->root->seq->nodes[0];
+    const struct ink_syntax_seq *stmts = block->seq;
+    struct ink_syntax_seq *seq;
+    size_t total = stmts->count - count;
+    size_t j = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        total += nodes[i]->seq ? nodes[i]->seq->count : 0;
+    }
+
+    seq = ink_arena_allocate(tree->arena,
+                             sizeof(*seq) + total * sizeof(seq->nodes));
+    if (seq == NULL) {
+        return -INK_E_OOM;
+    }
+
+    seq->count = 0;
+
+    for (size_t i = 0; i < stmts->count; i++) {
+        struct ink_syntax_node *node = stmts->nodes[i];
+
+        if (j < count && node == nodes[j]) {
+            for (size_t k = 0; node->seq && k < node->seq->count; k++) {
+                seq->nodes[seq->count++] = node->seq->nodes[k];
+            }
+            j++;
+        } else {
+            seq->nodes[seq->count++] = node;
+        }
+    }
+
+    assert(j == count && seq->count == total);
+    block->seq = total > 0 ? seq : NULL;
+    return INK_E_OK;
+}
+
+/**
+ * Make sure that the statements of a block are parsed, parsing them now if
+ * the block is lazy. Once parsed, the statements of a lazy block take its
+ * place within the block of the file, and the node itself becomes an
+ * ordinary block holding them.
+ *
+ * Lazy blocks are found by looking for declarations at the start of lines,
+ * without parsing what comes before them. If a block turns out to end
+ * somewhere other than where a full parse would end it, it is left unparsed
+ * and -INK_E_PARSE_FAIL is returned, and the file must be parsed in full.
+ */
+int ink_syntax_tree_body(struct ink_syntax_tree *tree,
+                         struct ink_syntax_node *node)
+{
+    int rc;
+
+    if (node->type != INK_NODE_LAZY_BLOCK_STMT) {
+        return INK_E_OK;
+    }
+    if (tree->parse_bodies == NULL) {
+        return -INK_E_PARSE_FAIL;
+    }
+
+    rc = tree->parse_bodies(tree, &node, 1);
+    if (rc < 0) {
+        return rc;
+    }
+    return ink_syntax_tree_splice(tree, &node, 1);
+}
+
+/**
+ * Parse every lazy block of a syntax tree, leaving the tree exactly as a
+ * full parse would have. This takes time linear in the number of
+ * statements, where parsing the blocks one at a time with
+ * `ink_syntax_tree_body` would take time quadratic in it.
+ *
+ * If any block fails to parse, none of them is parsed and no error is
+ * reported, so that the file can be parsed in full instead.
+ */
+int ink_syntax_tree_bodies(struct ink_syntax_tree *tree)
+{
+    const struct ink_syntax_seq *stmts;
+    struct ink_syntax_node **nodes;
+    size_t count = 0;
+    int rc;
+
+    if (tree->root == NULL || tree->root->seq == NULL ||
+        tree->root->seq->nodes[0]->seq == NULL) {
+        return INK_E_OK;
+    }
+
+    stmts = tree->root->seq->nodes[0]->seq;
+
+    for (size_t i = 0; i < stmts->count; i++) {
+        if (stmts->nodes[i]->type == INK_NODE_LAZY_BLOCK_STMT) {
+            count++;
+        }
+    }
+    if (count == 0) {
+        return INK_E_OK;
+    }
+    if (tree->parse_bodies == NULL) {
+        return -INK_E_PARSE_FAIL;
+    }
+
+    nodes = platform_mem_alloc(count * sizeof(*nodes));
+    if (nodes == NULL) {
+        return -INK_E_OOM;
+    }
+    for (size_t i = 0, j = 0; i < stmts->count; i++) {
+        if (stmts->nodes[i]->type == INK_NODE_LAZY_BLOCK_STMT) {
+            nodes[j++] = stmts->nodes[i];
+        }
+    }
+
+    rc = tree->parse_bodies(tree, nodes, count);
+    if (rc == INK_E_OK) {
+        rc = ink_syntax_tree_splice(tree, nodes, count);
+    }
+
+    platform_mem_dealloc(nodes, count * sizeof(*nodes));
+    return rc;
+}
+
 /**
  * Destroy syntax tree.
  */
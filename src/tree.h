@@ -8,6 +8,7 @@ extern "C" {
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "common.h"
 #include "source.h"
 #include "vec.h"
 
@@ -50,6 +51,7 @@ struct ink_syntax_node;
     T(NODE_GREATER_EXPR, "LogicalGreaterExpr")                                 \
     T(NODE_GREATER_EQUAL_EXPR, "LogicalGreaterOrEqualExpr")                    \
     T(NODE_KNOT_DECL, "KnotDecl")                                              \
+    T(NODE_LAZY_BLOCK_STMT, "LazyBlockStmt")                                   \
     T(NODE_LESS_EQUAL_EXPR, "LogicalLesserOrEqualExpr")                        \
     T(NODE_LESS_EXPR, "LogicalLesserExpr")                                     \
     T(NODE_LOGIC_EXPR, "LogicExpr")                                            \
@@ -97,13 +99,11 @@ struct ink_syntax_seq {
  *
  * Nodes do not directly store token information, instead opting to reference
  * source positions by index.
- *
- * TODO(Brett): Pack node data to reduce node size?
  */
 struct ink_syntax_node {
     enum ink_syntax_node_type type;
-    size_t start_offset;
-    size_t end_offset;
+    ink_offset_t start_offset;
+    ink_offset_t end_offset;
     struct ink_syntax_node *lhs;
     struct ink_syntax_node *rhs;
     struct ink_syntax_seq *seq;
@@ -114,13 +114,23 @@ struct ink_syntax_node {
  *
  * The syntax tree's memory is arranged for reasonably efficient
  * storage.
+ *
+ * A lazy parse leaves the statements between declarations unparsed, as lazy
+ * blocks. Those are parsed on first access by `parse_bodies`, from `arena`
+ * and with `flags`, which the parser sets. It parses either all of the
+ * blocks it is given or none of them.
  */
 struct ink_syntax_tree {
     const struct ink_source *source;
     struct ink_syntax_node *root;
+    struct ink_arena *arena;
+    int flags;
+    int (*parse_bodies)(struct ink_syntax_tree *tree,
+                        struct ink_syntax_node **nodes, size_t count);
 };
 
-extern const char *ink_syntax_node_type_strz(enum ink_syntax_node_type type);
+extern INK_API const char *
+ink_syntax_node_type_strz(enum ink_syntax_node_type type);
 
 extern struct ink_syntax_node *
 ink_syntax_node_new(struct ink_arena *arena, enum ink_syntax_node_type type,
@@ -128,11 +138,14 @@ ink_syntax_node_new(struct ink_arena *arena, enum ink_syntax_node_type type,
                     struct ink_syntax_node *lhs, struct ink_syntax_node *rhs,
                     struct ink_syntax_seq *seq);
 
-extern int ink_syntax_tree_initialize(const struct ink_source *source,
-                                      struct ink_syntax_tree *tree);
-extern void ink_syntax_tree_cleanup(struct ink_syntax_tree *tree);
-extern void ink_syntax_tree_print(const struct ink_syntax_tree *tree,
-                                  bool colors);
+extern INK_API int ink_syntax_tree_initialize(const struct ink_source *source,
+                                              struct ink_syntax_tree *tree);
+extern INK_API void ink_syntax_tree_cleanup(struct ink_syntax_tree *tree);
+extern INK_API int ink_syntax_tree_body(struct ink_syntax_tree *tree,
+                                        struct ink_syntax_node *node);
+extern INK_API int ink_syntax_tree_bodies(struct ink_syntax_tree *tree);
+extern INK_API void ink_syntax_tree_print(const struct ink_syntax_tree *tree,
+                                          bool colors);
 
 #ifdef __cplusplus
 }
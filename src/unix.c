@@ -1,11 +1,25 @@
+#define _DEFAULT_SOURCE
+
 #include <assert.h>
+#include <stdbool.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "unix.h"
 
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#define UNIX_READ_SIZE_MIN 65536
+
 int unix_load_file(const char *filename, unsigned char **bytes, size_t *length)
 {
     int fd;
@@ -44,6 +58,175 @@ err_file:
     return -1;
 }
 
+/**
+ * Read the entirety of STDIN into a NUL-terminated buffer of bytes.
+ *
+ * The buffer grows geometrically, so the total cost is linear in the size of
+ * the input. If STDIN is redirected from a regular file, its size is used as
+ * the initial capacity; once that is filled, a one-byte read probes for the
+ * end of the input, so the buffer is only grown if the file has grown since.
+ *
+ * Returns -1 if STDIN could not be read, or -2 if memory could not be
+ * allocated.
+ */
+int unix_load_stdin(unsigned char **bytes, size_t *length)
+{
+    struct stat st;
+    ssize_t nread;
+    size_t bufsz = UNIX_READ_SIZE_MIN;
+    size_t buflen = 0;
+    unsigned char *buf, *tmp;
+    unsigned char probe;
+    int rc = -1;
+
+    if (fstat(STDIN_FILENO, &st) == 0 && S_ISREG(st.st_mode) &&
+        (size_t)st.st_size >= bufsz) {
+        bufsz = (size_t)st.st_size + 1;
+    }
+
+    buf = unix_alloc(bufsz);
+    if (buf == NULL)
+        return -2;
+
+    for (;;) {
+        if (buflen + 1 < bufsz) {
+            nread = read(STDIN_FILENO, buf + buflen, bufsz - buflen - 1);
+        } else {
+            nread = read(STDIN_FILENO, &probe, 1);
+        }
+        if (nread == 0)
+            break;
+        if (nread == -1) {
+            if (errno == EINTR)
+                continue;
+
+            goto err_memory;
+        }
+        if (buflen + 1 == bufsz) {
+            tmp = unix_realloc(buf, bufsz * 2);
+            if (tmp == NULL) {
+                rc = -2;
+                goto err_memory;
+            }
+
+            buf = tmp;
+            bufsz *= 2;
+            buf[buflen] = probe;
+        }
+
+        buflen += (size_t)nread;
+    }
+    if (buflen + 1 < bufsz) {
+        tmp = unix_realloc(buf, buflen + 1);
+        if (tmp == NULL) {
+            rc = -2;
+            goto err_memory;
+        }
+
+        buf = tmp;
+    }
+
+    buf[buflen] = '\0';
+    *bytes = buf;
+    *length = buflen;
+    return 0;
+err_memory:
+    unix_dealloc(buf, bufsz);
+    return rc;
+}
+
+/**
+ * Read at most `size` bytes from STDIN, blocking until some are available.
+ *
+ * On success, `*nread` is set to the number of bytes read, which will be zero
+ * once the end of the input is reached.
+ */
+int unix_read_stdin(unsigned char *bytes, size_t size, size_t *nread)
+{
+    ssize_t rc;
+
+    do {
+        rc = read(STDIN_FILENO, bytes, size);
+    } while (rc == -1 && errno == EINTR);
+
+    if (rc == -1)
+        return -1;
+
+    *nread = (size_t)rc;
+    return 0;
+}
+
+/**
+ * Map a file into memory as a read-only, NUL-terminated buffer of bytes.
+ *
+ * The scanner expects a sentinel byte one past the end of the source, which a
+ * plain file mapping cannot guarantee when the file ends on a page boundary.
+ * To provide it, an anonymous region one byte larger than the file is
+ * reserved first and the file is then mapped over the front of it. Bytes past
+ * the end of the file are zero-filled by the kernel, whether they belong to
+ * the file's final page or to the trailing anonymous page.
+ *
+ * Only regular, non-empty files are mapped. Anything else is rejected so
+ * that the caller can fall back to `unix_load_file`.
+ */
+int unix_map_file(const char *filename, unsigned char **bytes, size_t *length)
+{
+    int fd;
+    struct stat st;
+    size_t filesz, mapsz;
+    long pagesz;
+    void *base, *addr;
+
+    pagesz = sysconf(_SC_PAGESIZE);
+    if (pagesz <= 0)
+        return -1;
+
+    fd = open(filename, O_RDONLY);
+    if (fd == -1)
+        return -1;
+    if (fstat(fd, &st) == -1)
+        goto err_file;
+    if (!S_ISREG(st.st_mode) || st.st_size <= 0)
+        goto err_file;
+
+    filesz = (size_t)st.st_size;
+    mapsz = (filesz + (size_t)pagesz) & ~((size_t)pagesz - 1);
+
+    base = mmap(NULL, mapsz, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        goto err_file;
+
+    addr = mmap(base, filesz, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if (addr == MAP_FAILED)
+        goto err_memory;
+
+    /* Sources are scanned front to back exactly once. */
+    madvise(addr, filesz, MADV_SEQUENTIAL);
+
+    *bytes = addr;
+    *length = filesz;
+
+    close(fd);
+    return 0;
+err_memory:
+    munmap(base, mapsz);
+err_file:
+    close(fd);
+    return -1;
+}
+
+/**
+ * Unmap a file previously mapped by `unix_map_file`.
+ */
+void unix_unmap_file(unsigned char *bytes, size_t length)
+{
+    const size_t pagesz = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t mapsz = (length + pagesz) & ~(pagesz - 1);
+
+    assert(bytes != NULL && length > 0);
+    munmap(bytes, mapsz);
+}
+
 /**
  * Request the system allocator for a block of memory.
  */
@@ -72,3 +255,90 @@ void unix_dealloc(void *pointer, size_t size)
     assert(pointer != NULL && size > 0);
     free(pointer);
 }
+
+/**
+ * Return the time elapsed on a monotonic clock, in nanoseconds.
+ */
+uint64_t unix_clock_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * Return the number of processors currently online, or one if that cannot
+ * be determined.
+ */
+size_t unix_cpu_count(void)
+{
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (size_t)count : 1;
+}
+
+struct unix_task_thread {
+    pthread_t thread;
+    unix_task_fn *task;
+    void *context;
+    size_t index;
+};
+
+static void *unix_task_main(void *arg)
+{
+    struct unix_task_thread *thread = arg;
+
+    thread->task(thread->context, thread->index);
+    return NULL;
+}
+
+/**
+ * Run `count` tasks in parallel and wait for all of them to finish.
+ *
+ * Task zero runs on the calling thread. A task whose thread cannot be
+ * created also runs on the calling thread, so every task runs exactly once
+ * whatever the system's limits.
+ */
+int unix_run_tasks(unix_task_fn *task, void *context, size_t count)
+{
+    bool *started;
+    struct unix_task_thread *threads;
+
+    if (count <= 1) {
+        if (count == 1)
+            task(context, 0);
+
+        return 0;
+    }
+
+    threads = unix_alloc(count * sizeof(*threads));
+    if (threads == NULL)
+        return -1;
+
+    started = unix_alloc(count * sizeof(*started));
+    if (started == NULL) {
+        unix_dealloc(threads, count * sizeof(*threads));
+        return -1;
+    }
+    for (size_t i = 1; i < count; i++) {
+        threads[i].task = task;
+        threads[i].context = context;
+        threads[i].index = i;
+        started[i] = pthread_create(&threads[i].thread, NULL, unix_task_main,
+                                    &threads[i]) == 0;
+        if (!started[i])
+            task(context, i);
+    }
+
+    task(context, 0);
+
+    for (size_t i = 1; i < count; i++) {
+        if (started[i])
+            pthread_join(threads[i].thread, NULL);
+    }
+
+    unix_dealloc(started, count * sizeof(*started));
+    unix_dealloc(threads, count * sizeof(*threads));
+    return 0;
+}
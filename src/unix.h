@@ -6,12 +6,23 @@ extern "C" {
 #endif
 
 #include <stddef.h>
+#include <stdint.h>
+
+typedef void unix_task_fn(void *context, size_t index);
 
 extern int unix_load_file(const char *filename, unsigned char **bytes,
                           size_t *length);
+extern int unix_load_stdin(unsigned char **bytes, size_t *length);
+extern int unix_read_stdin(unsigned char *bytes, size_t size, size_t *nread);
+extern int unix_map_file(const char *filename, unsigned char **bytes,
+                         size_t *length);
+extern void unix_unmap_file(unsigned char *bytes, size_t length);
 extern void *unix_alloc(size_t size);
 extern void *unix_realloc(void *address, size_t size);
 extern void unix_dealloc(void *address, size_t size);
+extern uint64_t unix_clock_ns(void);
+extern size_t unix_cpu_count(void);
+extern int unix_run_tasks(unix_task_fn *task, void *context, size_t count);
 
 #ifdef __cplusplus
 }
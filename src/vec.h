@@ -48,7 +48,8 @@ extern "C" {
         const size_t old_capacity = vec->capacity * sizeof(V);                 \
         const size_t new_capacity = count * sizeof(V);                         \
                                                                                \
-        entries = platform_mem_realloc(entries, old_capacity, new_capacity);   \
+        entries =                                                              \
+            (V *)platform_mem_realloc(entries, old_capacity, new_capacity);    \
         if (entries == NULL) {                                                 \
             vec->entries = entries;                                            \
             return -1;                                                         \
@@ -89,7 +90,7 @@ extern "C" {
             new_size = capacity * sizeof(V);                                   \
                                                                                \
             vec->entries =                                                     \
-                platform_mem_realloc(vec->entries, old_size, new_size);        \
+                (V *)platform_mem_realloc(vec->entries, old_size, new_size);   \
             vec->capacity = capacity;                                          \
         }                                                                      \
                                                                                \